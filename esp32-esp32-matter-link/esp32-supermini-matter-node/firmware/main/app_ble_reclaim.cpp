@@ -0,0 +1,150 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include "sdkconfig.h"
+
+#if CONFIG_APP_BLE_RECLAIM
+
+#include <stdio.h>
+#include <esp_bt.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <platform/CHIPDeviceLayer.h>
+#include <platform/internal/BLEManager.h>
+
+#include "app_ble_reclaim.h"
+
+static const char *TAG = "app_ble";
+
+// The NimBLE teardown finishes asynchronously; give up waiting for kBLEDeinitialized after this
+#define BLE_RECLAIM_TIMEOUT_MS 3000
+
+typedef enum {
+    BLE_STATE_ACTIVE = 0,
+    BLE_STATE_RECLAIMING,
+    BLE_STATE_RECLAIMED,
+} ble_state_t;
+
+typedef struct {
+    size_t free_before;
+    size_t free_after;
+    size_t largest_before;
+    size_t largest_after;
+    size_t internal_before;
+    size_t internal_after;
+} ble_heap_report_t;
+
+// Only touched on the Matter thread
+static ble_state_t s_state = BLE_STATE_ACTIVE;
+static app_ble_reclaim_cb_t s_done_cb = NULL;
+static ble_heap_report_t s_report;
+static bool s_have_report = false;
+
+static void ble_reclaim_finish()
+{
+    if (s_state != BLE_STATE_RECLAIMING) {
+        return;
+    }
+
+    // CHIP stops the NimBLE host; make sure the controller's heap is back as well
+    if (esp_bt_controller_get_status() == ESP_BT_CONTROLLER_STATUS_ENABLED) {
+        esp_bt_controller_disable();
+    }
+    if (esp_bt_controller_get_status() == ESP_BT_CONTROLLER_STATUS_INITED) {
+        esp_bt_controller_deinit();
+    }
+
+    s_report.free_after = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    s_report.largest_after = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    s_report.internal_after = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    s_have_report = true;
+    s_state = BLE_STATE_RECLAIMED;
+
+    int gained = (int)s_report.free_after - (int)s_report.free_before;
+    ESP_LOGI(TAG, "BLE reclaimed: free %u -> %u (%+d), largest block %u -> %u", (unsigned)s_report.free_before,
+             (unsigned)s_report.free_after, gained, (unsigned)s_report.largest_before,
+             (unsigned)s_report.largest_after);
+
+    if (s_done_cb) {
+        s_done_cb(gained);
+    }
+}
+
+static void ble_reclaim_timeout(chip::System::Layer *layer, void *arg)
+{
+    ESP_LOGW(TAG, "No kBLEDeinitialized after %dms, finishing reclaim anyway", BLE_RECLAIM_TIMEOUT_MS);
+    ble_reclaim_finish();
+}
+
+esp_err_t app_ble_reclaim_start(app_ble_reclaim_cb_t done_cb)
+{
+    if (s_state != BLE_STATE_ACTIVE) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_done_cb = done_cb;
+    s_report.free_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    s_report.largest_before = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    s_report.internal_before = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    s_state = BLE_STATE_RECLAIMING;
+
+    ESP_LOGI(TAG, "Commissioned - shutting BLE down (free heap %u)", (unsigned)s_report.free_before);
+    chip::DeviceLayer::ConnectivityMgr().SetBLEAdvertisingEnabled(false);
+    chip::DeviceLayer::Internal::BLEMgr().Shutdown();
+
+    chip::DeviceLayer::SystemLayer().StartTimer(chip::System::Clock::Milliseconds32(BLE_RECLAIM_TIMEOUT_MS),
+                                                ble_reclaim_timeout, nullptr);
+    return ESP_OK;
+}
+
+void app_ble_reclaim_on_deinitialized(void)
+{
+    chip::DeviceLayer::SystemLayer().CancelTimer(ble_reclaim_timeout, nullptr);
+    ble_reclaim_finish();
+}
+
+esp_err_t app_ble_restore(void)
+{
+    if (s_state == BLE_STATE_ACTIVE) {
+        return ESP_OK;
+    }
+    if (s_state == BLE_STATE_RECLAIMING) {
+        chip::DeviceLayer::SystemLayer().CancelTimer(ble_reclaim_timeout, nullptr);
+    }
+
+    // BLEManager::Init() brings the controller and NimBLE host back up
+    CHIP_ERROR err = chip::DeviceLayer::Internal::BLEMgr().Init();
+    if (err != CHIP_NO_ERROR) {
+        ESP_LOGE(TAG, "Failed to re-initialize BLE, err:%" CHIP_ERROR_FORMAT, err.Format());
+        return ESP_FAIL;
+    }
+    s_state = BLE_STATE_ACTIVE;
+    ESP_LOGI(TAG, "BLE re-initialized (free heap %u)", (unsigned)heap_caps_get_free_size(MALLOC_CAP_8BIT));
+    return ESP_OK;
+}
+
+bool app_ble_is_reclaimed(void)
+{
+    return s_state == BLE_STATE_RECLAIMED;
+}
+
+void app_ble_reclaim_print(void)
+{
+    if (!s_have_report) {
+        printf("BLE reclaim: not run (BLE %s)\n", s_state == BLE_STATE_ACTIVE ? "active" : "shutting down");
+        return;
+    }
+    printf("BLE reclaim (%s now):\n", s_state == BLE_STATE_RECLAIMED ? "BLE off" : "BLE on");
+    printf("  free      %7u -> %7u (%+d)\n", (unsigned)s_report.free_before, (unsigned)s_report.free_after,
+           (int)s_report.free_after - (int)s_report.free_before);
+    printf("  internal  %7u -> %7u (%+d)\n", (unsigned)s_report.internal_before, (unsigned)s_report.internal_after,
+           (int)s_report.internal_after - (int)s_report.internal_before);
+    printf("  largest   %7u -> %7u\n", (unsigned)s_report.largest_before, (unsigned)s_report.largest_after);
+}
+
+#endif // CONFIG_APP_BLE_RECLAIM
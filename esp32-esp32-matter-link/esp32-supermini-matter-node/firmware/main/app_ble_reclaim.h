@@ -0,0 +1,42 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Post-commissioning BLE memory reclaim.
+//
+// BLE is only needed to commission the node. Once commissioned, the CHIPoBLE
+// service, the NimBLE host and the controller are shut down and their heap is
+// returned. The controller's static memory is NOT released (esp_bt_mem_release
+// is one-way), so BLE can be brought back when a commissioning window reopens.
+#pragma once
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <esp_err.h>
+
+/** Called on the Matter thread once BLE is down, with the heap gained in bytes
+ *  (negative if the heap shrank meanwhile). */
+typedef void (*app_ble_reclaim_cb_t)(int gained_bytes);
+
+/** Start tearing BLE down. Must be called on the Matter thread (e.g. from the
+ *  esp_matter event callback). Completion is reported through `done_cb`. */
+esp_err_t app_ble_reclaim_start(app_ble_reclaim_cb_t done_cb);
+
+/** Forward kBLEDeinitialized so the reclaim can finish without waiting for its timeout. */
+void app_ble_reclaim_on_deinitialized(void);
+
+/** Bring BLE back up for a new commissioning window. Matter thread only.
+ *
+ * @return ESP_OK if BLE was reclaimed and is being re-initialized, or was never reclaimed.
+ */
+esp_err_t app_ble_restore(void);
+
+/** True while BLE is torn down. */
+bool app_ble_is_reclaimed(void);
+
+/** Print the heap numbers measured around the last reclaim. */
+void app_ble_reclaim_print(void);
@@ -0,0 +1,312 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <esp_console.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_matter.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "sdkconfig.h"
+
+#include "app_console.h"
+#include "app_ble_reclaim.h"
+#include "app_event_bus.h"
+#include "app_history.h"
+#include "app_latency_wd.h"
+#include "app_link_stats.h"
+#include "app_matter_stats.h"
+#include "app_power.h"
+#include "app_presence.h"
+#include "app_trace.h"
+#if CONFIG_APP_SHTC3
+#include "i2c_bus.h"
+#include "shtc3.h"
+#endif
+
+static const char *TAG = "app_console";
+
+#define CONSOLE_MAX_TASKS 24
+
+// ===== factory_reset =====
+// Simple factory reset trigger - will reset after 10 seconds
+static void trigger_factory_reset_timer(void)
+{
+    ESP_LOGW(TAG, "=== FACTORY RESET TRIGGERED ===");
+    ESP_LOGW(TAG, "Device will reset in 10 seconds...");
+    ESP_LOGW(TAG, "Unplug power now if you want to cancel!");
+
+    vTaskDelay(pdMS_TO_TICKS(10000)); // Wait 10 seconds
+
+    ESP_LOGI(TAG, "Starting factory reset NOW");
+    esp_matter::factory_reset();
+}
+
+static int factory_reset_cmd(int argc, char **argv)
+{
+    if (argc == 2 && strcmp(argv[1], "confirm") == 0) {
+        // Start the reset in a new task
+        xTaskCreate([](void*){ trigger_factory_reset_timer(); vTaskDelete(NULL); },
+                   "factory_reset", 4096, NULL, 5, NULL);
+        return 0;
+    } else {
+        printf("Usage: factory_reset confirm\n");
+        printf("WARNING: This will erase all pairing data!\n");
+        return 1;
+    }
+}
+
+// ===== tasks =====
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY && CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+// Run-time counters from the previous call, so CPU% can be shown for the interval too
+static struct {
+    TaskHandle_t handle;
+    configRUN_TIME_COUNTER_TYPE runtime;
+} s_prev_tasks[CONSOLE_MAX_TASKS];
+static int s_prev_task_count = 0;
+static configRUN_TIME_COUNTER_TYPE s_prev_total = 0;
+
+static configRUN_TIME_COUNTER_TYPE prev_runtime(TaskHandle_t handle)
+{
+    for (int i = 0; i < s_prev_task_count; i++) {
+        if (s_prev_tasks[i].handle == handle) {
+            return s_prev_tasks[i].runtime;
+        }
+    }
+    return 0;
+}
+
+static int tasks_cmd(int argc, char **argv)
+{
+    static TaskStatus_t status[CONSOLE_MAX_TASKS];
+    configRUN_TIME_COUNTER_TYPE total = 0;
+
+    UBaseType_t count = uxTaskGetSystemState(status, CONSOLE_MAX_TASKS, &total);
+    if (count == 0) {
+        printf("More than %d tasks, increase CONSOLE_MAX_TASKS\n", CONSOLE_MAX_TASKS);
+        return 1;
+    }
+
+    configRUN_TIME_COUNTER_TYPE interval = total - s_prev_total;
+    printf("%-16s %4s %5s %7s %7s %10s\n", "task", "prio", "state", "cpu%", "recent%", "stack_free");
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t *t = &status[i];
+        configRUN_TIME_COUNTER_TYPE delta = t->ulRunTimeCounter - prev_runtime(t->xHandle);
+        static const char states[] = "XRBSD";  // running, ready, blocked, suspended, deleted
+        printf("%-16s %4u %5c %7.1f %7.1f %10" PRIu32 "\n", t->pcTaskName, (unsigned)t->uxCurrentPriority,
+               (unsigned)t->eCurrentState < sizeof(states) - 1 ? states[t->eCurrentState] : '?',
+               total ? 100.0 * t->ulRunTimeCounter / total : 0.0,
+               interval ? 100.0 * delta / interval : 0.0,
+               (uint32_t)t->usStackHighWaterMark);
+    }
+    printf("cpu%% since boot, recent%% since the previous 'tasks'; stack_free is the high-water mark in bytes\n");
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        s_prev_tasks[i].handle = status[i].xHandle;
+        s_prev_tasks[i].runtime = status[i].ulRunTimeCounter;
+    }
+    s_prev_task_count = count;
+    s_prev_total = total;
+    return 0;
+}
+#else
+static int tasks_cmd(int argc, char **argv)
+{
+    printf("Enable CONFIG_FREERTOS_USE_TRACE_FACILITY and CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS\n");
+    return 1;
+}
+#endif
+
+// ===== heap =====
+static void print_heap_caps(const char *name, uint32_t caps)
+{
+    printf("%-9s %9u %9u %9u\n", name, (unsigned)heap_caps_get_free_size(caps),
+           (unsigned)heap_caps_get_minimum_free_size(caps), (unsigned)heap_caps_get_largest_free_block(caps));
+}
+
+static int heap_cmd(int argc, char **argv)
+{
+    printf("%-9s %9s %9s %9s\n", "heap", "free", "min_free", "largest");
+    print_heap_caps("default", MALLOC_CAP_DEFAULT);
+    print_heap_caps("internal", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    print_heap_caps("dma", MALLOC_CAP_DMA);
+#if CONFIG_APP_BLE_RECLAIM
+    app_ble_reclaim_print();
+#endif
+    return 0;
+}
+
+// ===== link =====
+static int link_cmd(int argc, char **argv)
+{
+    if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+        app_link_stats_reset();
+        return 0;
+    }
+    app_link_stats_print();
+    return 0;
+}
+
+// ===== matter =====
+static int matter_cmd(int argc, char **argv)
+{
+    if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+        app_matter_stats_reset();
+        return 0;
+    }
+    app_matter_stats_print();
+    return 0;
+}
+
+// ===== wd =====
+static int wd_cmd(int argc, char **argv)
+{
+    if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+        app_wd_reset();
+        return 0;
+    }
+    app_wd_print();
+    return 0;
+}
+
+// ===== events =====
+static int events_cmd(int argc, char **argv)
+{
+    if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+        app_event_bus_reset_stats();
+        return 0;
+    }
+    app_event_bus_print_stats();
+    return 0;
+}
+
+// ===== latency =====
+static int latency_cmd(int argc, char **argv)
+{
+    if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+        app_trace_reset();
+        return 0;
+    }
+    if (argc == 2 && strcmp(argv[1], "last") == 0) {
+        app_trace_print_last();
+        return 0;
+    }
+    app_trace_print_report(argc == 2 ? atoi(argv[1]) : 0);
+    return 0;
+}
+
+// ===== history =====
+static int history_cmd(int argc, char **argv)
+{
+    if (argc >= 2 && strcmp(argv[1], "stats") == 0) {
+        app_history_print_stats();
+        return 0;
+    }
+    if (argc >= 2 && strcmp(argv[1], "dump") == 0) {
+        app_history_dump(argc == 3 ? atoi(argv[2]) : 60);
+        return 0;
+    }
+    app_history_print(argc == 2 ? atoi(argv[1]) : 0);
+    return 0;
+}
+
+// ===== presence =====
+static int presence_cmd(int argc, char **argv)
+{
+    app_presence_print();
+    return 0;
+}
+
+#if CONFIG_APP_SHTC3
+// ===== i2c =====
+static int i2c_cmd(int argc, char **argv)
+{
+    i2c_bus_print();
+    printf("\n");
+    shtc3_sensor_print();
+    return 0;
+}
+#endif
+
+#if CONFIG_APP_IDLE_SLEEP
+// ===== power =====
+static int power_cmd(int argc, char **argv)
+{
+    app_power_print();
+    return 0;
+}
+#endif
+
+static const esp_console_cmd_t s_commands[] = {
+    { .command = "factory_reset", .help = "Perform factory reset (use 'factory_reset confirm')",
+      .hint = NULL, .func = &factory_reset_cmd },
+    { .command = "tasks", .help = "Per-task CPU time and stack high-water mark",
+      .hint = NULL, .func = &tasks_cmd },
+    { .command = "heap", .help = "Free, minimum free and largest free block",
+      .hint = NULL, .func = &heap_cmd },
+    { .command = "link", .help = "UART frame counts, errors and RTT histogram ('link reset' to clear)",
+      .hint = NULL, .func = &link_cmd },
+    { .command = "matter", .help = "Attribute report/update counts per endpoint ('matter reset' to clear)",
+      .hint = NULL, .func = &matter_cmd },
+    { .command = "wd", .help = "Scheduling gaps and stalls of the watched paths ('wd reset' to clear)",
+      .hint = NULL, .func = &wd_cmd },
+    { .command = "events", .help = "Show per-event queue/handler latency (use 'events reset' to clear)",
+      .hint = NULL, .func = &events_cmd },
+    { .command = "latency", .help = "Trigger latency percentiles ('latency [N]', 'latency last', 'latency reset')",
+      .hint = NULL, .func = &latency_cmd },
+    { .command = "history", .help = "Sensor history summary ('history [min]', 'history dump [min]', 'history stats')",
+      .hint = NULL, .func = &history_cmd },
+    { .command = "presence", .help = "Visitor presence state, confidence and decision latency",
+      .hint = NULL, .func = &presence_cmd },
+#if CONFIG_APP_SHTC3
+    { .command = "i2c", .help = "I2C bus time and queue wait per device, SHTC3 samples and measured conversion times",
+      .hint = NULL, .func = &i2c_cmd },
+#endif
+#if CONFIG_APP_IDLE_SLEEP
+    { .command = "power", .help = "Idle light sleep: time idle, wake -> occupancy and wake -> link latency, PM locks",
+      .hint = NULL, .func = &power_cmd },
+#endif
+};
+
+esp_err_t app_console_start(void)
+{
+    esp_console_repl_t *repl = NULL;
+    esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
+
+    // Same device as the log; the S3 link may take UART0 when the console is elsewhere
+#if CONFIG_ESP_CONSOLE_UART_DEFAULT || CONFIG_ESP_CONSOLE_UART_CUSTOM
+    esp_console_dev_uart_config_t dev_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
+    esp_err_t err = esp_console_new_repl_uart(&dev_config, &repl_config, &repl);
+#elif CONFIG_ESP_CONSOLE_USB_SERIAL_JTAG
+    esp_console_dev_usb_serial_jtag_config_t dev_config = ESP_CONSOLE_DEV_USB_SERIAL_JTAG_CONFIG_DEFAULT();
+    esp_err_t err = esp_console_new_repl_usb_serial_jtag(&dev_config, &repl_config, &repl);
+#elif CONFIG_ESP_CONSOLE_USB_CDC
+    esp_console_dev_usb_cdc_config_t dev_config = ESP_CONSOLE_DEV_CDC_CONFIG_DEFAULT();
+    esp_err_t err = esp_console_new_repl_usb_cdc(&dev_config, &repl_config, &repl);
+#else
+    esp_err_t err = ESP_ERR_NOT_SUPPORTED;  // CONFIG_ESP_CONSOLE_NONE
+#endif
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    for (size_t i = 0; i < sizeof(s_commands) / sizeof(s_commands[0]); i++) {
+        err = esp_console_cmd_register(&s_commands[i]);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to register '%s': %s", s_commands[i].command, esp_err_to_name(err));
+            return err;
+        }
+    }
+
+    return esp_console_start_repl(repl);
+}
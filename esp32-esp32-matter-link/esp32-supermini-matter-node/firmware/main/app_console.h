@@ -0,0 +1,25 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#pragma once
+
+#include <esp_err.h>
+
+/** Start the console REPL on the configured console device (UART, USB
+ *  Serial/JTAG or USB CDC; ESP_ERR_NOT_SUPPORTED with the console disabled)
+ *
+ * Registers the maintenance and diagnostics commands:
+ * factory_reset, tasks, heap, link, matter, wd, events, latency, history
+ * and presence, plus power with idle sleep and i2c with the SHTC3 built.
+ * Every diagnostics command only reads counters, so all are safe to run
+ * on a production device.
+ *
+ * @return ESP_OK on success.
+ * @return error in case of failure.
+ */
+esp_err_t app_console_start(void);
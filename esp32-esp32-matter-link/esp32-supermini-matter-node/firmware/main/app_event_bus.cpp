@@ -0,0 +1,202 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+
+#include "app_event_bus.h"
+
+#define APP_EVENT_QUEUE_LEN     32
+#define APP_EVENT_TASK_STACK    4096
+#define APP_EVENT_TASK_PRIO     10
+
+static const char *TAG = "app_event_bus";
+
+static QueueHandle_t s_queue = NULL;
+static app_event_handler_t s_handlers[APP_EVT_COUNT] = {};
+static app_event_stats_t s_stats[APP_EVT_COUNT] = {};
+static volatile app_event_heartbeat_t s_heartbeat = NULL;
+static volatile uint32_t s_heartbeat_ms = APP_EVENT_HEARTBEAT_MS;
+// Stats are written by the dispatcher and by posters (drops), read by the console
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *s_type_names[APP_EVT_COUNT] = {
+    "trigger_on",
+    "trigger_off",
+    "pulse_end",
+    "mode_tap",
+    "mode_debounced",
+    "mode_cleanup",
+    "mode_report",
+    "link_frame",
+    "link_crc_error",
+    "commissioned",
+    "fabric_removed",
+};
+
+const char *app_event_type_name(app_event_type_t type)
+{
+    if ((unsigned)type >= APP_EVT_COUNT) {
+        return "unknown";
+    }
+    return s_type_names[type];
+}
+
+static void app_event_dispatch_task(void *arg)
+{
+    app_event_t event;
+
+    ESP_LOGI(TAG, "Event dispatcher started");
+
+    while (1) {
+        BaseType_t got = xQueueReceive(s_queue, &event, pdMS_TO_TICKS(s_heartbeat_ms));
+        app_event_heartbeat_t heartbeat = s_heartbeat;
+        if (heartbeat) {
+            heartbeat();
+        }
+        if (got != pdTRUE) {
+            continue;
+        }
+
+        int64_t start = esp_timer_get_time();
+        app_event_handler_t handler = s_handlers[event.type];
+        if (handler) {
+            handler(&event);
+        } else {
+            ESP_LOGW(TAG, "No handler for event %s", app_event_type_name(event.type));
+        }
+        int64_t end = esp_timer_get_time();
+
+        uint32_t queue_us = (uint32_t)(start - event.posted_us);
+        uint32_t handler_us = (uint32_t)(end - start);
+
+        portENTER_CRITICAL(&s_stats_lock);
+        app_event_stats_t *stats = &s_stats[event.type];
+        stats->count++;
+        stats->queue_total_us += queue_us;
+        stats->handler_total_us += handler_us;
+        if (queue_us > stats->queue_max_us) {
+            stats->queue_max_us = queue_us;
+        }
+        if (handler_us > stats->handler_max_us) {
+            stats->handler_max_us = handler_us;
+        }
+        portEXIT_CRITICAL(&s_stats_lock);
+    }
+}
+
+esp_err_t app_event_bus_init(void)
+{
+    if (s_queue) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_queue = xQueueCreate(APP_EVENT_QUEUE_LEN, sizeof(app_event_t));
+    if (!s_queue) {
+        ESP_LOGE(TAG, "Failed to create event queue");
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (xTaskCreate(app_event_dispatch_task, "app_events", APP_EVENT_TASK_STACK, NULL,
+                    APP_EVENT_TASK_PRIO, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create event dispatcher task");
+        vQueueDelete(s_queue);
+        s_queue = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t app_event_bus_register(app_event_type_t type, app_event_handler_t handler)
+{
+    if ((unsigned)type >= APP_EVT_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_handlers[type] = handler;
+    return ESP_OK;
+}
+
+void app_event_bus_set_heartbeat(app_event_heartbeat_t hook)
+{
+    s_heartbeat = hook;
+}
+
+void app_event_bus_set_heartbeat_period(uint32_t period_ms)
+{
+    s_heartbeat_ms = period_ms;
+}
+
+esp_err_t app_event_post(app_event_t *event)
+{
+    if (!s_queue) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if ((unsigned)event->type >= APP_EVT_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    event->posted_us = esp_timer_get_time();
+    if (xQueueSend(s_queue, event, 0) != pdTRUE) {
+        portENTER_CRITICAL(&s_stats_lock);
+        s_stats[event->type].dropped++;
+        portEXIT_CRITICAL(&s_stats_lock);
+        ESP_LOGW(TAG, "Event queue full, dropped %s", app_event_type_name(event->type));
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t app_event_post_value(app_event_type_t type, int32_t value)
+{
+    app_event_t event = {};
+    event.type = type;
+    event.data.value = value;
+    return app_event_post(&event);
+}
+
+esp_err_t app_event_bus_get_stats(app_event_type_t type, app_event_stats_t *stats)
+{
+    if ((unsigned)type >= APP_EVT_COUNT || !stats) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&s_stats_lock);
+    *stats = s_stats[type];
+    portEXIT_CRITICAL(&s_stats_lock);
+    return ESP_OK;
+}
+
+void app_event_bus_reset_stats(void)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    memset(s_stats, 0, sizeof(s_stats));
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+void app_event_bus_print_stats(void)
+{
+    printf("%-16s %8s %8s %10s %10s %10s %10s\n",
+           "event", "count", "dropped", "q_avg_us", "q_max_us", "h_avg_us", "h_max_us");
+    for (int i = 0; i < APP_EVT_COUNT; i++) {
+        app_event_stats_t stats;
+        app_event_bus_get_stats((app_event_type_t)i, &stats);
+        if (stats.count == 0 && stats.dropped == 0) {
+            continue;
+        }
+        uint32_t q_avg = stats.count ? (uint32_t)(stats.queue_total_us / stats.count) : 0;
+        uint32_t h_avg = stats.count ? (uint32_t)(stats.handler_total_us / stats.count) : 0;
+        printf("%-16s %8" PRIu32 " %8" PRIu32 " %10" PRIu32 " %10" PRIu32 " %10" PRIu32 " %10" PRIu32 "\n",
+               app_event_type_name((app_event_type_t)i), stats.count, stats.dropped,
+               q_avg, stats.queue_max_us, h_avg, stats.handler_max_us);
+    }
+}
@@ -0,0 +1,119 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Single-consumer event bus for the C3 application.
+//
+// Every source (Matter callbacks, UART RX task, esp_timer callbacks) posts a
+// small typed event; all handlers run in one dispatcher task.
+// Posting never blocks, so callbacks stay short and never do slow work.
+#pragma once
+
+#include <esp_err.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    APP_EVT_TRIGGER_ON = 0,     // HomeKit turned the trigger plug ON
+    APP_EVT_TRIGGER_OFF,        // HomeKit turned the trigger plug OFF
+    APP_EVT_PULSE_END,          // Pulse timer expired (GPIO already LOW)
+    APP_EVT_MODE_TAP,           // HomeKit turned a mode plug ON (value = mode)
+    APP_EVT_MODE_DEBOUNCED,     // Debounce window after the last tap elapsed
+    APP_EVT_MODE_CLEANUP,       // Safety cleanup window elapsed
+    APP_EVT_MODE_REPORT,        // Next step of the exclusive mode report is due
+    APP_EVT_LINK_FRAME,         // Valid frame received from the S3 (frame)
+    APP_EVT_LINK_CRC_ERROR,     // Frame with a bad CRC received from the S3
+    APP_EVT_COMMISSIONED,       // Matter commissioning complete
+    APP_EVT_FABRIC_REMOVED,     // Matter fabric removed
+    APP_EVT_COUNT
+} app_event_type_t;
+
+// Largest frame payload carried inline in an event. Frames from the S3 carry
+// at most a few bytes today; larger ones are rejected by the link layer.
+#define APP_EVENT_MAX_PAYLOAD 16
+
+// Default longest wait without an event before the heartbeat runs
+#define APP_EVENT_HEARTBEAT_MS 100
+
+typedef struct {
+    app_event_type_t type;
+    // esp_timer_get_time() when posted, filled in by the bus
+    int64_t posted_us;
+    union {
+        int32_t value;
+        struct {
+            uint8_t cmd;
+            uint8_t len;
+            uint8_t payload[APP_EVENT_MAX_PAYLOAD];
+        } frame;
+    } data;
+} app_event_t;
+
+typedef void (*app_event_handler_t)(const app_event_t *event);
+
+typedef struct {
+    uint32_t count;             // events dispatched
+    uint32_t dropped;           // events lost because the queue was full
+    uint32_t queue_max_us;      // worst post -> dispatch delay
+    uint64_t queue_total_us;
+    uint32_t handler_max_us;    // worst handler run time
+    uint64_t handler_total_us;
+} app_event_stats_t;
+
+/** Create the event queue and start the dispatcher task.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_STATE if already initialized.
+ * @return ESP_ERR_NO_MEM if the queue or task could not be created.
+ */
+esp_err_t app_event_bus_init(void);
+
+/** Register the handler for an event type. One handler per type; the last
+ *  registration wins. Must be called before events of that type are posted.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_ARG if type is out of range.
+ */
+esp_err_t app_event_bus_register(app_event_type_t type, app_event_handler_t handler);
+
+/** Post an event from task context. Never blocks.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_STATE if the bus is not initialized.
+ * @return ESP_ERR_NO_MEM if the queue is full (counted as dropped).
+ */
+esp_err_t app_event_post(app_event_t *event);
+
+/** Convenience wrapper for events that carry at most one integer. */
+esp_err_t app_event_post_value(app_event_type_t type, int32_t value);
+
+/** Copy the latency statistics of one event type.
+ *
+ * @return ESP_OK on success.
+ * @return ESP_ERR_INVALID_ARG if type is out of range or stats is NULL.
+ */
+esp_err_t app_event_bus_get_stats(app_event_type_t type, app_event_stats_t *stats);
+
+/** Clear the statistics of all event types. */
+void app_event_bus_reset_stats(void);
+
+/** Called by the dispatcher after every event, and at least every heartbeat
+ *  period while no events arrive (e.g. to check in with a watchdog). */
+typedef void (*app_event_heartbeat_t)(void);
+
+/** Install the dispatcher heartbeat (NULL to remove). */
+void app_event_bus_set_heartbeat(app_event_heartbeat_t hook);
+
+/** Change the heartbeat period (APP_EVENT_HEARTBEAT_MS by default), e.g.
+ *  stretch it while the node sleeps. Takes effect after the current wait. */
+void app_event_bus_set_heartbeat_period(uint32_t period_ms);
+
+/** Print per-type counts and latencies to stdout. */
+void app_event_bus_print_stats(void);
+
+/** Short printable name of an event type. */
+const char *app_event_type_name(app_event_type_t type);
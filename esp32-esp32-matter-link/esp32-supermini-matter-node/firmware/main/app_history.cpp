@@ -0,0 +1,383 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <esp_log.h>
+#include <esp_partition.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+#include "app_history.h"
+
+#define HISTORY_PARTITION_NAME      "history"
+#define HISTORY_PARTITION_SUBTYPE   0x40
+#define HISTORY_WALL_CLOCK_VALID    1700000000  // Anything earlier means the clock was never set
+
+#define HISTORY_TASK_STACK          3072
+#define HISTORY_TASK_PRIO           2           // Below everything user-visible; a sector erase takes ~50 ms
+
+static const char *TAG = "app_history";
+
+static const esp_partition_t *s_part = NULL;
+static app_history_log_t s_log;
+static uint32_t s_last_query_us = 0;
+static uint32_t s_skipped = 0;          // Minutes with nothing to log
+static int64_t s_clock_base = 0;        // Fallback clock: base + uptime
+static SemaphoreHandle_t s_lock = NULL; // s_log and the counters above
+
+static TaskHandle_t s_task = NULL;
+static esp_timer_handle_t s_timer = NULL;
+
+// Latest values, written from any task
+static portMUX_TYPE s_latest_lock = portMUX_INITIALIZER_UNLOCKED;
+static int16_t s_temperature = APP_HISTORY_TEMP_INVALID;
+static uint16_t s_humidity = APP_HISTORY_HUM_INVALID;
+static bool s_occupied_now = false;
+static bool s_occupied_latch = false;
+static bool s_has_source = false;       // Some source has reported since boot
+
+static int flash_read(void *ctx, uint32_t offset, void *dst, size_t len)
+{
+    return esp_partition_read(s_part, offset, dst, len);
+}
+
+static int flash_write(void *ctx, uint32_t offset, const void *src, size_t len)
+{
+    return esp_partition_write(s_part, offset, src, len);
+}
+
+static int flash_erase(void *ctx, uint32_t offset, size_t len)
+{
+    return esp_partition_erase_range(s_part, offset, len);
+}
+
+static uint32_t history_now(void)
+{
+    time_t now = time(NULL);
+    if (now >= HISTORY_WALL_CLOCK_VALID) {
+        return (uint32_t)now;
+    }
+    return (uint32_t)(s_clock_base + esp_timer_get_time() / 1000000);
+}
+
+static void history_append(void)
+{
+    app_history_sample_t sample;
+    portENTER_CRITICAL(&s_latest_lock);
+    bool has_source = s_has_source;
+    sample.temperature = s_temperature;
+    sample.humidity = s_humidity;
+    sample.occupied = s_occupied_latch;
+    s_occupied_latch = s_occupied_now;
+    portEXIT_CRITICAL(&s_latest_lock);
+    sample.ts = history_now();
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    // No sensor has said anything yet: a record of nulls is not worth the flash
+    if (!has_source) {
+        s_skipped++;
+        xSemaphoreGive(s_lock);
+        return;
+    }
+    esp_err_t err = (esp_err_t)app_history_log_append(&s_log, &sample);
+    xSemaphoreGive(s_lock);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Append failed: %s", esp_err_to_name(err));
+    }
+}
+
+static void history_task(void *arg)
+{
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        history_append();
+    }
+}
+
+static void history_timer_cb(void *arg)
+{
+    xTaskNotifyGive(s_task);
+}
+
+esp_err_t app_history_init(void)
+{
+    if (s_part) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)HISTORY_PARTITION_SUBTYPE,
+                                      HISTORY_PARTITION_NAME);
+    if (!s_part) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    uint32_t sector_count = s_part->size / APP_HISTORY_LOG_SECTOR_SIZE;
+    if (sector_count < 2) {
+        s_part = NULL;
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    s_lock = xSemaphoreCreateMutex();
+    if (!s_lock) {
+        s_part = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    const app_history_flash_t flash = { flash_read, flash_write, flash_erase, NULL, sector_count };
+    esp_err_t err = (esp_err_t)app_history_log_open(&s_log, &flash, APP_HISTORY_PERIOD_S);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Recovery failed: %s", esp_err_to_name(err));
+        vSemaphoreDelete(s_lock);
+        s_lock = NULL;
+        s_part = NULL;
+        return err;
+    }
+    if (s_log.enc.has_last) {
+        s_clock_base = (int64_t)s_log.enc.last.ts + APP_HISTORY_PERIOD_S - esp_timer_get_time() / 1000000;
+    }
+    if (s_log.torn) {
+        ESP_LOGW(TAG, "Torn record after a power cut, continuing in sector %" PRIu32, s_log.sector);
+    }
+    ESP_LOGI(TAG, "Appending to sector %" PRIu32 " (seq %" PRIu32 ") at offset %" PRIu32, s_log.sector,
+             s_log.seq, s_log.offset);
+
+    if (xTaskCreate(history_task, "history", HISTORY_TASK_STACK, NULL, HISTORY_TASK_PRIO, &s_task) != pdPASS) {
+        vSemaphoreDelete(s_lock);
+        s_lock = NULL;
+        s_part = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_timer_create_args_t timer_args = {};
+    timer_args.callback = history_timer_cb;
+    timer_args.name = "history";
+    err = esp_timer_create(&timer_args, &s_timer);
+    if (err == ESP_OK) {
+        err = esp_timer_start_periodic(s_timer, APP_HISTORY_PERIOD_S * 1000000ULL);
+    }
+    return err;
+}
+
+void app_history_set_temperature(int16_t centi)
+{
+    portENTER_CRITICAL(&s_latest_lock);
+    s_temperature = centi;
+    s_has_source = true;
+    portEXIT_CRITICAL(&s_latest_lock);
+}
+
+void app_history_set_humidity(uint16_t centi)
+{
+    portENTER_CRITICAL(&s_latest_lock);
+    s_humidity = centi;
+    s_has_source = true;
+    portEXIT_CRITICAL(&s_latest_lock);
+}
+
+void app_history_set_occupancy(bool occupied)
+{
+    portENTER_CRITICAL(&s_latest_lock);
+    s_occupied_now = occupied;
+    s_occupied_latch |= occupied;
+    s_has_source = true;
+    portEXIT_CRITICAL(&s_latest_lock);
+}
+
+esp_err_t app_history_query(uint32_t from_ts, uint32_t to_ts, app_history_visit_t visit, void *ctx)
+{
+    if (!s_part) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t err = (esp_err_t)app_history_log_query(&s_log, from_ts, to_ts, visit, ctx);
+    s_last_query_us = (uint32_t)(esp_timer_get_time() - start_us);
+    xSemaphoreGive(s_lock);
+    return err;
+}
+
+typedef struct {
+    app_history_summary_t *summary;
+    int64_t t_sum;
+    int64_t h_sum;
+} summary_ctx_t;
+
+static bool summary_visit(const app_history_sample_t *sample, void *arg)
+{
+    summary_ctx_t *sc = (summary_ctx_t *)arg;
+    app_history_summary_t *s = sc->summary;
+    if (s->count == 0) {
+        s->first_ts = sample->ts;
+    }
+    s->count++;
+    s->last_ts = sample->ts;
+    if (sample->temperature != APP_HISTORY_TEMP_INVALID) {
+        if (s->t_count == 0 || sample->temperature < s->t_min) {
+            s->t_min = sample->temperature;
+        }
+        if (s->t_count == 0 || sample->temperature > s->t_max) {
+            s->t_max = sample->temperature;
+        }
+        s->t_count++;
+        sc->t_sum += sample->temperature;
+    }
+    if (sample->humidity != APP_HISTORY_HUM_INVALID) {
+        if (s->h_count == 0 || sample->humidity < s->h_min) {
+            s->h_min = sample->humidity;
+        }
+        if (s->h_count == 0 || sample->humidity > s->h_max) {
+            s->h_max = sample->humidity;
+        }
+        s->h_count++;
+        sc->h_sum += sample->humidity;
+    }
+    if (sample->occupied) {
+        s->occupied++;
+    }
+    return true;
+}
+
+// Range [newest - minutes, newest]; the newest sample is the encoder's last one
+static void history_range(uint32_t minutes, uint32_t *from_ts, uint32_t *to_ts)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    uint32_t newest = s_log.enc.has_last ? s_log.enc.last.ts : 0;
+    xSemaphoreGive(s_lock);
+    *to_ts = UINT32_MAX;
+    *from_ts = (minutes == 0 || (uint64_t)minutes * 60 > newest) ? 0 : newest - minutes * 60;
+}
+
+esp_err_t app_history_summary(uint32_t minutes, app_history_summary_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->t_min = out->t_max = out->t_mean = APP_HISTORY_TEMP_INVALID;
+    out->h_min = out->h_max = out->h_mean = APP_HISTORY_HUM_INVALID;
+    if (!s_part) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint32_t from_ts;
+    uint32_t to_ts;
+    history_range(minutes, &from_ts, &to_ts);
+    summary_ctx_t sc = { out, 0, 0 };
+    esp_err_t err = app_history_query(from_ts, to_ts, summary_visit, &sc);
+    if (out->t_count) {
+        out->t_mean = (int16_t)(sc.t_sum / out->t_count);
+    }
+    if (out->h_count) {
+        out->h_mean = (uint16_t)(sc.h_sum / out->h_count);
+    }
+    return err;
+}
+
+static size_t put_le16(uint8_t *out, uint16_t v)
+{
+    out[0] = (uint8_t)v;
+    out[1] = (uint8_t)(v >> 8);
+    return 2;
+}
+
+size_t app_history_encode_summary(const app_history_summary_t *summary, uint8_t *out, size_t size)
+{
+    if (size < APP_HISTORY_SUMMARY_SIZE) {
+        return 0;
+    }
+    size_t n = 0;
+    n += put_le16(&out[n], summary->count > UINT16_MAX ? UINT16_MAX : (uint16_t)summary->count);
+    n += put_le16(&out[n], (uint16_t)summary->t_min);
+    n += put_le16(&out[n], (uint16_t)summary->t_max);
+    n += put_le16(&out[n], (uint16_t)summary->t_mean);
+    n += put_le16(&out[n], summary->h_min);
+    n += put_le16(&out[n], summary->h_max);
+    n += put_le16(&out[n], summary->h_mean);
+    n += put_le16(&out[n], summary->occupied > UINT16_MAX ? UINT16_MAX : (uint16_t)summary->occupied);
+    return n;
+}
+
+static void print_centi(const char *label, int32_t centi, bool valid)
+{
+    if (!valid) {
+        printf(" %s=--", label);
+        return;
+    }
+    int32_t magnitude = centi < 0 ? -centi : centi;
+    printf(" %s=%s%" PRId32 ".%02" PRId32, label, centi < 0 ? "-" : "", magnitude / 100, magnitude % 100);
+}
+
+void app_history_print(uint32_t minutes)
+{
+    app_history_summary_t s;
+    if (app_history_summary(minutes, &s) != ESP_OK) {
+        printf("History not available\n");
+        return;
+    }
+    printf("%" PRIu32 " samples over %" PRIu32 " min, occupied %" PRIu32 " min\n", s.count,
+           s.count ? (s.last_ts - s.first_ts) / 60 : 0, s.occupied);
+    printf("temperature C:");
+    print_centi("min", s.t_min, s.t_count > 0);
+    print_centi("max", s.t_max, s.t_count > 0);
+    print_centi("mean", s.t_mean, s.t_count > 0);
+    printf("\nhumidity %%RH:");
+    print_centi("min", s.h_min, s.h_count > 0);
+    print_centi("max", s.h_max, s.h_count > 0);
+    print_centi("mean", s.h_mean, s.h_count > 0);
+    printf("\n");
+}
+
+static bool dump_visit(const app_history_sample_t *sample, void *ctx)
+{
+    printf("%10" PRIu32, sample->ts);
+    print_centi("t", sample->temperature, sample->temperature != APP_HISTORY_TEMP_INVALID);
+    print_centi("rh", sample->humidity, sample->humidity != APP_HISTORY_HUM_INVALID);
+    printf("%s\n", sample->occupied ? " occupied" : "");
+    return true;
+}
+
+void app_history_dump(uint32_t minutes)
+{
+    if (!s_part) {
+        printf("History not available\n");
+        return;
+    }
+    uint32_t from_ts;
+    uint32_t to_ts;
+    history_range(minutes, &from_ts, &to_ts);
+    app_history_query(from_ts, to_ts, dump_visit, NULL);
+}
+
+void app_history_print_stats(void)
+{
+    if (!s_part) {
+        printf("History not available\n");
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    app_history_log_stats_t st = s_log.stats;
+    uint32_t sector = s_log.sector;
+    uint32_t seq = s_log.seq;
+    uint32_t offset = s_log.offset;
+    uint32_t query_us = s_last_query_us;
+    uint32_t skipped = s_skipped;
+    xSemaphoreGive(s_lock);
+
+    printf("partition: %" PRIu32 " sectors, writing sector %" PRIu32 " (seq %" PRIu32 ") at offset %" PRIu32 "\n",
+           s_log.flash.sector_count, sector, seq, offset);
+    printf("appends=%" PRIu32 " keyframes=%" PRIu32 " bytes=%" PRIu32, st.appends, st.keyframes, st.bytes_written);
+    if (st.appends) {
+        printf(" (%" PRIu32 ".%02" PRIu32 " bytes/sample)", st.bytes_written / st.appends,
+               (st.bytes_written % st.appends) * 100 / st.appends);
+    }
+    printf(" erases=%" PRIu32 " write_errors=%" PRIu32 " skipped=%" PRIu32 " (no source)\n", st.erases,
+           st.write_errors, skipped);
+    printf("last query: %" PRIu32 " us, %" PRIu32 " records in %" PRIu32 " sectors\n", query_us,
+           st.last_query_records, st.last_query_sectors);
+}
@@ -0,0 +1,80 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// On-flash sensor history.
+//
+// Once a minute the latest temperature, humidity and occupancy are appended to
+// the app_history_log ring in the 64 KB "history" partition, encoded with
+// app_history_codec (2-3 bytes per sample, a keyframe every 4 hours and at the
+// start of each sector). 15 of the 16 sectors always hold data: about two to
+// three weeks of samples. Until some source has reported a value the minutes
+// are skipped, so a node without sensors never writes the flash.
+//
+// Timestamps are wall-clock seconds once the clock is set, otherwise seconds
+// continuing from the last stored sample (the time spent powered off is lost).
+// Range queries are relative to the newest sample.
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <esp_err.h>
+
+#include "app_history_codec.h"
+#include "app_history_log.h"
+
+#define APP_HISTORY_PERIOD_S        60
+#define APP_HISTORY_SUMMARY_SIZE    16      // app_history_encode_summary() output
+
+typedef struct {
+    uint32_t count;             // Samples in range
+    uint32_t first_ts;
+    uint32_t last_ts;
+    uint32_t t_count;           // Samples with a valid temperature
+    int16_t t_min;
+    int16_t t_max;
+    int16_t t_mean;
+    uint32_t h_count;           // Samples with a valid humidity
+    uint16_t h_min;
+    uint16_t h_max;
+    uint16_t h_mean;
+    uint32_t occupied;          // Samples with occupancy
+} app_history_summary_t;
+
+/** Find the history partition, recover the write position and start the
+ *  once-a-minute sampler. Call it only when a source is built in.
+ *
+ * @return ESP_ERR_NOT_FOUND if the partition table has no "history" partition.
+ */
+esp_err_t app_history_init(void);
+
+/** Latest values, sampled at the next minute boundary. Safe from any task. */
+void app_history_set_temperature(int16_t centi);
+void app_history_set_humidity(uint16_t centi);
+/** Occupancy latches: a minute counts as occupied if it was occupied at any point. */
+void app_history_set_occupancy(bool occupied);
+
+/** Visit the samples with from_ts <= ts <= to_ts, oldest first. Sectors that
+ *  end before from_ts are skipped without decoding. */
+esp_err_t app_history_query(uint32_t from_ts, uint32_t to_ts, app_history_visit_t visit, void *ctx);
+
+/** Summarize the last `minutes` of history (0 = all of it). */
+esp_err_t app_history_summary(uint32_t minutes, app_history_summary_t *out);
+
+/** Pack a summary for the S3 link: count u16, t_min/t_max/t_mean i16,
+ *  h_min/h_max/h_mean u16, occupied u16, little-endian. Returns bytes written. */
+size_t app_history_encode_summary(const app_history_summary_t *summary, uint8_t *out, size_t size);
+
+/** Print a summary of the last `minutes` (0 = all) to the console. */
+void app_history_print(uint32_t minutes);
+
+/** Print every sample of the last `minutes` to the console. */
+void app_history_dump(uint32_t minutes);
+
+/** Print flash usage, write counts and the cost of the last query. */
+void app_history_print_stats(void);
@@ -0,0 +1,170 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "app_history_codec.h"
+
+#define TAG_KIND_MASK       0x03
+#define TAG_KIND_KEYFRAME   0
+#define TAG_KIND_NIBBLES    1
+#define TAG_KIND_VARINTS    2
+#define TAG_OCCUPIED        (1 << 2)
+#define TAG_DT              (1 << 3)
+#define TAG_RESERVED        0xF0
+
+static uint32_t zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t unzigzag(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+static size_t put_varint(uint8_t *out, uint32_t v)
+{
+    size_t n = 0;
+    while (v >= 0x80) {
+        out[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+// Returns bytes read, 0 if truncated or longer than 5 bytes
+static size_t get_varint(const uint8_t *in, size_t len, uint32_t *v)
+{
+    uint32_t result = 0;
+    for (size_t n = 0; n < len && n < 5; n++) {
+        result |= (uint32_t)(in[n] & 0x7F) << (7 * n);
+        if (!(in[n] & 0x80)) {
+            *v = result;
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+void app_history_codec_init(app_history_codec_t *codec, uint32_t period_s)
+{
+    memset(codec, 0, sizeof(*codec));
+    codec->period_s = period_s;
+}
+
+size_t app_history_encode(app_history_codec_t *codec, const app_history_sample_t *sample, bool keyframe,
+                          uint8_t *out)
+{
+    uint8_t tag = sample->occupied ? TAG_OCCUPIED : 0;
+    size_t n = 1;
+
+    if (keyframe || !codec->has_last) {
+        out[0] = tag | TAG_KIND_KEYFRAME;
+        out[n++] = (uint8_t)sample->ts;
+        out[n++] = (uint8_t)(sample->ts >> 8);
+        out[n++] = (uint8_t)(sample->ts >> 16);
+        out[n++] = (uint8_t)(sample->ts >> 24);
+        out[n++] = (uint8_t)sample->temperature;
+        out[n++] = (uint8_t)((uint16_t)sample->temperature >> 8);
+        out[n++] = (uint8_t)sample->humidity;
+        out[n++] = (uint8_t)(sample->humidity >> 8);
+    } else {
+        uint32_t dt = sample->ts - codec->last.ts;
+        if (dt != codec->period_s) {
+            tag |= TAG_DT;
+            n += put_varint(&out[n], dt);
+        }
+        uint32_t zt = zigzag((int32_t)sample->temperature - codec->last.temperature);
+        uint32_t zh = zigzag((int32_t)sample->humidity - codec->last.humidity);
+        if (zt <= 15 && zh <= 15) {
+            tag |= TAG_KIND_NIBBLES;
+            out[n++] = (uint8_t)(zt << 4 | zh);
+        } else {
+            tag |= TAG_KIND_VARINTS;
+            n += put_varint(&out[n], zt);
+            n += put_varint(&out[n], zh);
+        }
+        out[0] = tag;
+    }
+
+    codec->last = *sample;
+    codec->has_last = true;
+    return n;
+}
+
+int app_history_decode(app_history_codec_t *codec, const uint8_t *in, size_t len, app_history_sample_t *out)
+{
+    if (len == 0 || in[0] == 0xFF) {
+        return 0;
+    }
+    uint8_t tag = in[0];
+    if (tag & TAG_RESERVED) {
+        return -1;
+    }
+
+    app_history_sample_t sample;
+    sample.occupied = (tag & TAG_OCCUPIED) != 0;
+    size_t n = 1;
+    uint8_t kind = tag & TAG_KIND_MASK;
+
+    if (kind == TAG_KIND_KEYFRAME) {
+        if (tag & TAG_DT) {
+            return -1;
+        }
+        if (len < 9) {
+            return 0;
+        }
+        sample.ts = (uint32_t)in[1] | (uint32_t)in[2] << 8 | (uint32_t)in[3] << 16 | (uint32_t)in[4] << 24;
+        sample.temperature = (int16_t)(in[5] | in[6] << 8);
+        sample.humidity = (uint16_t)(in[7] | in[8] << 8);
+        n = 9;
+    } else {
+        if (!codec->has_last || kind > TAG_KIND_VARINTS) {
+            return -1;
+        }
+        uint32_t dt = codec->period_s;
+        if (tag & TAG_DT) {
+            size_t used = get_varint(&in[n], len - n, &dt);
+            if (!used) {
+                return len - n < 5 ? 0 : -1;
+            }
+            n += used;
+        }
+        uint32_t zt;
+        uint32_t zh;
+        if (kind == TAG_KIND_NIBBLES) {
+            if (n >= len) {
+                return 0;
+            }
+            zt = in[n] >> 4;
+            zh = in[n] & 0x0F;
+            n++;
+        } else {
+            size_t used = get_varint(&in[n], len - n, &zt);
+            if (!used) {
+                return len - n < 5 ? 0 : -1;
+            }
+            n += used;
+            used = get_varint(&in[n], len - n, &zh);
+            if (!used) {
+                return len - n < 5 ? 0 : -1;
+            }
+            n += used;
+        }
+        sample.ts = codec->last.ts + dt;
+        sample.temperature = (int16_t)(codec->last.temperature + unzigzag(zt));
+        sample.humidity = (uint16_t)(codec->last.humidity + unzigzag(zh));
+    }
+
+    codec->last = sample;
+    codec->has_last = true;
+    *out = sample;
+    return (int)n;
+}
@@ -0,0 +1,64 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Sensor history record codec.
+//
+// One record per sample. A keyframe stores the sample in full; a delta stores
+// the change from the previous record, so a steady one-minute stream costs two
+// or three bytes per sample:
+//
+//   tag: 0 . . . dt occ kind kind    (bit 7 is always 0, so erased flash
+//                                     (0xFF) never parses as a record)
+//   kind 0, keyframe: tag ts[4] temperature[2] humidity[2]    little-endian
+//   kind 1, nibbles:  tag [dt] (zz(dT) << 4 | zz(dH))         both zigzag <= 15
+//   kind 2, varints:  tag [dt] varint(zz(dT)) varint(zz(dH))
+//
+// `dt` is a varint of seconds since the previous record, present only when the
+// dt bit is set; otherwise the gap is the nominal period. Pure byte handling
+// with no ESP-IDF or RTOS dependencies, so it builds unchanged on a host compiler.
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define APP_HISTORY_MAX_RECORD      16
+#define APP_HISTORY_TEMP_INVALID    INT16_MIN   // Matter null for MeasuredValue
+#define APP_HISTORY_HUM_INVALID     UINT16_MAX
+
+typedef struct {
+    uint32_t ts;                // Seconds; see app_history.h for the time base
+    int16_t temperature;        // 0.01 C
+    uint16_t humidity;          // 0.01 %RH
+    bool occupied;              // Any occupancy during the sample period
+} app_history_sample_t;
+
+// Running state shared by the encoder and decoder of one record stream
+typedef struct {
+    uint32_t period_s;
+    bool has_last;
+    app_history_sample_t last;
+} app_history_codec_t;
+
+/** Start a stream; the first record must then be a keyframe. */
+void app_history_codec_init(app_history_codec_t *codec, uint32_t period_s);
+
+/** Encode one sample into `out` (APP_HISTORY_MAX_RECORD bytes). A keyframe is
+ *  written when asked for or when there is no previous sample.
+ *
+ * @return Record length in bytes.
+ */
+size_t app_history_encode(app_history_codec_t *codec, const app_history_sample_t *sample, bool keyframe,
+                          uint8_t *out);
+
+/** Decode the record at `in`.
+ *
+ * @return Bytes consumed; 0 at the end of the stream (erased flash or too few
+ *         bytes); -1 if the record is corrupt or a delta has no keyframe before it.
+ */
+int app_history_decode(app_history_codec_t *codec, const uint8_t *in, size_t len, app_history_sample_t *out);
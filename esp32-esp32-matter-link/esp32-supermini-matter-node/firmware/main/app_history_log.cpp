@@ -0,0 +1,266 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "app_history_log.h"
+
+#define HISTORY_MAGIC               0x31534948  // "HIS1"
+
+static uint32_t sector_addr(uint32_t sector)
+{
+    return sector * APP_HISTORY_LOG_SECTOR_SIZE;
+}
+
+// Sequence number of a sector, 0 if it has no valid header
+static uint32_t read_header(app_history_log_t *log, uint32_t sector)
+{
+    uint32_t header[2];
+    if (log->flash.read(log->flash.ctx, sector_addr(sector), header, sizeof(header)) != 0 ||
+        header[0] != HISTORY_MAGIC) {
+        return 0;
+    }
+    return header[1];
+}
+
+// Walks the records of one sector, feeding a rolling window so a record never
+// straddles a refill. Returns the offset just past the last good record.
+static uint32_t scan_sector(app_history_log_t *log, uint32_t sector, app_history_codec_t *codec,
+                            app_history_visit_t visit, void *ctx, bool *corrupt)
+{
+    uint32_t offset = APP_HISTORY_LOG_HEADER_SIZE;
+    uint32_t buf_start = 0;
+    size_t buf_len = 0;
+    *corrupt = false;
+
+    while (offset < APP_HISTORY_LOG_SECTOR_SIZE) {
+        if (offset + APP_HISTORY_MAX_RECORD > buf_start + buf_len &&
+            buf_start + buf_len < APP_HISTORY_LOG_SECTOR_SIZE) {
+            buf_start = offset;
+            buf_len = APP_HISTORY_LOG_SECTOR_SIZE - offset < APP_HISTORY_LOG_READ_CHUNK
+                          ? APP_HISTORY_LOG_SECTOR_SIZE - offset
+                          : APP_HISTORY_LOG_READ_CHUNK;
+            if (log->flash.read(log->flash.ctx, sector_addr(sector) + buf_start, log->read_buf, buf_len) != 0) {
+                *corrupt = true;
+                break;
+            }
+        }
+
+        app_history_sample_t sample;
+        int used = app_history_decode(codec, &log->read_buf[offset - buf_start], buf_start + buf_len - offset,
+                                      &sample);
+        if (used == 0) {
+            break;
+        }
+        if (used < 0) {
+            *corrupt = true;
+            break;
+        }
+        offset += used;
+        if (visit && !visit(&sample, ctx)) {
+            break;
+        }
+    }
+    return offset;
+}
+
+static int open_sector(app_history_log_t *log, uint32_t sector, uint32_t seq)
+{
+    int err = log->flash.erase(log->flash.ctx, sector_addr(sector), APP_HISTORY_LOG_SECTOR_SIZE);
+    if (err != 0) {
+        return err;
+    }
+    log->stats.erases++;
+    // Sequence number before magic: a header cut short never looks valid
+    uint32_t header[2] = { HISTORY_MAGIC, seq };
+    err = log->flash.write(log->flash.ctx, sector_addr(sector) + sizeof(uint32_t), &header[1], sizeof(uint32_t));
+    if (err == 0) {
+        err = log->flash.write(log->flash.ctx, sector_addr(sector), &header[0], sizeof(uint32_t));
+    }
+    if (err != 0) {
+        return err;
+    }
+    log->sector = sector;
+    log->seq = seq;
+    log->offset = APP_HISTORY_LOG_HEADER_SIZE;
+    // Every sector starts with a keyframe so it decodes on its own
+    log->since_keyframe = APP_HISTORY_LOG_KEYFRAME_EVERY;
+    return 0;
+}
+
+// Bytes a torn record could have programmed past the end of the good ones
+static bool tail_erased(app_history_log_t *log, uint32_t sector, uint32_t offset)
+{
+    size_t len = APP_HISTORY_LOG_SECTOR_SIZE - offset < APP_HISTORY_MAX_RECORD ? APP_HISTORY_LOG_SECTOR_SIZE - offset
+                                                                               : APP_HISTORY_MAX_RECORD;
+    uint8_t tail[APP_HISTORY_MAX_RECORD];
+    if (log->flash.read(log->flash.ctx, sector_addr(sector) + offset, tail, len) != 0) {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++) {
+        if (tail[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int app_history_log_open(app_history_log_t *log, const app_history_flash_t *flash, uint32_t period_s)
+{
+    memset(log, 0, sizeof(*log));
+    log->flash = *flash;
+    log->period_s = period_s;
+    app_history_codec_init(&log->enc, period_s);
+
+    uint32_t newest = 0;
+    uint32_t newest_seq = 0;
+    for (uint32_t i = 0; i < flash->sector_count; i++) {
+        uint32_t seq = read_header(log, i);
+        if (seq > newest_seq) {
+            newest_seq = seq;
+            newest = i;
+        }
+    }
+    if (newest_seq == 0) {
+        return open_sector(log, 0, 1);
+    }
+
+    app_history_codec_t codec;
+    app_history_codec_init(&codec, period_s);
+    bool corrupt;
+    uint32_t end = scan_sector(log, newest, &codec, NULL, NULL, &corrupt);
+
+    log->sector = newest;
+    log->seq = newest_seq;
+    log->offset = end;
+    log->enc = codec;
+    log->since_keyframe = APP_HISTORY_LOG_KEYFRAME_EVERY;   // Time base may have moved across the reboot
+
+    // A torn record from a power cut: leave it behind and start a fresh sector
+    if (corrupt || !tail_erased(log, newest, end)) {
+        log->torn = true;
+        return open_sector(log, (newest + 1) % flash->sector_count, newest_seq + 1);
+    }
+    return 0;
+}
+
+int app_history_log_append(app_history_log_t *log, const app_history_sample_t *sample)
+{
+    if (log->offset + APP_HISTORY_MAX_RECORD > APP_HISTORY_LOG_SECTOR_SIZE) {
+        int err = open_sector(log, (log->sector + 1) % log->flash.sector_count, log->seq + 1);
+        if (err != 0) {
+            log->stats.write_errors++;
+            return err;
+        }
+    }
+
+    bool keyframe = log->since_keyframe >= APP_HISTORY_LOG_KEYFRAME_EVERY;
+    uint8_t record[APP_HISTORY_MAX_RECORD];
+    size_t len = app_history_encode(&log->enc, sample, keyframe, record);
+    // Body first, tag last: until the tag is programmed the slot still reads
+    // as erased, so a cut leaves no half record that decodes
+    uint32_t addr = sector_addr(log->sector) + log->offset;
+    int err = log->flash.write(log->flash.ctx, addr + 1, record + 1, len - 1);
+    if (err == 0) {
+        err = log->flash.write(log->flash.ctx, addr, record, 1);
+    }
+    if (err == 0) {
+        log->stats.appends++;
+        log->stats.bytes_written += len;
+        if (keyframe) {
+            log->stats.keyframes++;
+            log->since_keyframe = 0;
+        }
+        log->since_keyframe++;
+    } else {
+        log->stats.write_errors++;
+    }
+    // Skip the bytes even on failure: they may be partly programmed
+    log->offset += len;
+    return err;
+}
+
+typedef struct {
+    uint32_t from_ts;
+    uint32_t to_ts;
+    app_history_visit_t visit;
+    void *ctx;
+    uint32_t records;
+    bool done;
+} range_ctx_t;
+
+static bool range_visit(const app_history_sample_t *sample, void *arg)
+{
+    range_ctx_t *range = (range_ctx_t *)arg;
+    range->records++;
+    if (sample->ts > range->to_ts) {
+        range->done = true;
+        return false;
+    }
+    if (sample->ts < range->from_ts) {
+        return true;
+    }
+    if (!range->visit(sample, range->ctx)) {
+        range->done = true;
+        return false;
+    }
+    return true;
+}
+
+// First timestamp of a sector: the keyframe right after its header
+static bool sector_first_ts(app_history_log_t *log, uint32_t sector, uint32_t *ts)
+{
+    uint8_t record[APP_HISTORY_MAX_RECORD];
+    if (log->flash.read(log->flash.ctx, sector_addr(sector) + APP_HISTORY_LOG_HEADER_SIZE, record,
+                        sizeof(record)) != 0) {
+        return false;
+    }
+    app_history_codec_t codec;
+    app_history_codec_init(&codec, log->period_s);
+    app_history_sample_t sample;
+    if (app_history_decode(&codec, record, sizeof(record), &sample) <= 0) {
+        return false;
+    }
+    *ts = sample.ts;
+    return true;
+}
+
+int app_history_log_query(app_history_log_t *log, uint32_t from_ts, uint32_t to_ts, app_history_visit_t visit,
+                          void *ctx)
+{
+    range_ctx_t range = { from_ts, to_ts, visit, ctx, 0, false };
+    uint32_t sectors = 0;
+    uint32_t count = log->flash.sector_count;
+
+    // Oldest first: the ring continues after the sector being written
+    for (uint32_t i = 1; i <= count && !range.done; i++) {
+        uint32_t sector = (log->sector + i) % count;
+        uint32_t seq = read_header(log, sector);
+        if (seq == 0 || seq > log->seq) {
+            continue;
+        }
+
+        // Skip the sector if the next one already starts at or before from_ts
+        if (sector != log->sector) {
+            uint32_t next = (sector + 1) % count;
+            uint32_t next_ts;
+            if (read_header(log, next) == seq + 1 && sector_first_ts(log, next, &next_ts) && next_ts <= from_ts) {
+                continue;
+            }
+        }
+
+        app_history_codec_t codec;
+        app_history_codec_init(&codec, log->period_s);
+        bool corrupt;
+        scan_sector(log, sector, &codec, range_visit, &range, &corrupt);
+        sectors++;
+    }
+    log->stats.last_query_records = range.records;
+    log->stats.last_query_sectors = sectors;
+    return 0;
+}
@@ -0,0 +1,83 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Sensor history flash log.
+//
+// A ring of 4 KB sectors holding app_history_codec records. Each sector opens
+// with a header (magic, sequence number) and a keyframe, so it decodes on its
+// own; appends only ever program erased bytes, and the oldest sector is erased
+// when the ring wraps, so every sector wears equally. After a reboot the
+// newest sector is found by its sequence number and appending resumes after
+// its last good record. Headers and records are programmed so that a power cut
+// at any byte leaves nothing that parses (sequence before magic, record body
+// before its tag byte); the sector holding the remains is closed and the log
+// moves on to a fresh one.
+//
+// Flash access goes through app_history_flash_t, so the log has no ESP-IDF or
+// RTOS dependencies and runs unchanged on a host against a RAM flash. The
+// owner serializes all calls. Flash callbacks return 0 on success; any other
+// value is passed back to the caller unchanged (app_history passes esp_err_t).
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "app_history_codec.h"
+
+#define APP_HISTORY_LOG_SECTOR_SIZE     4096
+#define APP_HISTORY_LOG_HEADER_SIZE     8           // magic, seq
+#define APP_HISTORY_LOG_KEYFRAME_EVERY  240         // Records; 4 hours at one a minute
+#define APP_HISTORY_LOG_READ_CHUNK      128
+
+// Return false to stop the query early
+typedef bool (*app_history_visit_t)(const app_history_sample_t *sample, void *ctx);
+
+// Offsets are relative to the start of the log area
+typedef struct {
+    int (*read)(void *ctx, uint32_t offset, void *dst, size_t len);
+    int (*write)(void *ctx, uint32_t offset, const void *src, size_t len);
+    int (*erase)(void *ctx, uint32_t offset, size_t len);      // Whole sectors
+    void *ctx;
+    uint32_t sector_count;      // At least 2
+} app_history_flash_t;
+
+typedef struct {
+    uint32_t appends;
+    uint32_t keyframes;
+    uint32_t bytes_written;     // Record bytes, sector headers not included
+    uint32_t erases;
+    uint32_t write_errors;
+    uint32_t last_query_records;
+    uint32_t last_query_sectors;
+} app_history_log_stats_t;
+
+typedef struct {
+    app_history_flash_t flash;
+    uint32_t period_s;
+    uint32_t sector;            // Sector being appended to
+    uint32_t seq;               // Its sequence number
+    uint32_t offset;            // Next free byte in it
+    uint32_t since_keyframe;
+    bool torn;                  // open() found a torn record and moved to a fresh sector
+    app_history_codec_t enc;    // enc.last is the newest sample once enc.has_last
+    uint8_t read_buf[APP_HISTORY_LOG_READ_CHUNK];
+    app_history_log_stats_t stats;
+} app_history_log_t;
+
+/** Find the newest sector and the end of its records, or start an empty log
+ *  at sector 0. `period_s` is the nominal sample period for the codec. */
+int app_history_log_open(app_history_log_t *log, const app_history_flash_t *flash, uint32_t period_s);
+
+/** Append one sample, opening (erasing) the next sector when this one is full. */
+int app_history_log_append(app_history_log_t *log, const app_history_sample_t *sample);
+
+/** Visit the samples with from_ts <= ts <= to_ts, oldest first. Sectors that
+ *  end before from_ts are skipped without decoding. */
+int app_history_log_query(app_history_log_t *log, uint32_t from_ts, uint32_t to_ts, app_history_visit_t visit,
+                          void *ctx);
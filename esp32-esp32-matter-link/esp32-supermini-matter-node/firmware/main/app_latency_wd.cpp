@@ -0,0 +1,341 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <esp_freertos_hooks.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "app_latency_wd.h"
+
+#define APP_WD_TASK_STACK   3072
+#define APP_WD_TASK_PRIO    (configMAX_PRIORITIES - 2)   // Above every watched task
+
+static const char *TAG = "app_wd";
+
+// Upper bound of each gap bucket in ms; the last bucket is open-ended
+static const uint32_t s_bounds_ms[APP_WD_HIST_BUCKETS - 1] = { 1, 10, 50, 100, 250, 1000 };
+
+typedef struct {
+    const char *name;
+    uint32_t threshold_us;
+    int64_t last_us;                    // 0 = no check-in yet
+    bool stall_logged;                  // Ongoing stall already reported by the watchdog task
+    uint32_t hist[APP_WD_HIST_BUCKETS];
+    uint32_t samples;
+    uint32_t max_us;
+    uint32_t stalls;
+    char culprit[APP_WD_TASK_NAME_LEN]; // Longest runner during the worst stall
+    TaskHandle_t hog_task;              // Longest runner since the last check-in, across windows
+    uint32_t hog_ticks;
+} wd_path_t;
+
+static wd_path_t s_paths[APP_WD_MAX_PATHS];
+static int s_path_count = 0;
+static uint32_t s_period_ms = 50;
+static app_wd_probe_t s_probe = NULL;
+static TaskHandle_t s_task = NULL;
+static bool s_suspended = false;        // Under s_wd_lock
+static portMUX_TYPE s_wd_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Tick hook state: longest run without a task switch in the current window.
+// The hook runs in the tick ISR (also while the flash cache is off), so it only
+// stores the handle; names are looked up from task context.
+static TaskHandle_t s_run_task = NULL;
+static uint32_t s_run_ticks = 0;
+static uint32_t s_window_ticks = 0;
+static TaskHandle_t s_window_task = NULL;
+
+static void IRAM_ATTR wd_tick_hook(void)
+{
+    TaskHandle_t current = xTaskGetCurrentTaskHandle();
+    if (current == xTaskGetIdleTaskHandle()) {
+        s_run_task = NULL;
+        s_run_ticks = 0;
+        return;
+    }
+
+    s_run_ticks = (current == s_run_task) ? s_run_ticks + 1 : 1;
+    s_run_task = current;
+    if (s_run_ticks > s_window_ticks) {
+        portENTER_CRITICAL_ISR(&s_wd_lock);
+        s_window_ticks = s_run_ticks;
+        s_window_task = current;
+        portEXIT_CRITICAL_ISR(&s_wd_lock);
+    }
+}
+
+static void copy_task_name(char *out, TaskHandle_t task)
+{
+    out[0] = '\0';
+    if (task) {
+        strncpy(out, pcTaskGetName(task), APP_WD_TASK_NAME_LEN - 1);
+        out[APP_WD_TASK_NAME_LEN - 1] = '\0';
+    }
+}
+
+// Caller holds s_wd_lock. Folds the current hog window into the path, so a
+// stall longer than one period still names its longest runner.
+static void merge_window(wd_path_t *p)
+{
+    if (s_window_ticks > p->hog_ticks) {
+        p->hog_ticks = s_window_ticks;
+        p->hog_task = s_window_task;
+    }
+}
+
+// Caller holds s_wd_lock; consumes the path's hog attribution
+static void record_gap(wd_path_t *p, uint32_t gap_us)
+{
+    uint32_t gap_ms = gap_us / 1000;
+    int b = 0;
+    while (b < APP_WD_HIST_BUCKETS - 1 && gap_ms >= s_bounds_ms[b]) {
+        b++;
+    }
+    p->hist[b]++;
+    p->samples++;
+    merge_window(p);
+    if (gap_us > p->threshold_us) {
+        p->stalls++;
+        if (gap_us > p->max_us) {
+            copy_task_name(p->culprit, p->hog_task);
+        }
+    }
+    if (gap_us > p->max_us) {
+        p->max_us = gap_us;
+    }
+    p->hog_task = NULL;
+    p->hog_ticks = 0;
+}
+
+app_wd_path_t app_wd_register(const char *name, uint32_t threshold_ms)
+{
+    app_wd_path_t id = -1;
+
+    portENTER_CRITICAL(&s_wd_lock);
+    if (s_path_count < APP_WD_MAX_PATHS) {
+        id = s_path_count++;
+        memset(&s_paths[id], 0, sizeof(s_paths[id]));
+        s_paths[id].name = name;
+        s_paths[id].threshold_us = threshold_ms * 1000;
+    }
+    portEXIT_CRITICAL(&s_wd_lock);
+    return id;
+}
+
+void app_wd_checkin(app_wd_path_t path)
+{
+    if (path < 0 || path >= s_path_count) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_wd_lock);
+    if (s_suspended) {
+        portEXIT_CRITICAL(&s_wd_lock);
+        return;
+    }
+    wd_path_t *p = &s_paths[path];
+    if (p->last_us != 0) {
+        record_gap(p, (uint32_t)(now - p->last_us));
+    }
+    p->last_us = now;
+    p->stall_logged = false;
+    portEXIT_CRITICAL(&s_wd_lock);
+}
+
+void app_wd_record_delay(app_wd_path_t path, uint32_t delay_us)
+{
+    if (path < 0 || path >= s_path_count) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_wd_lock);
+    if (s_suspended) {
+        portEXIT_CRITICAL(&s_wd_lock);
+        return;
+    }
+    wd_path_t *p = &s_paths[path];
+    record_gap(p, delay_us);
+    p->last_us = esp_timer_get_time();
+    p->stall_logged = false;
+    portEXIT_CRITICAL(&s_wd_lock);
+}
+
+static void wd_task(void *arg)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (1) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(s_period_ms));
+
+        portENTER_CRITICAL(&s_wd_lock);
+        bool suspended = s_suspended;
+        portEXIT_CRITICAL(&s_wd_lock);
+        if (suspended) {
+            // Idle: no tick of ours until app_wd_suspend(false)
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            last_wake = xTaskGetTickCount();
+            continue;
+        }
+
+        if (s_probe) {
+            s_probe();
+        }
+
+        // Report stalls while they are happening, once each; check-ins record their length
+        int64_t now = esp_timer_get_time();
+        for (int i = 0; i < s_path_count; i++) {
+            const char *name = NULL;
+            uint32_t silent_ms = 0;
+            char culprit[APP_WD_TASK_NAME_LEN];
+
+            portENTER_CRITICAL(&s_wd_lock);
+            wd_path_t *p = &s_paths[i];
+            merge_window(p);
+            if (p->last_us != 0 && !p->stall_logged && now - p->last_us > p->threshold_us) {
+                p->stall_logged = true;
+                name = p->name;
+                silent_ms = (uint32_t)((now - p->last_us) / 1000);
+                copy_task_name(culprit, p->hog_task);
+            }
+            portEXIT_CRITICAL(&s_wd_lock);
+
+            if (name) {
+                ESP_LOGW(TAG, "%s silent for %" PRIu32 "ms (longest runner: %s)", name, silent_ms,
+                         culprit[0] ? culprit : "-");
+            }
+        }
+
+        // Start a new hog window; every path has folded in the old one
+        portENTER_CRITICAL(&s_wd_lock);
+        s_window_ticks = 0;
+        s_window_task = NULL;
+        portEXIT_CRITICAL(&s_wd_lock);
+    }
+}
+
+esp_err_t app_wd_init(uint32_t period_ms, app_wd_probe_t probe)
+{
+    s_period_ms = period_ms;
+    s_probe = probe;
+
+    esp_err_t err = esp_register_freertos_tick_hook(wd_tick_hook);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to register tick hook: %s", esp_err_to_name(err));
+        return err;
+    }
+    if (xTaskCreate(wd_task, "latency_wd", APP_WD_TASK_STACK, NULL, APP_WD_TASK_PRIO, &s_task) != pdPASS) {
+        esp_deregister_freertos_tick_hook(wd_tick_hook);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void app_wd_suspend(bool suspend)
+{
+    portENTER_CRITICAL(&s_wd_lock);
+    bool resume = s_suspended && !suspend;
+    s_suspended = suspend;
+    if (resume) {
+        for (int i = 0; i < s_path_count; i++) {
+            s_paths[i].last_us = 0;
+            s_paths[i].stall_logged = false;
+        }
+    }
+    portEXIT_CRITICAL(&s_wd_lock);
+    if (resume && s_task) {
+        xTaskNotifyGive(s_task);
+    }
+}
+
+void app_wd_reset(void)
+{
+    portENTER_CRITICAL(&s_wd_lock);
+    for (int i = 0; i < s_path_count; i++) {
+        wd_path_t *p = &s_paths[i];
+        memset(p->hist, 0, sizeof(p->hist));
+        p->samples = 0;
+        p->max_us = 0;
+        p->stalls = 0;
+        p->culprit[0] = '\0';
+    }
+    portEXIT_CRITICAL(&s_wd_lock);
+}
+
+void app_wd_print(void)
+{
+    static wd_path_t snap[APP_WD_MAX_PATHS];
+    int count;
+
+    portENTER_CRITICAL(&s_wd_lock);
+    count = s_path_count;
+    memcpy(snap, s_paths, sizeof(snap));
+    portEXIT_CRITICAL(&s_wd_lock);
+
+    printf("%-12s %7s %6s %8s %-16s", "path", "thr_ms", "stalls", "max_ms", "worst_culprit");
+    for (int b = 0; b < APP_WD_HIST_BUCKETS - 1; b++) {
+        printf(" <%-5" PRIu32, s_bounds_ms[b]);
+    }
+    printf(" >=%" PRIu32 "\n", s_bounds_ms[APP_WD_HIST_BUCKETS - 2]);
+
+    for (int i = 0; i < count; i++) {
+        const wd_path_t *p = &snap[i];
+        printf("%-12s %7" PRIu32 " %6" PRIu32 " %8.1f %-16s", p->name, p->threshold_us / 1000, p->stalls,
+               p->max_us / 1000.0, p->culprit[0] ? p->culprit : "-");
+        for (int b = 0; b < APP_WD_HIST_BUCKETS; b++) {
+            printf(" %6" PRIu32, p->hist[b]);
+        }
+        printf("\n");
+    }
+    printf("Histogram columns are check-in gaps in ms\n");
+}
+
+static void put_le16_sat(uint8_t *out, uint32_t v)
+{
+    if (v > 0xFFFF) {
+        v = 0xFFFF;
+    }
+    out[0] = (uint8_t)(v & 0xFF);
+    out[1] = (uint8_t)(v >> 8);
+}
+
+size_t app_wd_encode(uint8_t first, uint8_t *out, size_t out_size)
+{
+    if (out_size < APP_WD_ENCODE_HEADER) {
+        return 0;
+    }
+
+    portENTER_CRITICAL(&s_wd_lock);
+    int count = s_path_count;
+    int n = 0;
+    if (first < count) {
+        n = (int)((out_size - APP_WD_ENCODE_HEADER) / APP_WD_ENCODE_PATH_SIZE);
+        if (n > count - first) {
+            n = count - first;
+        }
+    }
+    out[0] = (uint8_t)count;
+    out[1] = first;
+    out[2] = (uint8_t)n;
+    for (int i = 0; i < n; i++) {
+        const wd_path_t *p = &s_paths[first + i];
+        uint8_t *o = &out[APP_WD_ENCODE_HEADER + APP_WD_ENCODE_PATH_SIZE * i];
+        put_le16_sat(&o[0], p->stalls);
+        put_le16_sat(&o[2], p->max_us / 1000);
+        for (int b = 0; b < APP_WD_HIST_BUCKETS; b++) {
+            put_le16_sat(&o[4 + 2 * b], p->hist[b]);
+        }
+    }
+    portEXIT_CRITICAL(&s_wd_lock);
+    return APP_WD_ENCODE_HEADER + APP_WD_ENCODE_PATH_SIZE * (size_t)n;
+}
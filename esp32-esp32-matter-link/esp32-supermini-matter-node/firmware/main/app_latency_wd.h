@@ -0,0 +1,79 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Task-latency watchdog.
+//
+// Critical paths (the event dispatcher, the UART RX task, the Matter thread)
+// check in regularly. Every gap between check-ins goes into a small per-path
+// histogram; a gap over the path's threshold counts as a stall and is logged
+// with the task that ran longest without yielding meanwhile, sampled by a
+// FreeRTOS tick hook. Unlike the task WDT this never resets the chip: it only
+// measures, so thresholds can be far below the TWDT timeout.
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <esp_err.h>
+
+#define APP_WD_MAX_PATHS        4
+#define APP_WD_HIST_BUCKETS     7
+#define APP_WD_TASK_NAME_LEN    16
+
+// app_wd_encode layout
+#define APP_WD_ENCODE_HEADER    3                               // count, first, n
+#define APP_WD_ENCODE_PATH_SIZE (4 + 2 * APP_WD_HIST_BUCKETS)   // stalls, max_ms, buckets
+
+typedef int app_wd_path_t;      // -1 = not registered (calls are ignored)
+
+/** Called from the watchdog task every period, e.g. to probe a thread that
+ *  cannot check in by itself. */
+typedef void (*app_wd_probe_t)(void);
+
+/** Start the watchdog task and the tick hook.
+ *
+ * @param period_ms How often paths are checked for ongoing stalls.
+ * @param probe     Optional probe run every period (may be NULL).
+ */
+esp_err_t app_wd_init(uint32_t period_ms, app_wd_probe_t probe);
+
+/** Add a path. Call before its first check-in.
+ *
+ * @param name         Printable name (not copied; pass a string literal).
+ * @param threshold_ms Gap that counts as a stall.
+ * @return the path handle, or -1 if APP_WD_MAX_PATHS are already registered.
+ */
+app_wd_path_t app_wd_register(const char *name, uint32_t threshold_ms);
+
+/** Record that `path` is alive now; the gap since its previous check-in is sampled. */
+void app_wd_checkin(app_wd_path_t path);
+
+/** Record an explicit delay sample for `path` (e.g. time from scheduling a
+ *  probe to it running) and count it as a check-in. */
+void app_wd_record_delay(app_wd_path_t path, uint32_t delay_us);
+
+/** Stop watching while the node is idle: the watchdog task blocks without
+ *  waking the CPU, and check-ins and probes are ignored. Resuming forgets
+ *  every path's last check-in, so the idle gap is never counted as a stall. */
+void app_wd_suspend(bool suspend);
+
+/** Print per-path histograms, stalls and the worst offender. */
+void app_wd_print(void);
+
+/** Clear histograms and stall counters. */
+void app_wd_reset(void);
+
+/** Pack path statistics for the S3 link, starting at path `first`: count u8
+ *  (registered paths), first u8, n u8 (paths that follow), then per path
+ *  stalls u16, max gap in ms u16 and the APP_WD_HIST_BUCKETS gap buckets u16
+ *  (little-endian, saturated). As many paths as fit in `out_size` are packed;
+ *  ask again from first + n for the rest.
+ *
+ * @return bytes written, 0 if `out_size` cannot hold the header.
+ */
+size_t app_wd_encode(uint8_t first, uint8_t *out, size_t out_size);
@@ -0,0 +1,102 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "app_link_proto.h"
+
+enum {
+    PARSE_WAIT_START = 0,
+    PARSE_LEN,
+    PARSE_BODY,     // CMD + payload
+    PARSE_CRC,
+};
+
+uint8_t link_crc8(const uint8_t *data, size_t len)
+{
+    uint8_t crc = 0x00;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (uint8_t j = 0; j < 8; j++) {
+            if (crc & 0x80) {
+                crc = (crc << 1) ^ LINK_CRC_POLY;
+            } else {
+                crc <<= 1;
+            }
+        }
+    }
+    return crc;
+}
+
+size_t link_encode(uint8_t cmd, const uint8_t *payload, uint8_t payload_len, uint8_t *out, size_t out_size)
+{
+    size_t size = LINK_FRAME_OVERHEAD + 1 + payload_len;
+    if (1 + payload_len > LINK_MAX_LEN || size > out_size) {
+        return 0;
+    }
+
+    size_t idx = 0;
+    out[idx++] = LINK_FRAME_START;
+    out[idx++] = 1 + payload_len;   // Length = CMD (1 byte) + PAYLOAD
+    out[idx++] = cmd;
+    if (payload && payload_len > 0) {
+        memcpy(&out[idx], payload, payload_len);
+        idx += payload_len;
+    }
+    out[idx] = link_crc8(&out[1], idx - 1);   // CRC over LEN + CMD + PAYLOAD
+    return idx + 1;
+}
+
+void link_parser_init(link_parser_t *p)
+{
+    p->state = PARSE_WAIT_START;
+    p->idx = 0;
+    p->remaining = 0;
+}
+
+link_parse_result_t link_parser_feed(link_parser_t *p, uint8_t b, link_frame_t *frame)
+{
+    switch (p->state) {
+    case PARSE_WAIT_START:
+        if (b == LINK_FRAME_START) {
+            p->buf[0] = b;
+            p->idx = 1;
+            p->state = PARSE_LEN;
+        }
+        return LINK_PARSE_NONE;
+
+    case PARSE_LEN:
+        if (b == 0 || b > LINK_MAX_LEN) {
+            link_parser_init(p);
+            return LINK_PARSE_LENGTH_ERROR;
+        }
+        p->buf[p->idx++] = b;
+        p->remaining = b;
+        p->state = PARSE_BODY;
+        return LINK_PARSE_NONE;
+
+    case PARSE_BODY:
+        p->buf[p->idx++] = b;
+        if (--p->remaining == 0) {
+            p->state = PARSE_CRC;
+        }
+        return LINK_PARSE_NONE;
+
+    case PARSE_CRC:
+    default: {
+        uint8_t expected = link_crc8(&p->buf[1], p->idx - 1);
+        frame->cmd = p->buf[2];
+        frame->len = p->buf[1] - 1;
+        frame->payload = &p->buf[3];
+        frame->crc_expected = expected;
+        frame->crc_received = b;
+        link_parser_init(p);
+        return expected == b ? LINK_PARSE_FRAME : LINK_PARSE_CRC_ERROR;
+    }
+    }
+}
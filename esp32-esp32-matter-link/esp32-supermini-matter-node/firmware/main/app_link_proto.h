@@ -0,0 +1,93 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// S3 link frame codec.
+//
+// Frame: START(0xA5) LEN CMD PAYLOAD[LEN-1] CRC8, with CRC8 (poly 0x31, init 0)
+// over LEN, CMD and PAYLOAD. Pure byte handling with no ESP-IDF or RTOS
+// dependencies, so it builds and runs unchanged on a host compiler.
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define LINK_FRAME_START        0xA5
+#define LINK_CRC_POLY           0x31
+#define LINK_MAX_FRAME          64
+#define LINK_MAX_LEN            60      // LEN byte: CMD + payload
+#define LINK_FRAME_OVERHEAD     3       // START, LEN, CRC
+
+// Commands from S3
+#define CMD_HELLO    0x01
+#define CMD_SET_MODE 0x02
+#define CMD_TRIGGER  0x03
+#define CMD_PING     0x04
+#define CMD_WD_STATS 0x05   // Payload: first path u8 (optional). Reply: ACK with app_wd_encode from that path
+#define CMD_HISTORY  0x06   // Payload: minutes u16 (0 = all). Reply: ACK with app_history_encode_summary
+#define CMD_TOUCH    0x07   // Payload: touched u8, age_ms u16 (since the change). Reply: ACK with state u8, confidence u8
+
+// Commands from C3 (status notifications)
+#define CMD_STATUS_PAIRED    0x10
+#define CMD_STATUS_UNPAIRED  0x11
+
+// Responses (0x80 and up are never acknowledged)
+#define RSP_ACK      0x80
+#define RSP_ERR      0x81
+#define RSP_BUSY     0x82
+#define RSP_DONE     0x83
+
+typedef enum {
+    LINK_PARSE_NONE = 0,        // Byte consumed, no frame yet
+    LINK_PARSE_FRAME,           // `frame` holds a valid frame
+    LINK_PARSE_CRC_ERROR,       // Frame dropped: CRC mismatch
+    LINK_PARSE_LENGTH_ERROR,    // Frame dropped: LEN is 0 or above LINK_MAX_LEN
+} link_parse_result_t;
+
+typedef struct {
+    uint8_t cmd;
+    uint8_t len;                // Payload bytes, excluding CMD
+    const uint8_t *payload;     // Points into the parser; valid until the next feed
+    uint8_t crc_expected;       // Set on LINK_PARSE_CRC_ERROR
+    uint8_t crc_received;
+} link_frame_t;
+
+typedef struct {
+    uint8_t state;
+    uint8_t buf[LINK_MAX_FRAME];
+    uint8_t idx;
+    uint8_t remaining;
+} link_parser_t;
+
+/** CRC8 as used on the link. */
+uint8_t link_crc8(const uint8_t *data, size_t len);
+
+/** Encode a frame into `out`.
+ *
+ * @return the frame size in bytes, or 0 if it does not fit in `out_size` or LINK_MAX_LEN.
+ */
+size_t link_encode(uint8_t cmd, const uint8_t *payload, uint8_t payload_len, uint8_t *out, size_t out_size);
+
+/** Reset a parser to wait for a start byte. */
+void link_parser_init(link_parser_t *p);
+
+/** Feed one received byte.
+ *
+ * @param[out] frame Filled when LINK_PARSE_FRAME or LINK_PARSE_CRC_ERROR is returned.
+ */
+link_parse_result_t link_parser_feed(link_parser_t *p, uint8_t byte, link_frame_t *frame);
+
+/** Little-endian helpers for frame payloads. */
+static inline uint16_t link_get_le16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t link_get_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
@@ -0,0 +1,124 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#include "app_link_stats.h"
+
+// Upper bound of each RTT bucket; the last bucket is open-ended
+static const uint32_t s_rtt_bounds_us[APP_LINK_RTT_BUCKETS - 1] = {
+    1000, 2000, 5000, 10000, 20000, 50000, 100000,
+};
+
+static app_link_stats_t s_stats;
+static int64_t s_cmd_tx_us = 0;     // 0 = no command awaiting a response
+// Updated from the dispatcher (TX) and the UART RX task
+static portMUX_TYPE s_link_lock = portMUX_INITIALIZER_UNLOCKED;
+
+void app_link_stats_tx(uint8_t cmd, bool ok)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_link_lock);
+    if (ok) {
+        s_stats.tx_frames++;
+        if (cmd < 0x80) {
+            s_cmd_tx_us = now;
+        }
+    } else {
+        s_stats.tx_failed++;
+    }
+    portEXIT_CRITICAL(&s_link_lock);
+}
+
+void app_link_stats_rx(uint8_t cmd, int64_t rx_us)
+{
+    portENTER_CRITICAL(&s_link_lock);
+    s_stats.rx_frames++;
+    if (cmd >= 0x80) {
+        s_stats.rx_responses++;
+        if (s_cmd_tx_us != 0 && rx_us >= s_cmd_tx_us) {
+            uint32_t rtt = (uint32_t)(rx_us - s_cmd_tx_us);
+            int b = 0;
+            while (b < APP_LINK_RTT_BUCKETS - 1 && rtt >= s_rtt_bounds_us[b]) {
+                b++;
+            }
+            s_stats.rtt_hist[b]++;
+            s_stats.rtt_total_us += rtt;
+            if (rtt > s_stats.rtt_max_us) {
+                s_stats.rtt_max_us = rtt;
+            }
+            s_cmd_tx_us = 0;
+        } else {
+            s_stats.unmatched++;
+        }
+    }
+    portEXIT_CRITICAL(&s_link_lock);
+}
+
+void app_link_stats_crc_error(void)
+{
+    portENTER_CRITICAL(&s_link_lock);
+    s_stats.crc_errors++;
+    portEXIT_CRITICAL(&s_link_lock);
+}
+
+void app_link_stats_length_error(void)
+{
+    portENTER_CRITICAL(&s_link_lock);
+    s_stats.length_errors++;
+    portEXIT_CRITICAL(&s_link_lock);
+}
+
+void app_link_stats_get(app_link_stats_t *out)
+{
+    portENTER_CRITICAL(&s_link_lock);
+    *out = s_stats;
+    portEXIT_CRITICAL(&s_link_lock);
+}
+
+void app_link_stats_reset(void)
+{
+    portENTER_CRITICAL(&s_link_lock);
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_cmd_tx_us = 0;
+    portEXIT_CRITICAL(&s_link_lock);
+}
+
+void app_link_stats_print(void)
+{
+    app_link_stats_t st;
+    app_link_stats_get(&st);
+
+    printf("TX frames: %" PRIu32 " (failed %" PRIu32 ")\n", st.tx_frames, st.tx_failed);
+    printf("RX frames: %" PRIu32 " (responses %" PRIu32 ", unmatched %" PRIu32 ")\n",
+           st.rx_frames, st.rx_responses, st.unmatched);
+    printf("Errors:    crc %" PRIu32 ", length %" PRIu32 "\n", st.crc_errors, st.length_errors);
+
+    uint32_t samples = 0;
+    for (int b = 0; b < APP_LINK_RTT_BUCKETS; b++) {
+        samples += st.rtt_hist[b];
+    }
+    if (samples == 0) {
+        printf("RTT:       no samples\n");
+        return;
+    }
+    printf("RTT:       n=%" PRIu32 " avg=%" PRIu32 "us max=%" PRIu32 "us\n", samples,
+           (uint32_t)(st.rtt_total_us / samples), st.rtt_max_us);
+    for (int b = 0; b < APP_LINK_RTT_BUCKETS; b++) {
+        if (b < APP_LINK_RTT_BUCKETS - 1) {
+            printf("  < %3" PRIu32 "ms %8" PRIu32 "\n", s_rtt_bounds_us[b] / 1000, st.rtt_hist[b]);
+        } else {
+            printf("  >=%3" PRIu32 "ms %8" PRIu32 "\n", s_rtt_bounds_us[b - 1] / 1000, st.rtt_hist[b]);
+        }
+    }
+}
@@ -0,0 +1,54 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// UART link statistics.
+//
+// Counts frames in each direction, framing and CRC errors, and the round trip
+// from a C3 → S3 command to the S3's response, bucketed into a fixed histogram.
+// Every call is a few counter updates under a spinlock, cheap enough for production.
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define APP_LINK_RTT_BUCKETS 8
+
+typedef struct {
+    uint32_t tx_frames;
+    uint32_t tx_failed;
+    uint32_t rx_frames;
+    uint32_t rx_responses;
+    uint32_t crc_errors;
+    uint32_t length_errors;
+    uint32_t unmatched;                     // Responses with no command in flight
+    uint32_t rtt_hist[APP_LINK_RTT_BUCKETS];
+    uint32_t rtt_max_us;
+    uint64_t rtt_total_us;
+} app_link_stats_t;
+
+/** Record a frame handed to the UART driver. Commands (cmd < 0x80) start an RTT sample. */
+void app_link_stats_tx(uint8_t cmd, bool ok);
+
+/** Record a valid frame received at `rx_us`. Responses (cmd >= 0x80) close the
+ *  RTT sample started by the last command. */
+void app_link_stats_rx(uint8_t cmd, int64_t rx_us);
+
+/** Record a frame dropped for a bad CRC. */
+void app_link_stats_crc_error(void);
+
+/** Record a frame dropped for an invalid length byte. */
+void app_link_stats_length_error(void);
+
+/** Copy the current counters. */
+void app_link_stats_get(app_link_stats_t *out);
+
+/** Clear all counters. */
+void app_link_stats_reset(void);
+
+/** Print counters and the RTT histogram to the console. */
+void app_link_stats_print(void);
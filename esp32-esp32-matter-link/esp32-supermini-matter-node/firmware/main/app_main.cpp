@@ -23,6 +23,7 @@
 
 #include <app/server/CommissioningWindowManager.h>
 #include <app/server/Server.h>
+#include <inttypes.h>
 #include <esp_err.h>
 #include <esp_log.h>
 #include <esp_matter.h>
@@ -34,6 +35,26 @@
 
 #include <app_openthread_config.h>
 #include "app_reset.h"
+#include "app_console.h"
+#include "app_event_bus.h"
+#include "app_trace.h"
+#include "app_trigger_queue.h"
+#include "app_node_model.h"
+#include "app_link_proto.h"
+#include "app_link_stats.h"
+#include "app_matter_stats.h"
+#include "app_ble_reclaim.h"
+#include "app_latency_wd.h"
+#include "app_history.h"
+#include "app_presence.h"
+#include "app_power.h"
+#if CONFIG_APP_PIR_SENSOR
+#include "pir_sensor.h"
+#endif
+#if CONFIG_APP_SHTC3
+#include "shtc3.h"
+#include "app_sensor_agg.h"
+#endif
 #include "utils/common_macros.h"
 
 // Button component direct include (for factory reset only)
@@ -51,24 +72,46 @@
 
 
 #include <esp_matter_event.h>
-#include <esp_console.h>
 #include <esp_vfs_dev.h>
 #include <driver/gpio.h>
 #include <esp_timer.h>
+#include <esp_heap_caps.h>
 #include <driver/uart.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
+#include <freertos/semphr.h>
 
 static const char *TAG = "app_main";
 
 // Global variables
-static uint16_t g_switch_endpoint_id = 0;
-static uint16_t g_mode_plugin_ids[4] = {0}; // 4 plugin units for mode selection
+static app_node_model_t g_node;                 // Trigger and mode plugs, current mode (see app_node_model.h)
+#if CONFIG_TRIGGER_SWITCH_EVENTS
+static uint16_t g_trigger_switch_endpoint_id = 0; // Generic Switch: one press event per skit
+#endif
 static bool g_pulse_active = false;    // Track if pulse is currently active
-static volatile int g_target_mode = -1;         // User's desired mode (-1 = none pending)
-static volatile int64_t g_last_tap_time = 0;    // Time of last user tap (microseconds)
-static volatile int64_t g_last_execution_time = 0; // Time of last mode execution (microseconds)
-static volatile bool g_syncing_modes = false;   // Flag to prevent callback recursion during sync
+static volatile int32_t g_pulse_generation = 0; // Tags PULSE_END so a stale one can't end the next pulse
+static int g_target_mode = -1;                  // User's desired mode (-1 = none pending)
+static bool g_trigger_attr_on = false;          // Trigger OnOff written ON by a controller, not yet reset (dispatcher only)
+static app_trigger_queue_t g_trigger_queue;     // Skits waiting behind the running one (dispatcher only)
+
+// Latency watchdog paths (see app_latency_wd.h)
+#define WD_PERIOD_MS            100     // Watchdog scan and Matter probe interval
+#define WD_DISPATCHER_MS        250     // No handler sleeps; covers a slow Matter report or UART write
+#define WD_UART_RX_MS           300     // RX reads time out every 100ms
+#define WD_MATTER_MS            200
+#define IDLE_POLL_MS            10000   // Dispatcher heartbeat and UART RX timeout while idle; the watchdog stops
+static app_wd_path_t g_wd_dispatcher = -1;
+static app_wd_path_t g_wd_uart_rx = -1;
+static app_wd_path_t g_wd_matter = -1;
+static volatile bool g_matter_started = false;
+static volatile int64_t g_matter_probe_us = 0;  // When the pending probe was scheduled, 0 = none
+
+// One-shot timers; their callbacks only post events to the dispatcher
+static esp_timer_handle_t g_pulse_timer = NULL;
+static esp_timer_handle_t g_mode_debounce_timer = NULL;
+static esp_timer_handle_t g_mode_cleanup_timer = NULL;
+static esp_timer_handle_t g_mode_report_timer = NULL;
+static esp_timer_handle_t g_led_timer = NULL;
 
 // Use the Kconfig value directly
 
@@ -88,39 +131,54 @@ using namespace chip::app::Clusters;
 #define BSP_BUTTON_NUM 0
 #define SIGNAL_GPIO (gpio_num_t)4            // GPIO 4 for signal output
 #define PULSE_DURATION_MS 500               // 500ms pulse duration
+#define MODE_DEBOUNCE_MS 200                // Execute mode change 200ms after the last tap
+#define MODE_CLEANUP_MS 5000                // Re-assert the mode once 5s after the last change
 
 // UART configuration for S3 communication
-#define UART_NUM UART_NUM_1
-#define UART_TX_PIN 21
-#define UART_RX_PIN 20
-#define UART_BAUD 115200
-#define UART_BUF_SIZE 1024
+// (Kconfig "S3 Link Configuration": UART0 lets QEMU carry the link on its serial socket)
+#define UART_NUM (uart_port_t)CONFIG_LINK_UART_PORT_NUM
+#define UART_TX_PIN CONFIG_LINK_UART_TX_PIN
+#define UART_RX_PIN CONFIG_LINK_UART_RX_PIN
+#define UART_BAUD CONFIG_LINK_UART_BAUD
+#define UART_BUF_SIZE CONFIG_LINK_UART_BUF_SIZE
+#if CONFIG_APP_BLE_RECLAIM
+#define UART_BUF_SIZE_RECLAIMED CONFIG_LINK_UART_BUF_SIZE_RECLAIMED  // Once BLE's RAM is back
+#define UART_BUF_COPIES 3   // RX ring, TX ring and the RX task's read buffer all take the new size
+#endif
+
+// The RX task reinstalls the UART driver to resize its buffers; writers hold
+// this (recursive) lock so they never see a half-installed driver
+static SemaphoreHandle_t g_link_lock = NULL;
+static volatile size_t g_link_buf_request = 0;  // New buffer size for the RX task, 0 = none
+static SemaphoreHandle_t g_link_buf_done = NULL;  // Given by the RX task once a request is applied
+// A request waits for at most one RX read timeout (10 s while idle) plus the reinstall
+#define LINK_RESIZE_WAIT_MS     (IDLE_POLL_MS + 500)
 
 // LED for visual feedback
 #define LED_GPIO (gpio_num_t)8               // Built-in LED (inverted: LOW=ON)
 
-// UART Protocol
-#define FRAME_START 0xA5
-#define CRC_POLY 0x31
+// UART protocol (frame layout, CMD_* and RSP_*) lives in app_link_proto.h
 
-// Commands from S3
-#define CMD_HELLO    0x01
-#define CMD_SET_MODE 0x02
-#define CMD_TRIGGER  0x03
-#define CMD_PING     0x04
+// Latency tracing: C3 → S3 TRIGGER carries the trace ID; the S3 echoes it in its
+// ACK followed by its own parse → handler and parse → ACK offsets (all little-endian)
+#define TRIGGER_TRACE_PAYLOAD_LEN   2   // trace_id u16
+#define ACK_TRACE_PAYLOAD_LEN       10  // trace_id u16, handler_offset_us u32, ack_offset_us u32
 
-// Commands from C3 (status notifications)
-#define CMD_STATUS_PAIRED    0x10
-#define CMD_STATUS_UNPAIRED  0x11
+#if CONFIG_TRIGGER_QUEUE_POLICY_DROP
+#define TRIGGER_QUEUE_POLICY APP_TRIGGER_POLICY_DROP
+#elif CONFIG_TRIGGER_QUEUE_POLICY_QUEUE
+#define TRIGGER_QUEUE_POLICY APP_TRIGGER_POLICY_QUEUE
+#else
+#define TRIGGER_QUEUE_POLICY APP_TRIGGER_POLICY_COALESCE
+#endif
 
-// Responses to S3
-#define RSP_ACK      0x80
-#define RSP_ERR      0x81
-#define RSP_BUSY     0x82
-#define RSP_DONE     0x83
+#ifdef CONFIG_TRIGGER_QUEUE_DEPTH
+#define TRIGGER_QUEUE_DEPTH CONFIG_TRIGGER_QUEUE_DEPTH
+#else
+#define TRIGGER_QUEUE_DEPTH 1
+#endif
 
-// Global UART state
-static uint8_t g_current_mode = 0;  // 0=Little Kid, 1=Big Kid, 2=Take One, 3=Closed
+static void skit_start(const app_trigger_t *trigger);
 
 // ===== LED Control Functions =====
 static void led_on() {
@@ -131,17 +189,53 @@ static void led_off() {
     gpio_set_level(LED_GPIO, 1);  // Inverted: HIGH = OFF
 }
 
-static void led_blink(int count, int on_ms, int off_ms) {
-    for (int i = 0; i < count; i++) {
-        led_on();
-        vTaskDelay(pdMS_TO_TICKS(on_ms));
+// Blink patterns run from an esp_timer so callers never block.
+// A new pattern replaces whatever is still playing.
+static portMUX_TYPE g_led_lock = portMUX_INITIALIZER_UNLOCKED;
+static int g_led_remaining = 0;  // blinks left, including the one in progress
+static int g_led_on_ms = 0;
+static int g_led_off_ms = 0;
+static bool g_led_lit = false;
+
+static void led_timer_cb(void *arg) {
+    int next_ms = 0;
+
+    portENTER_CRITICAL(&g_led_lock);
+    if (g_led_lit) {
         led_off();
-        if (i < count - 1) {
-            vTaskDelay(pdMS_TO_TICKS(off_ms));
+        g_led_lit = false;
+        if (--g_led_remaining > 0) {
+            next_ms = g_led_off_ms;
         }
+    } else if (g_led_remaining > 0) {
+        led_on();
+        g_led_lit = true;
+        next_ms = g_led_on_ms;
+    }
+    portEXIT_CRITICAL(&g_led_lock);
+
+    if (next_ms > 0) {
+        esp_timer_start_once(g_led_timer, next_ms * 1000);
     }
 }
 
+static void led_blink(int count, int on_ms, int off_ms) {
+    if (count <= 0) {
+        return;
+    }
+    esp_timer_stop(g_led_timer);
+
+    portENTER_CRITICAL(&g_led_lock);
+    g_led_remaining = count;
+    g_led_on_ms = on_ms;
+    g_led_off_ms = off_ms > 0 ? off_ms : 1;
+    g_led_lit = true;
+    led_on();
+    portEXIT_CRITICAL(&g_led_lock);
+
+    esp_timer_start_once(g_led_timer, on_ms * 1000);
+}
+
 // LED patterns for different events
 static void led_ack() {
     led_blink(2, 100, 100);  // 2 quick blinks
@@ -159,49 +253,20 @@ static void led_hello() {
     led_blink(3, 300, 300);  // 3 slow blinks
 }
 
-// ===== CRC8 Calculation =====
-static uint8_t crc8(const uint8_t *data, size_t len) {
-    uint8_t crc = 0x00;
-    for (size_t i = 0; i < len; i++) {
-        crc ^= data[i];
-        for (uint8_t j = 0; j < 8; j++) {
-            if (crc & 0x80) {
-                crc = (crc << 1) ^ CRC_POLY;
-            } else {
-                crc <<= 1;
-            }
-        }
-    }
-    return crc;
-}
-
 // ===== UART Helper Functions =====
 static bool uart_send_frame(uint8_t cmd, const uint8_t *payload = nullptr, uint8_t payload_len = 0) {
-    uint8_t frame[64];
-    uint8_t idx = 0;
-    
-    // Header
-    frame[idx++] = FRAME_START;
-    
-    // Length = CMD (1 byte) + PAYLOAD
-    uint8_t len = 1 + payload_len;
-    frame[idx++] = len;
-    
-    // Command/Response
-    frame[idx++] = cmd;
-    
-    // Payload
-    if (payload && payload_len > 0) {
-        memcpy(&frame[idx], payload, payload_len);
-        idx += payload_len;
+    uint8_t frame[LINK_MAX_FRAME];
+    int idx = (int)link_encode(cmd, payload, payload_len, frame, sizeof(frame));
+    if (idx == 0) {
+        ESP_LOGE(TAG, "UART TX: CMD=0x%02X payload too long (%d)", cmd, payload_len);
+        return false;
     }
     
-    // CRC (over LEN + CMD + PAYLOAD)
-    uint8_t crc = crc8(&frame[1], idx - 1);
-    frame[idx++] = crc;
-    
     // Send
+    xSemaphoreTakeRecursive(g_link_lock, portMAX_DELAY);
     int written = uart_write_bytes(UART_NUM, frame, idx);
+    xSemaphoreGiveRecursive(g_link_lock);
+    app_link_stats_tx(cmd, written == idx);
     
     ESP_LOGI(TAG, "UART TX: %d bytes, CMD=0x%02X", idx, cmd);
     
@@ -213,9 +278,25 @@ static bool uart_send_response(uint8_t response_cmd, const uint8_t *payload = nu
     return uart_send_frame(response_cmd, payload, payload_len);
 }
 
+// Send TRIGGER to the S3 tagged with the trace ID and mark when it has left the UART
+static bool uart_send_trigger(uint16_t trace_id) {
+    uint8_t payload[TRIGGER_TRACE_PAYLOAD_LEN] = { (uint8_t)(trace_id & 0xFF), (uint8_t)(trace_id >> 8) };
+    xSemaphoreTakeRecursive(g_link_lock, portMAX_DELAY);
+    bool sent = uart_send_frame(CMD_TRIGGER, payload, sizeof(payload));
+    uart_wait_tx_done(UART_NUM, pdMS_TO_TICKS(20));
+    xSemaphoreGiveRecursive(g_link_lock);
+    app_trace_mark(trace_id, APP_TRACE_UART_TX_DONE);
+    return sent;
+}
+
 // ===== Command Handlers =====
 static void handle_cmd_hello(const uint8_t *payload, uint8_t len) {
+    static bool s_first_hello = true;
     ESP_LOGI(TAG, "CMD: HELLO");
+    if (s_first_hello) {
+        s_first_hello = false;
+        ESP_LOGI(TAG, "BOOT_TIMING first_hello=%" PRId64 "ms", esp_timer_get_time() / 1000);
+    }
     uart_send_response(RSP_ACK);  // Send ACK FIRST
     led_hello();  // Then do LED pattern
 }
@@ -229,16 +310,63 @@ static void handle_cmd_ping(const uint8_t *payload, uint8_t len) {
 static void handle_cmd_trigger(const uint8_t *payload, uint8_t len) {
     ESP_LOGI(TAG, "CMD: TRIGGER");
     
-    if (g_pulse_active) {
-        // Already running
+    app_trigger_t trigger = { APP_TRIGGER_SRC_LINK, 0 };
+    app_trigger_result_t result = app_trigger_queue_submit(&g_trigger_queue, &trigger);
+    if (result == APP_TRIGGER_DROPPED) {
+        // Already running and the policy does not queue
         ESP_LOGW(TAG, "Skit already active - sending BUSY");
         uart_send_response(RSP_BUSY);  // Send response FIRST
+        return;
+    }
+
+    // ACK carries the number of skits waiting; a DONE follows each completed skit
+    uint8_t pending = app_trigger_queue_pending(&g_trigger_queue);
+    uart_send_response(RSP_ACK, &pending, 1);  // Send response FIRST
+    led_command_sent();  // Then LED
+    if (result == APP_TRIGGER_STARTED) {
+        skit_start(&trigger);
     } else {
-        uart_send_response(RSP_ACK);  // Send response FIRST
-        led_command_sent();  // Then LED
-        // TODO: In future, actually trigger skit here
-        ESP_LOGI(TAG, "Trigger acknowledged (placeholder)");
+        ESP_LOGI(TAG, "Skit busy - trigger %s (%d pending)",
+                 result == APP_TRIGGER_QUEUED ? "queued" : "coalesced", pending);
+    }
+}
+
+static void handle_cmd_wd_stats(const uint8_t *payload, uint8_t len) {
+    uint8_t first = len >= 1 ? payload[0] : 0;
+    ESP_LOGI(TAG, "CMD: WD_STATS (from path %u)", first);
+    uint8_t summary[LINK_MAX_LEN - 1];
+    size_t size = app_wd_encode(first, summary, sizeof(summary));
+    uart_send_response(RSP_ACK, summary, (uint8_t)size);
+}
+
+static void handle_cmd_history(const uint8_t *payload, uint8_t len) {
+    uint16_t minutes = len >= 2 ? link_get_le16(payload) : 0;
+    ESP_LOGI(TAG, "CMD: HISTORY (%u min)", minutes);
+    app_history_summary_t summary;
+    if (app_history_summary(minutes, &summary) != ESP_OK) {
+        uart_send_response(RSP_ERR);
+        return;
     }
+    uint8_t out[APP_HISTORY_SUMMARY_SIZE];
+    size_t size = app_history_encode_summary(&summary, out, sizeof(out));
+    uart_send_response(RSP_ACK, out, (uint8_t)size);
+}
+
+// The S3 debounces the touch sensor and reports how long ago the change
+// happened, so the fusion sees the real time of the touch
+static void handle_cmd_touch(const uint8_t *payload, uint8_t len, int64_t received_us) {
+    if (len < 1) {
+        ESP_LOGE(TAG, "TOUCH: missing payload");
+        uart_send_response(RSP_ERR);
+        return;
+    }
+    uint16_t age_ms = len >= 3 ? link_get_le16(&payload[1]) : 0;
+    ESP_LOGI(TAG, "CMD: TOUCH %s (%u ms ago)", payload[0] ? "on" : "off", age_ms);
+    app_presence_input(payload[0] ? APP_PRESENCE_IN_TOUCH_ON : APP_PRESENCE_IN_TOUCH_OFF,
+                       received_us - (int64_t)age_ms * 1000);
+    uint8_t out[2];
+    out[0] = (uint8_t)app_presence_get(&out[1]);
+    uart_send_response(RSP_ACK, out, sizeof(out));
 }
 
 static void handle_cmd_set_mode(const uint8_t *payload, uint8_t len) {
@@ -257,7 +385,7 @@ static void handle_cmd_set_mode(const uint8_t *payload, uint8_t len) {
         return;
     }
     
-    g_current_mode = mode;
+    g_node.current_mode = mode;
     ESP_LOGI(TAG, "CMD: SET_MODE -> %d", mode);
     
     uart_send_response(RSP_ACK);  // Send response FIRST
@@ -266,203 +394,258 @@ static void handle_cmd_set_mode(const uint8_t *payload, uint8_t len) {
     led_blink(mode + 1, 200, 200);  // LED after response
 }
 
-// ===== Mode Synchronization Task =====
-// Debounced mode switching: waits 200ms after last tap, then executes once
-// Plus a 5s safety cleanup to ensure HomeKit converges to correct state
-static void mode_sync_task(void *arg)
+// ===== Mode Synchronization =====
+// Debounced mode switching: executes once MODE_DEBOUNCE_MS after the last tap,
+// plus a one-time safety cleanup MODE_CLEANUP_MS later so HomeKit converges.
+// Both steps are esp_timer one-shots that post events; the work runs in the dispatcher.
+static const char *mode_names[] = {"Little Kid", "Big Kid", "Take One", "Closed"};
+
+static void mode_timer_cb(void *arg)
 {
-    const char* mode_names[] = {"Little Kid", "Big Kid", "Take One", "Closed"};
-    
-    while (1) {
-        int64_t now = esp_timer_get_time();
-        int64_t time_since_tap_ms = (now - g_last_tap_time) / 1000;
-        int64_t time_since_exec_ms = (now - g_last_execution_time) / 1000;
-        
-        // PRIMARY EXECUTION: 200ms after last tap
-        if (g_target_mode >= 0 && g_target_mode != g_current_mode && time_since_tap_ms >= 200) {
-            ESP_LOGI(TAG, "🎯 Debounce complete! Executing mode change to %d (%s)", 
-                     g_target_mode, mode_names[g_target_mode]);
-            
-            // Update current mode
-            g_current_mode = g_target_mode;
-            g_target_mode = -1; // Clear pending
-            
-            // Send UART command to S3
-            uint8_t payload[1] = { (uint8_t)g_current_mode };
-            uart_send_frame(CMD_SET_MODE, payload, 1);
-            
-            // Update HomeKit state - use report() to FORCE updates even if values match
-            g_syncing_modes = true;
-            
-            ESP_LOGI(TAG, "📤 Setting mode %d ON, all others OFF...", g_current_mode);
-            
-            // Turn OFF all modes EXCEPT the target mode
-            esp_matter_attr_val_t off_val = esp_matter_bool(false);
-            for (int i = 0; i < 4; i++) {
-                if (i != g_current_mode) {  // Skip the target mode!
-                    esp_err_t err = attribute::report(g_mode_plugin_ids[i], chip::app::Clusters::OnOff::Id,
-                                                       chip::app::Clusters::OnOff::Attributes::OnOff::Id, &off_val);
-                    ESP_LOGI(TAG, "  Mode %d → OFF (result: %s)", i, esp_err_to_name(err));
-                    vTaskDelay(pdMS_TO_TICKS(10)); // Small delay between each
-                }
-            }
-            
-            // Small delay before turning ON the target
-            vTaskDelay(pdMS_TO_TICKS(50));
-            
-            // Turn ON the target mode
-            esp_matter_attr_val_t on_val = esp_matter_bool(true);
-            esp_err_t err = attribute::report(g_mode_plugin_ids[g_current_mode], chip::app::Clusters::OnOff::Id,
-                                               chip::app::Clusters::OnOff::Attributes::OnOff::Id, &on_val);
-            ESP_LOGI(TAG, "  Mode %d → ON (result: %s)", g_current_mode, esp_err_to_name(err));
-            
-            g_syncing_modes = false;
-            g_last_execution_time = now;
-            
-            ESP_LOGI(TAG, "✅ Mode change complete: %s is now active", mode_names[g_current_mode]);
-        }
-        
-        // SAFETY CLEANUP: ONCE at 5s after last execution, re-assert current mode
-        // This ensures HomeKit converges to correct state even if it got confused
-        static bool cleanup_done = false;
-        if (time_since_exec_ms >= 5000 && time_since_tap_ms >= 5000 && !cleanup_done) {
-            ESP_LOGI(TAG, "🔧 Safety cleanup: Re-asserting mode %d (%s)", 
-                     g_current_mode, mode_names[g_current_mode]);
-            
-            g_syncing_modes = true;
-            
-            ESP_LOGI(TAG, "🧹 Cleanup: Setting mode %d ON, all others OFF...", g_current_mode);
-            
-            // Turn OFF all modes EXCEPT the target mode
-            esp_matter_attr_val_t off_val = esp_matter_bool(false);
-            for (int i = 0; i < 4; i++) {
-                if (i != g_current_mode) {  // Skip the target mode!
-                    esp_err_t err = attribute::report(g_mode_plugin_ids[i], chip::app::Clusters::OnOff::Id,
-                                                       chip::app::Clusters::OnOff::Attributes::OnOff::Id, &off_val);
-                    ESP_LOGI(TAG, "  Cleanup mode %d → OFF (result: %s)", i, esp_err_to_name(err));
-                    vTaskDelay(pdMS_TO_TICKS(10)); // Small delay between each
-                }
-            }
-            
-            vTaskDelay(pdMS_TO_TICKS(50));
-            
-            // Turn ON the target mode
-            esp_matter_attr_val_t on_val = esp_matter_bool(true);
-            esp_err_t err = attribute::report(g_mode_plugin_ids[g_current_mode], chip::app::Clusters::OnOff::Id,
-                                               chip::app::Clusters::OnOff::Attributes::OnOff::Id, &on_val);
-            ESP_LOGI(TAG, "  Cleanup mode %d → ON (result: %s)", g_current_mode, esp_err_to_name(err));
-            
-            g_syncing_modes = false;
-            cleanup_done = true; // Mark as done so we only do this ONCE per mode change
-            
-            ESP_LOGI(TAG, "✅ Safety cleanup complete (will not run again until next mode change)");
-        }
-        
-        // Reset cleanup_done flag when user taps a new mode
-        if (g_target_mode >= 0 && cleanup_done) {
-            cleanup_done = false;
-            ESP_LOGD(TAG, "New mode tap detected - cleanup flag reset");
+    app_event_post_value((app_event_type_t)(intptr_t)arg, 0);
+}
+
+// Report target mode ON and all others OFF - use report() to FORCE updates even if values match.
+// app_node_model runs the steps; the gaps between them are esp_timer one-shots
+// posting APP_EVT_MODE_REPORT, so the dispatcher never sleeps.
+static volatile int32_t g_mode_report_timer_seq = 0;   // Sequence the pending one-shot belongs to
+
+// esp_timer task: tag the step with the sequence that scheduled it
+static void mode_report_timer_cb(void *arg)
+{
+    app_event_post_value(APP_EVT_MODE_REPORT, g_mode_report_timer_seq);
+}
+
+static int node_report_onoff(void *ctx, uint16_t endpoint_id, bool on)
+{
+    esp_matter_attr_val_t val = esp_matter_bool(on);
+    esp_err_t err = app_matter_report(endpoint_id, OnOff::Id, OnOff::Attributes::OnOff::Id, &val);
+    ESP_LOGI(TAG, "  %s endpoint %d → %s (result: %s)", g_node.label, endpoint_id, on ? "ON" : "OFF",
+             esp_err_to_name(err));
+    return err;
+}
+
+// Dispatcher: the first step goes straight to the queue, later ones wait for the one-shot
+static void node_schedule_step(void *ctx, uint32_t delay_ms, int32_t seq)
+{
+    esp_timer_stop(g_mode_report_timer);
+    if (delay_ms == 0) {
+        app_event_post_value(APP_EVT_MODE_REPORT, seq);
+        return;
+    }
+    g_mode_report_timer_seq = seq;
+    esp_timer_start_once(g_mode_report_timer, delay_ms * 1000);
+}
+
+static const app_node_platform_t g_node_platform = {
+    .report_onoff = node_report_onoff,
+    .schedule_step = node_schedule_step,
+    .ctx = NULL,
+};
+
+static void on_mode_report(const app_event_t *event)
+{
+    if (app_node_model_report_step(&g_node, event->data.value)) {
+        ESP_LOGI(TAG, "✅ %s report complete: %s is now active", g_node.label, mode_names[g_node.current_mode]);
+    }
+}
+
+static void on_mode_tap(const app_event_t *event)
+{
+    g_target_mode = event->data.value;
+
+    // A new tap restarts the debounce window and cancels any pending cleanup
+    esp_timer_stop(g_mode_cleanup_timer);
+    esp_timer_stop(g_mode_debounce_timer);
+    esp_timer_start_once(g_mode_debounce_timer, MODE_DEBOUNCE_MS * 1000);
+    ESP_LOGI(TAG, "👆 User tapped mode %d - debouncing (%dms)...", g_target_mode, MODE_DEBOUNCE_MS);
+}
+
+static void on_mode_debounced(const app_event_t *event)
+{
+    if (g_target_mode >= 0 && g_target_mode != g_node.current_mode) {
+        ESP_LOGI(TAG, "🎯 Debounce complete! Executing mode change to %d (%s)",
+                 g_target_mode, mode_names[g_target_mode]);
+
+        // Send UART command to S3
+        uint8_t payload[1] = { (uint8_t)g_target_mode };
+        uart_send_frame(CMD_SET_MODE, payload, 1);
+
+        // Makes it the current mode
+        ESP_LOGI(TAG, "📤 Setting mode %d ON, all others OFF...", g_target_mode);
+        app_node_model_report_start(&g_node, (uint8_t)g_target_mode, "Mode");
+    }
+    g_target_mode = -1; // Clear pending
+
+    // SAFETY CLEANUP: ONCE after the last execution, re-assert current mode
+    esp_timer_start_once(g_mode_cleanup_timer, MODE_CLEANUP_MS * 1000);
+}
+
+static void on_mode_cleanup(const app_event_t *event)
+{
+    ESP_LOGI(TAG, "🧹 Safety cleanup: Re-asserting mode %d (%s)",
+             g_node.current_mode, mode_names[g_node.current_mode]);
+    app_node_model_report_start(&g_node, g_node.current_mode, "Cleanup");  // Will not run again until the next mode change
+}
+
+// ===== Link Frame Dispatch =====
+static void on_link_frame(const app_event_t *event)
+{
+    uint8_t cmd = event->data.frame.cmd;
+    uint8_t payload_len = event->data.frame.len;
+    const uint8_t *payload = (payload_len > 0) ? event->data.frame.payload : nullptr;
+#if CONFIG_APP_IDLE_SLEEP
+    app_power_link_frame();
+#endif
+
+    // Check if this is a response (0x80+) or command (0x01-0x7F)
+    if (cmd >= 0x80) {
+        // This is a response from S3 - just log it (don't dispatch)
+        ESP_LOGI(TAG, "Received response from S3: 0x%02X", cmd);
+        if (cmd == RSP_ACK && payload_len >= ACK_TRACE_PAYLOAD_LEN) {
+            uint16_t trace_id = link_get_le16(&payload[0]);
+            app_trace_mark_s3_ack(trace_id, event->posted_us, link_get_le32(&payload[2]), link_get_le32(&payload[6]));
         }
-        
-        // Run this task every 10ms
-        vTaskDelay(pdMS_TO_TICKS(10));
+        return;
+    }
+
+    if (payload_len > APP_EVENT_MAX_PAYLOAD) {
+        ESP_LOGE(TAG, "Command 0x%02X payload too long: %d", cmd, payload_len);
+        uart_send_response(RSP_ERR);
+        led_error();
+        return;
     }
+
+    // This is a command - dispatch it
+    switch (cmd) {
+        case CMD_HELLO:
+            handle_cmd_hello(payload, payload_len);
+            break;
+        case CMD_PING:
+            handle_cmd_ping(payload, payload_len);
+            break;
+        case CMD_TRIGGER:
+            handle_cmd_trigger(payload, payload_len);
+            break;
+        case CMD_SET_MODE:
+            handle_cmd_set_mode(payload, payload_len);
+            break;
+        case CMD_WD_STATS:
+            handle_cmd_wd_stats(payload, payload_len);
+            break;
+        case CMD_HISTORY:
+            handle_cmd_history(payload, payload_len);
+            break;
+        case CMD_TOUCH:
+            handle_cmd_touch(payload, payload_len, event->posted_us);
+            break;
+        default:
+            ESP_LOGW(TAG, "Unknown command: 0x%02X", cmd);
+            uart_send_response(RSP_ERR);
+            led_error();
+            break;
+    }
+}
+
+static void on_link_crc_error(const app_event_t *event)
+{
+    led_error();
 }
 
 // ===== UART RX Task =====
+// Ask the RX task to reinstall the UART driver with `size`-byte ring buffers and
+// wait up to `timeout` for it. Returns false if the RX task has not applied it yet.
+static bool link_set_buffer_size(size_t size, TickType_t timeout)
+{
+    xSemaphoreTake(g_link_buf_done, 0);  // Completion of an earlier request nobody waited for
+    g_link_buf_request = size;
+    return xSemaphoreTake(g_link_buf_done, timeout) == pdTRUE;
+}
+
+// Runs in the RX task, the only reader. Returns the new read buffer, or the old one on failure.
+static uint8_t *link_resize_buffers(uint8_t *data, size_t *buf_size, size_t new_size)
+{
+    uint8_t *new_data = (uint8_t *)realloc(data, new_size);
+    if (new_data == NULL) {
+        ESP_LOGW(TAG, "UART buffers stay at %d bytes: no memory for %d", (int)*buf_size, (int)new_size);
+        return data;
+    }
+
+    xSemaphoreTakeRecursive(g_link_lock, portMAX_DELAY);
+    uart_wait_tx_done(UART_NUM, pdMS_TO_TICKS(50));
+    uart_driver_delete(UART_NUM);
+    esp_err_t err = uart_driver_install(UART_NUM, new_size, new_size, 0, NULL, 0);
+    if (err != ESP_OK) {
+        // Fall back to the boot size so the link keeps working
+        new_size = UART_BUF_SIZE;
+        uart_driver_install(UART_NUM, new_size, new_size, 0, NULL, 0);
+    }
+    xSemaphoreGiveRecursive(g_link_lock);
+
+    ESP_LOGI(TAG, "UART buffers %d -> %d bytes (free heap %u)", (int)*buf_size, (int)new_size,
+             (unsigned)heap_caps_get_free_size(MALLOC_CAP_8BIT));
+    *buf_size = new_size;
+    return new_data;
+}
+
+// Only frames bytes and posts events; all handling happens in the dispatcher.
 static void uart_rx_task(void *arg) {
-    uint8_t *data = (uint8_t *)malloc(UART_BUF_SIZE);
-    uint8_t frame_buf[64];
-    uint8_t buf_idx = 0;
-    uint8_t state = 0;  // 0=wait start, 1=len, 2=cmd+payload, 3=crc
-    uint8_t frame_len = 0;
-    uint8_t bytes_to_read = 0;
-    uint8_t cmd = 0;
+    size_t buf_size = UART_BUF_SIZE;
+    uint8_t *data = (uint8_t *)malloc(buf_size);
+    link_parser_t parser;
+    link_parser_init(&parser);
     
     ESP_LOGI(TAG, "UART RX task started");
     
     while (1) {
-        int len = uart_read_bytes(UART_NUM, data, UART_BUF_SIZE, pdMS_TO_TICKS(100));
+        size_t request = g_link_buf_request;
+        if (request != 0) {
+            g_link_buf_request = 0;
+            if (request != buf_size) {
+                // Bytes still in the old ring buffer are lost; the S3 retries on a missing ACK
+                data = link_resize_buffers(data, &buf_size, request);
+            }
+            xSemaphoreGive(g_link_buf_done);
+        }
+
+#if CONFIG_APP_IDLE_SLEEP
+        // Idle: wait long, but for the first byte only, so a frame after the
+        // wake is read as soon as it starts
+        bool idle = app_power_is_idle();
+#else
+        bool idle = false;
+#endif
+        int len = uart_read_bytes(UART_NUM, data, idle ? 1 : buf_size, pdMS_TO_TICKS(idle ? IDLE_POLL_MS : 100));
+        app_wd_checkin(g_wd_uart_rx);
         
         for (int i = 0; i < len; i++) {
-            uint8_t b = data[i];
-            
-            switch (state) {
-                case 0:  // Wait for start byte
-                    if (b == FRAME_START) {
-                        frame_buf[buf_idx++] = b;
-                        state = 1;
+            link_frame_t frame;
+            switch (link_parser_feed(&parser, data[i], &frame)) {
+                case LINK_PARSE_FRAME: {
+                    // Valid frame - hand it to the dispatcher, never handle it here
+                    app_event_t event = {};
+                    event.type = APP_EVT_LINK_FRAME;
+                    event.data.frame.cmd = frame.cmd;
+                    event.data.frame.len = frame.len;
+                    uint8_t copy_len = frame.len;
+                    if (copy_len > APP_EVENT_MAX_PAYLOAD) {
+                        copy_len = APP_EVENT_MAX_PAYLOAD;  // Dispatcher rejects it with ERR
                     }
+                    memcpy(event.data.frame.payload, frame.payload, copy_len);
+                    app_link_stats_rx(frame.cmd, esp_timer_get_time());
+                    app_event_post(&event);
                     break;
-                    
-                case 1:  // Length byte
-                    frame_buf[buf_idx++] = b;
-                    frame_len = b;
-                    if (frame_len == 0 || frame_len > 60) {
-                        ESP_LOGW(TAG, "Invalid frame length: %d", frame_len);
-                        state = 0;
-                        buf_idx = 0;
-                    } else {
-                        bytes_to_read = frame_len;  // CMD + payload
-                        state = 2;
-                    }
+                }
+                case LINK_PARSE_CRC_ERROR:
+                    ESP_LOGE(TAG, "CRC error: expected 0x%02X, got 0x%02X", frame.crc_expected, frame.crc_received);
+                    app_link_stats_crc_error();
+                    app_event_post_value(APP_EVT_LINK_CRC_ERROR, frame.crc_received);
                     break;
-                    
-                case 2:  // CMD + Payload
-                    frame_buf[buf_idx++] = b;
-                    if (buf_idx == 3) {  // Just read CMD byte
-                        cmd = b;
-                    }
-                    bytes_to_read--;
-                    if (bytes_to_read == 0) {
-                        state = 3;  // Next is CRC
-                    }
+                case LINK_PARSE_LENGTH_ERROR:
+                    ESP_LOGW(TAG, "Invalid frame length: %d", data[i]);
+                    app_link_stats_length_error();
                     break;
-                    
-                case 3:  // CRC
-                    frame_buf[buf_idx++] = b;
-                    uint8_t received_crc = b;
-                    uint8_t calc_crc = crc8(&frame_buf[1], buf_idx - 2);
-                    
-                    if (calc_crc == received_crc) {
-                        // Valid frame - extract payload
-                        uint8_t payload_len = frame_len - 1;  // Exclude CMD
-                        uint8_t *payload = (payload_len > 0) ? &frame_buf[3] : nullptr;
-                        
-                        // Check if this is a response (0x80+) or command (0x01-0x7F)
-                        if (cmd >= 0x80) {
-                            // This is a response from S3 - just log it (don't dispatch)
-                            ESP_LOGI(TAG, "Received response from S3: 0x%02X", cmd);
-                        } else {
-                            // This is a command - dispatch it
-                            switch (cmd) {
-                                case CMD_HELLO:
-                                    handle_cmd_hello(payload, payload_len);
-                                    break;
-                                case CMD_PING:
-                                    handle_cmd_ping(payload, payload_len);
-                                    break;
-                                case CMD_TRIGGER:
-                                    handle_cmd_trigger(payload, payload_len);
-                                    break;
-                                case CMD_SET_MODE:
-                                    handle_cmd_set_mode(payload, payload_len);
-                                    break;
-                                default:
-                                    ESP_LOGW(TAG, "Unknown command: 0x%02X", cmd);
-                                    uart_send_response(RSP_ERR);
-                                    led_error();
-                                    break;
-                            }
-                        }
-                    } else {
-                        ESP_LOGE(TAG, "CRC error: expected 0x%02X, got 0x%02X", calc_crc, received_crc);
-                        led_error();
-                    }
-                    
-                    // Reset for next frame
-                    state = 0;
-                    buf_idx = 0;
+                default:
                     break;
             }
         }
@@ -479,23 +662,186 @@ static void open_commissioning_window_if_necessary()
     VerifyOrReturn(commissionMgr.IsCommissioningWindowOpen() == false);
 
     // After removing last fabric, this example does not remove the Wi-Fi credentials
-    // and still has IP connectivity so, only advertising on DNS-SD.
-    CHIP_ERROR err = commissionMgr.OpenBasicCommissioningWindow(chip::System::Clock::Seconds16(300),
-                                    chip::CommissioningWindowAdvertisement::kDnssdOnly);
+    // and still has IP connectivity, so DNS-SD always works. BLE is offered too
+    // if it can be brought back after the post-commissioning reclaim.
+    chip::CommissioningWindowAdvertisement advertisement = chip::CommissioningWindowAdvertisement::kDnssdOnly;
+#if CONFIG_APP_BLE_RECLAIM
+    // Hand the borrowed RAM back to BLE first: the old buffers are only freed
+    // once the RX task has reinstalled the driver
+    if (app_ble_is_reclaimed() && !link_set_buffer_size(UART_BUF_SIZE, pdMS_TO_TICKS(LINK_RESIZE_WAIT_MS))) {
+        ESP_LOGW(TAG, "UART buffers not shrunk in %d ms, BLE stays down", LINK_RESIZE_WAIT_MS);
+    } else if (app_ble_restore() == ESP_OK) {
+        advertisement = chip::CommissioningWindowAdvertisement::kAllSupported;
+    }
+#endif
+    CHIP_ERROR err = commissionMgr.OpenBasicCommissioningWindow(chip::System::Clock::Seconds16(300), advertisement);
     if (err != CHIP_NO_ERROR)
     {
         ESP_LOGE(TAG, "Failed to open commissioning window, err:%" CHIP_ERROR_FORMAT, err.Format());
     }
 }
 
+static void on_commissioned(const app_event_t *event)
+{
+    uart_send_frame(CMD_STATUS_PAIRED, nullptr, 0);
+    led_blink(5, 100, 100);  // Celebration blinks!
+}
+
+static void on_fabric_removed(const app_event_t *event)
+{
+    uart_send_frame(CMD_STATUS_UNPAIRED, nullptr, 0);
+}
+
+#if CONFIG_APP_PIR_SENSOR
+// ===== PIR Occupancy =====
+#if CONFIG_APP_IDLE_SLEEP
+// esp_timer task: nothing needs watching until motion, so the periodic
+// wake-ups that would cut every light sleep short are stretched or stopped
+static void on_power_idle(void)
+{
+    app_wd_suspend(true);
+    app_event_bus_set_heartbeat_period(IDLE_POLL_MS);
+}
+
+// PIR task: the S3 may have sent frames into the void while we slept; a PING
+// gets both ends talking again and its ACK marks the link ready
+static void on_power_wake(void)
+{
+    app_event_bus_set_heartbeat_period(APP_EVENT_HEARTBEAT_MS);
+    app_wd_suspend(false);
+    uart_send_frame(CMD_PING, nullptr, 0);
+}
+
+static void on_pir_wake(int64_t wake_us, void *user_data)
+{
+    app_power_wake(wake_us);
+}
+#endif
+
+// PIR task: there is no occupancy endpoint yet, so the report goes to the
+// presence fusion and the history log
+static void on_pir_occupancy(uint16_t endpoint_id, bool occupied, void *user_data)
+{
+    app_presence_input(occupied ? APP_PRESENCE_IN_PIR_ON : APP_PRESENCE_IN_PIR_OFF, esp_timer_get_time());
+    app_history_set_occupancy(occupied);
+#if CONFIG_APP_IDLE_SLEEP
+    app_power_occupancy(occupied);
+#endif
+}
+
+static esp_err_t pir_start(void)
+{
+    pir_sensor_config_t pir_config = {};
+    pir_config.cb = on_pir_occupancy;
+#if CONFIG_APP_IDLE_SLEEP
+    pir_config.wake_cb = on_pir_wake;
+#endif
+    pir_config.hw_glitch_filter = true;
+    return pir_sensor_init(&pir_config);
+}
+
+#if CONFIG_APP_IDLE_SLEEP
+// ===== Idle Sleep =====
+static esp_err_t idle_sleep_start(void)
+{
+    app_power_config_t power_config = {};
+    power_config.arm_wakeup = pir_sensor_arm_wakeup;
+    power_config.on_wake = on_power_wake;
+    power_config.on_idle = on_power_idle;
+    return app_power_init(&power_config);
+}
+#endif
+#endif
+
+#if CONFIG_APP_SHTC3
+// ===== Temperature / Humidity =====
+// SHTC3 sampling task: there are no sensor endpoints yet, so readings go to
+// the history log. Each channel goes through a median-of-3 (one glitchy read
+// never lands) and a short mean; a failed read is dropped there, leaving
+// the last good value in place. After SHTC3_LOST_AFTER failed reads in a row
+// (30 s at the 5 s interval, within one history period) the value is set to
+// unknown, so a dead sensor is logged as null rather than as its last reading.
+// The driver's integer callbacks give 0.01 C / 0.01 %RH, the history log's unit.
+#define SHTC3_LOST_AFTER    6
+
+static const app_sensor_agg_config_t g_temperature_agg_config = {
+    .window = 4, .median = 3, .min_interval_ms = 0, .max_interval_ms = 60000, .report_delta = 5,
+    .lost_after = SHTC3_LOST_AFTER,
+};
+static const app_sensor_agg_config_t g_humidity_agg_config = {
+    .window = 4, .median = 3, .min_interval_ms = 0, .max_interval_ms = 60000, .report_delta = 25,
+    .lost_after = SHTC3_LOST_AFTER,
+};
+static app_sensor_agg_t g_temperature_agg;     // Only the sampling task touches these
+static app_sensor_agg_t g_humidity_agg;
+
+static void on_shtc3_temperature(uint16_t endpoint_id, int32_t centi, bool valid, void *user_data)
+{
+    int32_t out;
+    switch (app_sensor_agg_push(&g_temperature_agg, centi, valid, (uint32_t)(esp_timer_get_time() / 1000), &out)) {
+    case APP_SENSOR_AGG_REPORT:
+        app_history_set_temperature((int16_t)out);
+        break;
+    case APP_SENSOR_AGG_LOST:
+        ESP_LOGW(TAG, "Temperature lost after %d failed reads", SHTC3_LOST_AFTER);
+        app_history_set_temperature(APP_HISTORY_TEMP_INVALID);
+        break;
+    default:
+        break;
+    }
+}
+
+static void on_shtc3_humidity(uint16_t endpoint_id, int32_t centi, bool valid, void *user_data)
+{
+    int32_t out;
+    switch (app_sensor_agg_push(&g_humidity_agg, centi, valid, (uint32_t)(esp_timer_get_time() / 1000), &out)) {
+    case APP_SENSOR_AGG_REPORT:
+        app_history_set_humidity((uint16_t)out);
+        break;
+    case APP_SENSOR_AGG_LOST:
+        ESP_LOGW(TAG, "Humidity lost after %d failed reads", SHTC3_LOST_AFTER);
+        app_history_set_humidity(APP_HISTORY_HUM_INVALID);
+        break;
+    default:
+        break;
+    }
+}
+
+static shtc3_sensor_config_t g_shtc3_config;    // The driver keeps a pointer to it
+
+static esp_err_t sensor_start(void)
+{
+    app_sensor_agg_init(&g_temperature_agg, &g_temperature_agg_config);
+    app_sensor_agg_init(&g_humidity_agg, &g_humidity_agg_config);
+    g_shtc3_config.temperature.centi_cb = on_shtc3_temperature;
+    g_shtc3_config.humidity.centi_cb = on_shtc3_humidity;
+    return shtc3_sensor_init(&g_shtc3_config);
+}
+#endif
+
+#if CONFIG_APP_BLE_RECLAIM
+// Matter thread: BLE is down, spend part of its RAM on bigger link buffers
+static void on_ble_reclaimed(int gained_bytes)
+{
+    // Only grow if BLE gave back at least what the bigger buffers take
+    if (gained_bytes >= UART_BUF_COPIES * (UART_BUF_SIZE_RECLAIMED - UART_BUF_SIZE)) {
+        link_set_buffer_size(UART_BUF_SIZE_RECLAIMED, 0);  // Applied on the RX task's next pass
+    } else {
+        ESP_LOGW(TAG, "Only %d bytes reclaimed, keeping UART buffers at %d", gained_bytes, UART_BUF_SIZE);
+    }
+}
+#endif
+
 static void app_event_cb(const ChipDeviceEvent *event, intptr_t arg)
 {
     switch (event->Type) {
     case chip::DeviceLayer::DeviceEventType::kCommissioningComplete:
         ESP_LOGI(TAG, "Commissioning complete - notifying S3");
-        // Notify S3 that we're now paired with HomeKit
-        uart_send_frame(CMD_STATUS_PAIRED, nullptr, 0);
-        led_blink(5, 100, 100);  // Celebration blinks!
+        // Notify S3 that we're now paired with HomeKit (sent from the dispatcher)
+        app_event_post_value(APP_EVT_COMMISSIONED, 0);
+#if CONFIG_APP_BLE_RECLAIM
+        app_ble_reclaim_start(on_ble_reclaimed);
+#endif
         break;
 
     case chip::DeviceLayer::DeviceEventType::kFailSafeTimerExpired:
@@ -504,13 +850,16 @@ static void app_event_cb(const ChipDeviceEvent *event, intptr_t arg)
 
     case chip::DeviceLayer::DeviceEventType::kFabricRemoved:
         ESP_LOGI(TAG, "Fabric removed successfully - notifying S3");
-        // Notify S3 that we're unpaired
-        uart_send_frame(CMD_STATUS_UNPAIRED, nullptr, 0);
+        // Notify S3 that we're unpaired (sent from the dispatcher)
+        app_event_post_value(APP_EVT_FABRIC_REMOVED, 0);
         open_commissioning_window_if_necessary();
         break;
 
     case chip::DeviceLayer::DeviceEventType::kBLEDeinitialized:
         ESP_LOGI(TAG, "BLE deinitialized and memory reclaimed");
+#if CONFIG_APP_BLE_RECLAIM
+        app_ble_reclaim_on_deinitialized();
+#endif
         break;
 
     default:
@@ -550,7 +899,15 @@ static esp_err_t init_signal_gpio()
     return ESP_OK;
 }
 
-static void start_pulse()
+// Runs in the esp_timer task: end the pulse on the pin right away and let the
+// dispatcher do the (slow) Matter write-back.
+static void pulse_timer_cb(void *arg)
+{
+    gpio_set_level(SIGNAL_GPIO, 0);
+    app_event_post_value(APP_EVT_PULSE_END, g_pulse_generation);
+}
+
+static void start_pulse(uint16_t trace_id = 0)
 {
     if (g_pulse_active) {
         ESP_LOGW(TAG, "Pulse already active, ignoring");
@@ -558,44 +915,118 @@ static void start_pulse()
     }
     
     g_pulse_active = true;
+    g_pulse_generation++;
     gpio_set_level(SIGNAL_GPIO, 1);
+    app_trace_mark(trace_id, APP_TRACE_GPIO_EDGE);
     ESP_LOGI(TAG, "Pulse started - GPIO %d HIGH", SIGNAL_GPIO);
     
     // Schedule pulse end
-    esp_timer_create_args_t timer_args = {
-        .callback = [](void* arg) {
-            gpio_set_level(SIGNAL_GPIO, 0);
-            g_pulse_active = false;
-            ESP_LOGI(TAG, "Pulse ended - GPIO %d LOW", SIGNAL_GPIO);
-            
-            // Small delay to ensure GPIO state is stable
-            vTaskDelay(pdMS_TO_TICKS(10));
-            
-            // Update Matter attribute back to OFF
-            esp_matter_attr_val_t val = esp_matter_bool(false);
-            esp_err_t err = attribute::update(g_switch_endpoint_id, OnOff::Id, OnOff::Attributes::OnOff::Id, &val);
-            if (err == ESP_OK) {
-                ESP_LOGI(TAG, "Matter attribute updated to OFF successfully");
-            } else {
-                ESP_LOGE(TAG, "Failed to update Matter attribute to OFF: %s", esp_err_to_name(err));
-            }
-        },
-        .arg = nullptr,
-        .name = "pulse_timer"
-    };
-    
-    esp_timer_handle_t timer;
-    esp_timer_create(&timer_args, &timer);
-    esp_timer_start_once(timer, PULSE_DURATION_MS * 1000); // Convert to microseconds
+    esp_timer_start_once(g_pulse_timer, PULSE_DURATION_MS * 1000); // Convert to microseconds
 }
 
 static void stop_pulse()
 {
+    esp_timer_stop(g_pulse_timer);
     gpio_set_level(SIGNAL_GPIO, 0);
     g_pulse_active = false;
     ESP_LOGI(TAG, "Pulse stopped - GPIO %d LOW", SIGNAL_GPIO);
 }
 
+// ===== Skit Triggers =====
+// A skit is one signal pulse. HomeKit triggers are also forwarded to the S3;
+// S3 triggers already came from there. Every finished skit sends DONE to the S3.
+static void skit_start(const app_trigger_t *trigger)
+{
+    app_matter_stats_count_trigger();
+#if CONFIG_TRIGGER_SWITCH_EVENTS
+    // Stateless: no OFF write-back, nothing for HomeKit to show as ON
+    app_matter_switch_press(g_trigger_switch_endpoint_id);
+#endif
+    if (trigger->source == APP_TRIGGER_SRC_HOMEKIT) {
+        ESP_LOGI(TAG, "HomeKit TRIGGER - sending UART command to S3 (trace %u)", trigger->trace_id);
+        uart_send_trigger(trigger->trace_id);
+    }
+    start_pulse(trigger->trace_id);
+}
+
+// Returns true if no skit is left running
+static bool skit_finished()
+{
+    app_trigger_t next;
+    bool start_next = app_trigger_queue_complete(&g_trigger_queue, NULL, &next);
+
+    uint8_t pending = app_trigger_queue_pending(&g_trigger_queue) + (start_next ? 1 : 0);
+    uart_send_frame(RSP_DONE, &pending, 1);
+
+    if (start_next) {
+        ESP_LOGI(TAG, "Starting queued skit (%d still pending)", app_trigger_queue_pending(&g_trigger_queue));
+        skit_start(&next);
+    }
+    return !start_next;
+}
+
+// Put the trigger OnOff back to OFF once nothing it started is left. S3-only
+// skits never turned it ON, so they leave it alone.
+static void trigger_attr_release()
+{
+    if (!g_trigger_attr_on) {
+        return;
+    }
+    g_trigger_attr_on = false;
+
+    // The resulting callback is ours, not the user's
+    esp_matter_attr_val_t val = esp_matter_bool(false);
+    g_node.trigger_writeback = true;
+    esp_err_t err = app_matter_update(g_node.trigger_endpoint_id, OnOff::Id, OnOff::Attributes::OnOff::Id, &val);
+    g_node.trigger_writeback = false;
+    if (err == ESP_OK) {
+        ESP_LOGI(TAG, "Matter attribute updated to OFF successfully");
+    } else {
+        ESP_LOGE(TAG, "Failed to update Matter attribute to OFF: %s", esp_err_to_name(err));
+    }
+}
+
+static void on_pulse_end(const app_event_t *event)
+{
+    if (!g_pulse_active || event->data.value != g_pulse_generation) {
+        return;  // Already stopped by an OFF command
+    }
+    g_pulse_active = false;
+    ESP_LOGI(TAG, "Pulse ended - GPIO %d LOW", SIGNAL_GPIO);
+
+    // OnOff stays ON while queued skits keep running
+    if (skit_finished()) {
+        trigger_attr_release();
+    }
+}
+
+static void on_trigger_on(const app_event_t *event)
+{
+    app_trigger_t trigger = { APP_TRIGGER_SRC_HOMEKIT, (uint16_t)event->data.value };
+    g_trigger_attr_on = true;
+
+    app_trigger_result_t result = app_trigger_queue_submit(&g_trigger_queue, &trigger);
+    app_trace_mark(trigger.trace_id, APP_TRACE_DEBOUNCE_DECISION);
+    if (result == APP_TRIGGER_STARTED) {
+        skit_start(&trigger);
+    } else {
+        ESP_LOGW(TAG, "HomeKit TRIGGER while skit active - %s (%d pending)",
+                 result == APP_TRIGGER_DROPPED ? "dropped" :
+                 result == APP_TRIGGER_QUEUED ? "queued" : "coalesced",
+                 app_trigger_queue_pending(&g_trigger_queue));
+    }
+}
+
+static void on_trigger_off(const app_event_t *event)
+{
+    // Matter "OFF" command - stop the running skit immediately; queued ones still run
+    g_trigger_attr_on = false;  // The controller already set it OFF
+    if (g_pulse_active) {
+        stop_pulse();
+        skit_finished();
+    }
+}
+
 // This callback is called for every attribute update. The callback implementation shall
 // handle the desired attributes and return an appropriate error code. If the attribute
 // is not of your interest, please do not return an error code and strictly return ESP_OK.
@@ -603,50 +1034,25 @@ static esp_err_t app_attribute_update_cb(attribute::callback_type_t type, uint16
                                          uint32_t attribute_id, esp_matter_attr_val_t *val, void *priv_data)
 {
     if (type == PRE_UPDATE) {
-        // Handle On/Off cluster commands
+        // Only record what happened here; the dispatcher does the UART/GPIO/Matter work
         if (cluster_id == OnOff::Id && attribute_id == OnOff::Attributes::OnOff::Id) {
             bool new_state = val->val.b;
             ESP_LOGI(TAG, "On/Off command received on endpoint %d: %s", endpoint_id, new_state ? "ON" : "OFF");
-            
-            // Check if this is the trigger switch (endpoint 1)
-            if (endpoint_id == g_switch_endpoint_id && new_state) {
-                ESP_LOGI(TAG, "HomeKit TRIGGER detected - sending UART command to S3");
-                uart_send_frame(CMD_TRIGGER, nullptr, 0);
-            }
-            
-            if (new_state) {
-                // Matter "ON" command - start pulse
-                start_pulse();
-            } else {
-                // Matter "OFF" command - stop pulse immediately
-                stop_pulse();
-            }
-        }
-        
-        // Handle 4 Plugin Units for mode selection (4 discrete outlets with robust mutual exclusivity)
-        for (int mode = 0; mode < 4; mode++) {
-            if (endpoint_id == g_mode_plugin_ids[mode] && 
-                cluster_id == OnOff::Id && 
-                attribute_id == OnOff::Attributes::OnOff::Id) {
-                
-                if (val->val.b == true) {  // Plugin turned ON
-                    // Ignore callbacks triggered by our own sync task
-                    if (g_syncing_modes) {
-                        ESP_LOGD(TAG, "Ignoring sync callback for mode %d", mode);
-                        break;
-                    }
-                    
-                    // Record the tap - debounce timer will handle it
-                    g_target_mode = mode;
-                    g_last_tap_time = esp_timer_get_time();
-                    ESP_LOGI(TAG, "👆 User tapped mode %d - debouncing (200ms)...", mode);
-                } else {
-                    // Plugin turned OFF - ignore, sync task enforces mutual exclusivity
-                    if (!g_syncing_modes) {
-                        ESP_LOGD(TAG, "Mode %d turned OFF by HomeKit (ignoring)", mode);
-                    }
-                }
-                break; // Found the matching endpoint, no need to continue loop
+
+            // Trigger plug, or one of the 4 mode plugs (our own reports and write-backs are ignored)
+            int mode = 0;
+            switch (app_node_model_on_onoff_write(&g_node, endpoint_id, new_state, &mode)) {
+            case APP_NODE_WRITE_TRIGGER_ON:
+                app_event_post_value(APP_EVT_TRIGGER_ON, app_trace_begin());
+                break;
+            case APP_NODE_WRITE_TRIGGER_OFF:
+                app_event_post_value(APP_EVT_TRIGGER_OFF, 0);
+                break;
+            case APP_NODE_WRITE_MODE_TAP:
+                app_event_post_value(APP_EVT_MODE_TAP, mode);  // Debounce timer will handle it
+                break;
+            default:
+                break;
             }
         }
     } else if (type == POST_UPDATE) {
@@ -699,43 +1105,83 @@ static esp_err_t factory_reset_button_register()
 
 // Button registration removed - GPIO control is now via Matter commands only
 
-// Simple factory reset trigger - will reset after 10 seconds
-static void trigger_factory_reset_timer(void)
+static esp_err_t create_oneshot_timer(esp_timer_cb_t cb, void *arg, const char *name, esp_timer_handle_t *out)
 {
-    ESP_LOGW(TAG, "=== FACTORY RESET TRIGGERED ===");
-    ESP_LOGW(TAG, "Device will reset in 10 seconds...");
-    ESP_LOGW(TAG, "Unplug power now if you want to cancel!");
-    
-    vTaskDelay(pdMS_TO_TICKS(10000)); // Wait 10 seconds
-    
-    ESP_LOGI(TAG, "Starting factory reset NOW");
-    esp_matter::factory_reset();
+    esp_timer_create_args_t timer_args = {
+        .callback = cb,
+        .arg = arg,
+        .name = name,
+    };
+    return esp_timer_create(&timer_args, out);
 }
 
-// Console command for factory reset
-static int factory_reset_cmd(int argc, char **argv)
+// ===== Latency Watchdog =====
+static void dispatcher_heartbeat()
 {
-    if (argc == 2 && strcmp(argv[1], "confirm") == 0) {
-        // Start the reset in a new task
-        xTaskCreate([](void*){ trigger_factory_reset_timer(); vTaskDelete(NULL); }, 
-                   "factory_reset", 4096, NULL, 5, NULL);
-        return 0;
-    } else {
-        printf("Usage: factory_reset confirm\n");
-        printf("WARNING: This will erase all pairing data!\n");
-        return 1;
+    app_wd_checkin(g_wd_dispatcher);
+}
+
+// Matter thread: how long the probe waited behind other Matter work
+static void matter_probe_work(intptr_t arg)
+{
+    int64_t scheduled = g_matter_probe_us;
+    app_wd_record_delay(g_wd_matter, (uint32_t)(esp_timer_get_time() - scheduled));
+    g_matter_probe_us = 0;
+}
+
+// Watchdog task: keep one probe in flight on the Matter thread
+static void matter_probe()
+{
+    if (!g_matter_started || g_matter_probe_us != 0) {
+        return;
+    }
+    g_matter_probe_us = esp_timer_get_time();
+    if (chip::DeviceLayer::PlatformMgr().ScheduleWork(matter_probe_work, 0) != CHIP_NO_ERROR) {
+        g_matter_probe_us = 0;
     }
 }
 
-static void register_factory_reset_console_cmd()
+static esp_err_t app_wd_start()
 {
-    esp_console_cmd_t cmd = {
-        .command = "factory_reset",
-        .help = "Perform factory reset (use 'factory_reset confirm')",
-        .hint = NULL,
-        .func = &factory_reset_cmd,
-    };
-    esp_console_cmd_register(&cmd);
+    g_wd_dispatcher = app_wd_register("dispatcher", WD_DISPATCHER_MS);
+    g_wd_uart_rx = app_wd_register("uart_rx", WD_UART_RX_MS);
+    g_wd_matter = app_wd_register("matter", WD_MATTER_MS);
+    app_event_bus_set_heartbeat(dispatcher_heartbeat);
+    return app_wd_init(WD_PERIOD_MS, matter_probe);
+}
+
+static esp_err_t app_events_init()
+{
+    esp_err_t err = app_event_bus_init();
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    app_trigger_queue_init(&g_trigger_queue, TRIGGER_QUEUE_POLICY, TRIGGER_QUEUE_DEPTH);
+    app_node_model_init(&g_node, &g_node_platform);
+    ESP_LOGI(TAG, "Trigger policy: %s (depth %d)", app_trigger_policy_name(TRIGGER_QUEUE_POLICY),
+             TRIGGER_QUEUE_DEPTH);
+
+    app_event_bus_register(APP_EVT_TRIGGER_ON, on_trigger_on);
+    app_event_bus_register(APP_EVT_TRIGGER_OFF, on_trigger_off);
+    app_event_bus_register(APP_EVT_PULSE_END, on_pulse_end);
+    app_event_bus_register(APP_EVT_MODE_TAP, on_mode_tap);
+    app_event_bus_register(APP_EVT_MODE_DEBOUNCED, on_mode_debounced);
+    app_event_bus_register(APP_EVT_MODE_CLEANUP, on_mode_cleanup);
+    app_event_bus_register(APP_EVT_MODE_REPORT, on_mode_report);
+    app_event_bus_register(APP_EVT_LINK_FRAME, on_link_frame);
+    app_event_bus_register(APP_EVT_LINK_CRC_ERROR, on_link_crc_error);
+    app_event_bus_register(APP_EVT_COMMISSIONED, on_commissioned);
+    app_event_bus_register(APP_EVT_FABRIC_REMOVED, on_fabric_removed);
+
+    err = create_oneshot_timer(pulse_timer_cb, NULL, "pulse_timer", &g_pulse_timer);
+    err |= create_oneshot_timer(mode_timer_cb, (void *)(intptr_t)APP_EVT_MODE_DEBOUNCED, "mode_debounce",
+                                &g_mode_debounce_timer);
+    err |= create_oneshot_timer(mode_timer_cb, (void *)(intptr_t)APP_EVT_MODE_CLEANUP, "mode_cleanup",
+                                &g_mode_cleanup_timer);
+    err |= create_oneshot_timer(mode_report_timer_cb, NULL, "mode_report", &g_mode_report_timer);
+    err |= create_oneshot_timer(led_timer_cb, NULL, "led_timer", &g_led_timer);
+    return err;
 }
 
 extern "C" void app_main()
@@ -743,16 +1189,44 @@ extern "C" void app_main()
     /* Initialize the ESP NVS layer */
     nvs_flash_init();
 
-    /* Initialize console for factory reset command */
-    esp_console_repl_t *repl = NULL;
-    esp_console_repl_config_t repl_config = ESP_CONSOLE_REPL_CONFIG_DEFAULT();
-    esp_console_dev_uart_config_t uart_config = ESP_CONSOLE_DEV_UART_CONFIG_DEFAULT();
-    esp_console_new_repl_uart(&uart_config, &repl_config, &repl);
-    register_factory_reset_console_cmd();
-    esp_console_start_repl(repl);
+    /* Initialize console for factory reset and diagnostics commands */
+    esp_err_t err = app_console_start();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Console not available, err:%d", err);  // Not fatal: the node still works
+    }
+
+    /* Start the event dispatcher before anything can post to it */
+    err = app_events_init();
+    ABORT_APP_ON_FAILURE(ESP_OK == err, ESP_LOGE(TAG, "Failed to initialize event bus, err:%d", err));
+
+    /* Watch the dispatcher, UART RX and Matter paths for stalls */
+    err = app_wd_start();
+    ABORT_APP_ON_FAILURE(ESP_OK == err, ESP_LOGE(TAG, "Failed to start latency watchdog, err:%d", err));
+
+#if CONFIG_APP_SHTC3 || CONFIG_APP_PIR_SENSOR
+    /* Sensor history log, fed by the SHTC3 and the PIR; older partition tables have no room for it */
+    err = app_history_init();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Sensor history not available, err:%d", err);  // Not fatal
+    }
+#endif
+
+    /* Visitor presence from the PIR and the S3 touch sensor */
+    err = app_presence_init();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Presence fusion not available, err:%d", err);  // Not fatal
+    }
+
+#if CONFIG_APP_SHTC3
+    /* Temperature and humidity for the history log; runs without the sensor too */
+    err = sensor_start();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "SHTC3 not available, err:%d", err);  // Not fatal
+    }
+#endif
 
     /* Initialize push button on the dev-kit to reset the device */
-    esp_err_t err = factory_reset_button_register();
+    err = factory_reset_button_register();
     ABORT_APP_ON_FAILURE(ESP_OK == err, ESP_LOGE(TAG, "Failed to initialize reset button, err:%d", err));
 
     /* Initialize signal GPIO */
@@ -780,7 +1254,11 @@ extern "C" void app_main()
         .stop_bits = UART_STOP_BITS_1,
         .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
         .rx_flow_ctrl_thresh = 122,
+#if CONFIG_APP_IDLE_SLEEP
+        .source_clk = UART_SCLK_XTAL,   // Baud rate unaffected by frequency scaling
+#else
         .source_clk = UART_SCLK_DEFAULT,
+#endif
     };
     err = uart_param_config(UART_NUM, &uart_conf);
     ABORT_APP_ON_FAILURE(ESP_OK == err, ESP_LOGE(TAG, "Failed to configure UART params, err:%d", err));
@@ -791,15 +1269,34 @@ extern "C" void app_main()
     err = uart_driver_install(UART_NUM, UART_BUF_SIZE, UART_BUF_SIZE, 0, NULL, 0);
     ABORT_APP_ON_FAILURE(ESP_OK == err, ESP_LOGE(TAG, "Failed to install UART driver, err:%d", err));
     
-    ESP_LOGI(TAG, "UART initialized: TX=%d, RX=%d, Baud=%d", UART_TX_PIN, UART_RX_PIN, UART_BAUD);
+    ESP_LOGI(TAG, "UART%d initialized: TX=%d, RX=%d, Baud=%d", UART_NUM, UART_TX_PIN, UART_RX_PIN, UART_BAUD);
     
+    g_link_lock = xSemaphoreCreateRecursiveMutex();
+    ABORT_APP_ON_FAILURE(g_link_lock != NULL, ESP_LOGE(TAG, "Failed to create UART link lock"));
+    g_link_buf_done = xSemaphoreCreateBinary();
+    ABORT_APP_ON_FAILURE(g_link_buf_done != NULL, ESP_LOGE(TAG, "Failed to create UART resize semaphore"));
+
     /* Start UART RX task */
     xTaskCreate(uart_rx_task, "uart_rx", 4096, NULL, 10, NULL);
     ESP_LOGI(TAG, "UART RX task created");
-    
-    /* Start Mode Sync task */
-    xTaskCreate(mode_sync_task, "mode_sync", 4096, NULL, 10, NULL);
-    ESP_LOGI(TAG, "Mode sync task created");
+    int64_t link_up_us = esp_timer_get_time();
+
+#if CONFIG_APP_PIR_SENSOR
+    /* PIR motion for presence and the history log; the node works without it */
+    err = pir_start();
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "PIR sensor not available, err:%d", err);  // Not fatal
+    }
+#if CONFIG_APP_IDLE_SLEEP
+    /* Idle light sleep with the PIR as the wake source */
+    if (err == ESP_OK) {
+        err = idle_sleep_start();
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Idle sleep not available, err:%d", err);  // Not fatal
+        }
+    }
+#endif
+#endif
 
     /* Create a Matter node and add the mandatory Root Node device type on endpoint 0 */
     node::config_t node_config{}; // Explicitly zero-initialize
@@ -834,7 +1331,8 @@ extern "C" void app_main()
     endpoint_t *trigger_ep = endpoint::on_off_plugin_unit::create(node, &trigger_cfg, ENDPOINT_FLAG_NONE, NULL);
     ABORT_APP_ON_FAILURE(trigger_ep != nullptr, ESP_LOGE(TAG, "Failed to create trigger plugin unit endpoint"));
 
-    g_switch_endpoint_id = endpoint::get_id(trigger_ep);
+    g_node.trigger_endpoint_id = endpoint::get_id(trigger_ep);
+    app_matter_stats_set_label(g_node.trigger_endpoint_id, "trigger");
     
     // Set custom name for trigger
     set_endpoint_name(trigger_ep, "🎃 Trigger Skit");
@@ -843,34 +1341,50 @@ extern "C" void app_main()
     // Create 4 On/Off Plugin Unit endpoints for mode selection (4 discrete outlets)
     // ------------------------------------------------------------------
 
-    const char* mode_names[] = {"Little Kid", "Big Kid", "Take One", "Closed"};
     const char* mode_emoji_names[] = {"👶 Little Kid", "👦 Big Kid", "🍭 Take One", "🚪 Closed"};
     endpoint::on_off_plugin_unit::config_t mode_plug_cfg;
     
     for (int i = 0; i < 4; i++) {
         endpoint_t *mode_plug_ep = endpoint::on_off_plugin_unit::create(node, &mode_plug_cfg, ENDPOINT_FLAG_NONE, NULL);
         ABORT_APP_ON_FAILURE(mode_plug_ep != nullptr, ESP_LOGE(TAG, "Failed to create %s plugin unit endpoint", mode_names[i]));
-        g_mode_plugin_ids[i] = endpoint::get_id(mode_plug_ep);
+        g_node.mode_endpoint_ids[i] = endpoint::get_id(mode_plug_ep);
+        app_matter_stats_set_label(g_node.mode_endpoint_ids[i], mode_names[i]);
         
         // Set custom name with emoji
         set_endpoint_name(mode_plug_ep, mode_emoji_names[i]);
         
-        ESP_LOGI(TAG, "Created %s plugin unit endpoint (ID: %d)", mode_names[i], g_mode_plugin_ids[i]);
+        ESP_LOGI(TAG, "Created %s plugin unit endpoint (ID: %d)", mode_names[i], g_node.mode_endpoint_ids[i]);
     }
 
+#if CONFIG_TRIGGER_SWITCH_EVENTS
+    // ------------------------------------------------------------------
+    // Optional Generic Switch (momentary) that reports every skit as a press event.
+    // Created last so the plug endpoint IDs stay the same with it on or off.
+    // ------------------------------------------------------------------
+    endpoint::generic_switch::config_t switch_cfg;
+    endpoint_t *switch_ep = endpoint::generic_switch::create(node, &switch_cfg, ENDPOINT_FLAG_NONE, NULL);
+    ABORT_APP_ON_FAILURE(switch_ep != nullptr, ESP_LOGE(TAG, "Failed to create trigger switch endpoint"));
+    cluster_t *switch_cluster = cluster::get(switch_ep, Switch::Id);
+    cluster::switch_cluster::feature::momentary_switch::add(switch_cluster);
+    cluster::switch_cluster::feature::momentary_switch_release::add(switch_cluster);
+    g_trigger_switch_endpoint_id = endpoint::get_id(switch_ep);
+    app_matter_stats_set_label(g_trigger_switch_endpoint_id, "trigger_sw");
+    ESP_LOGI(TAG, "Created trigger switch endpoint (ID: %d)", g_trigger_switch_endpoint_id);
+#endif
+
     // Initialize to mode 0 (Little Kid): FORCE sync to clear any stale HomeKit state
     {
         ESP_LOGI(TAG, "=== FORCING MODE 0 (LITTLE KID) ON STARTUP ===");
         
         // Set flag to prevent callback recursion during boot initialization
-        g_syncing_modes = true;
+        g_node.syncing = true;
         
         esp_matter_attr_val_t off_val = esp_matter_bool(false);
         esp_matter_attr_val_t on_val = esp_matter_bool(true);
         
         // AGGRESSIVELY turn OFF all mode plugins using REPORT to notify HomeKit
         for (int i = 0; i < 4; i++) {
-            attribute::report(g_mode_plugin_ids[i], chip::app::Clusters::OnOff::Id,
+            app_matter_report(g_node.mode_endpoint_ids[i], chip::app::Clusters::OnOff::Id,
                               chip::app::Clusters::OnOff::Attributes::OnOff::Id, &off_val);
         }
         
@@ -878,16 +1392,19 @@ extern "C" void app_main()
         vTaskDelay(pdMS_TO_TICKS(100));
         
         // Turn ON only the first plugin (Little Kid mode) using REPORT to notify HomeKit
-        attribute::report(g_mode_plugin_ids[0], chip::app::Clusters::OnOff::Id,
+        app_matter_report(g_node.mode_endpoint_ids[0], chip::app::Clusters::OnOff::Id,
                           chip::app::Clusters::OnOff::Attributes::OnOff::Id, &on_val);
         
         // Clear flag
-        g_syncing_modes = false;
+        g_node.syncing = false;
         
         // Set current mode
-        g_current_mode = 0;
+        g_node.current_mode = 0;
         
         ESP_LOGI(TAG, "=== MODE INITIALIZATION COMPLETE: Little Kid=ON, all others=OFF ===");
+
+        // Re-assert once after boot as well, like after any mode change
+        esp_timer_start_once(g_mode_cleanup_timer, MODE_CLEANUP_MS * 1000);
     }
 
     // GPIO control is now handled via Matter commands only
@@ -905,8 +1422,23 @@ extern "C" void app_main()
     /* Matter start */
     err = esp_matter::start(app_event_cb);
     ABORT_APP_ON_FAILURE(err == ESP_OK, ESP_LOGE(TAG, "Failed to start Matter, err:%d", err));
+    g_matter_started = true;
+
+    // Grep-able boot milestones (time since boot) for scripted runs, e.g. under QEMU
+    ESP_LOGI(TAG, "BOOT_TIMING link_up=%" PRId64 "ms matter_started=%" PRId64 "ms", link_up_us / 1000,
+             esp_timer_get_time() / 1000);
 
     // PrintOnboardingCodes will log the necessary VID/PID and commissioning info
     chip::DeviceLayer::StackLock lock; // RAII lock for Matter stack
     PrintOnboardingCodes(chip::RendezvousInformationFlags(chip::RendezvousInformationFlag::kBLE).Set(chip::RendezvousInformationFlag::kOnNetwork));
+
+    // Time how long controllers take to get their subscriptions back after this boot
+    app_matter_stats_watch_subscriptions();
+
+#if CONFIG_APP_BLE_RECLAIM
+    // Already commissioned on a previous boot: BLE is not needed this time either
+    if (chip::Server::GetInstance().GetFabricTable().FabricCount() > 0) {
+        app_ble_reclaim_start(on_ble_reclaimed);
+    }
+#endif
 }
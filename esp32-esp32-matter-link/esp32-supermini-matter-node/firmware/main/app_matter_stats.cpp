@@ -0,0 +1,249 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#include <esp_matter_event.h>
+#include <platform/CHIPDeviceLayer.h>
+#include <app/InteractionModelEngine.h>
+#include <app/ReadHandler.h>
+
+#include "app_matter_stats.h"
+#include "app_sub_tracker.h"
+
+using namespace esp_matter;
+
+static const char *TAG = "app_matter_stats";
+
+#define SWITCH_PRESSED_POSITION 1
+
+typedef struct {
+    bool used;
+    uint16_t endpoint_id;
+    const char *label;
+    uint32_t reports;
+    uint32_t updates;
+    uint32_t events;
+    uint32_t failures;
+    uint32_t call_max_us;
+    uint64_t call_total_us;
+    int64_t last_us;            // 0 = never written
+} endpoint_stats_t;
+
+static endpoint_stats_t s_endpoints[APP_MATTER_STATS_MAX_ENDPOINTS];
+static uint32_t s_untracked = 0;    // Writes to endpoints beyond the table
+static uint32_t s_triggers = 0;
+
+// Subscription tracking, only touched on the Matter thread
+static app_sub_tracker_t s_subs;
+// Written from the dispatcher and the Matter task (boot-time sync)
+static portMUX_TYPE s_matter_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Caller holds s_matter_lock
+static endpoint_stats_t *find_slot(uint16_t endpoint_id)
+{
+    for (int i = 0; i < APP_MATTER_STATS_MAX_ENDPOINTS; i++) {
+        if (s_endpoints[i].used && s_endpoints[i].endpoint_id == endpoint_id) {
+            return &s_endpoints[i];
+        }
+    }
+    for (int i = 0; i < APP_MATTER_STATS_MAX_ENDPOINTS; i++) {
+        if (!s_endpoints[i].used) {
+            s_endpoints[i].used = true;
+            s_endpoints[i].endpoint_id = endpoint_id;
+            return &s_endpoints[i];
+        }
+    }
+    return NULL;
+}
+
+typedef enum {
+    WRITE_REPORT = 0,
+    WRITE_UPDATE,
+    WRITE_EVENT,
+} write_kind_t;
+
+static void record(uint16_t endpoint_id, write_kind_t kind, esp_err_t err, int64_t start_us, int64_t end_us)
+{
+    uint32_t call_us = (uint32_t)(end_us - start_us);
+
+    portENTER_CRITICAL(&s_matter_lock);
+    endpoint_stats_t *slot = find_slot(endpoint_id);
+    if (slot == NULL) {
+        s_untracked++;
+    } else {
+        if (kind == WRITE_REPORT) {
+            slot->reports++;
+        } else if (kind == WRITE_UPDATE) {
+            slot->updates++;
+        } else {
+            slot->events++;
+        }
+        if (err != ESP_OK) {
+            slot->failures++;
+        }
+        slot->call_total_us += call_us;
+        if (call_us > slot->call_max_us) {
+            slot->call_max_us = call_us;
+        }
+        slot->last_us = end_us;
+    }
+    portEXIT_CRITICAL(&s_matter_lock);
+}
+
+esp_err_t app_matter_report(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id,
+                            esp_matter_attr_val_t *val)
+{
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = attribute::report(endpoint_id, cluster_id, attribute_id, val);
+    record(endpoint_id, WRITE_REPORT, err, start, esp_timer_get_time());
+    return err;
+}
+
+esp_err_t app_matter_update(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id,
+                            esp_matter_attr_val_t *val)
+{
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = attribute::update(endpoint_id, cluster_id, attribute_id, val);
+    record(endpoint_id, WRITE_UPDATE, err, start, esp_timer_get_time());
+    return err;
+}
+
+// Matter thread
+static void switch_press_work(intptr_t arg)
+{
+    uint16_t endpoint_id = (uint16_t)arg;
+
+    int64_t start = esp_timer_get_time();
+    esp_err_t press = cluster::switch_cluster::event::send_initial_press(endpoint_id, SWITCH_PRESSED_POSITION);
+    record(endpoint_id, WRITE_EVENT, press, start, esp_timer_get_time());
+
+    start = esp_timer_get_time();
+    esp_err_t release = cluster::switch_cluster::event::send_short_release(endpoint_id, SWITCH_PRESSED_POSITION);
+    record(endpoint_id, WRITE_EVENT, release, start, esp_timer_get_time());
+}
+
+esp_err_t app_matter_switch_press(uint16_t endpoint_id)
+{
+    // ScheduleWork posts to the Matter event queue and may be called from any
+    // task; SystemLayer() calls need the stack lock, which the dispatcher does not hold
+    CHIP_ERROR err = chip::DeviceLayer::PlatformMgr().ScheduleWork(switch_press_work, (intptr_t)endpoint_id);
+    return err == CHIP_NO_ERROR ? ESP_OK : ESP_FAIL;
+}
+
+void app_matter_stats_count_trigger(void)
+{
+    portENTER_CRITICAL(&s_matter_lock);
+    s_triggers++;
+    portEXIT_CRITICAL(&s_matter_lock);
+}
+
+class SubscriptionWatcher : public chip::app::ReadHandler::ApplicationCallback
+{
+    void OnSubscriptionEstablished(chip::app::ReadHandler & handler) override
+    {
+        int64_t now = esp_timer_get_time();
+        if (app_sub_tracker_established(&s_subs, now)) {
+            ESP_LOGI(TAG, "BOOT_TIMING first_subscription=%" PRId64 "ms (%" PRId64 "ms after Matter start)",
+                     now / 1000, app_sub_tracker_first_after_start_us(&s_subs) / 1000);
+        }
+    }
+
+    void OnSubscriptionTerminated(chip::app::ReadHandler & handler) override
+    {
+        app_sub_tracker_terminated(&s_subs);
+    }
+};
+
+static SubscriptionWatcher s_subscription_watcher;
+
+void app_matter_stats_watch_subscriptions(void)
+{
+    app_sub_tracker_start(&s_subs, esp_timer_get_time());
+    chip::app::InteractionModelEngine::GetInstance()->RegisterReadHandlerAppCallback(&s_subscription_watcher);
+}
+
+void app_matter_stats_set_label(uint16_t endpoint_id, const char *label)
+{
+    portENTER_CRITICAL(&s_matter_lock);
+    endpoint_stats_t *slot = find_slot(endpoint_id);
+    if (slot) {
+        slot->label = label;
+    }
+    portEXIT_CRITICAL(&s_matter_lock);
+}
+
+void app_matter_stats_reset(void)
+{
+    portENTER_CRITICAL(&s_matter_lock);
+    for (int i = 0; i < APP_MATTER_STATS_MAX_ENDPOINTS; i++) {
+        endpoint_stats_t *slot = &s_endpoints[i];
+        slot->reports = 0;
+        slot->updates = 0;
+        slot->events = 0;
+        slot->failures = 0;
+        slot->call_max_us = 0;
+        slot->call_total_us = 0;
+        slot->last_us = 0;
+    }
+    s_untracked = 0;
+    s_triggers = 0;
+    portEXIT_CRITICAL(&s_matter_lock);
+}
+
+void app_matter_stats_print(void)
+{
+    static endpoint_stats_t snap[APP_MATTER_STATS_MAX_ENDPOINTS];
+    uint32_t untracked;
+    uint32_t triggers;
+
+    portENTER_CRITICAL(&s_matter_lock);
+    memcpy(snap, s_endpoints, sizeof(snap));
+    untracked = s_untracked;
+    triggers = s_triggers;
+    portEXIT_CRITICAL(&s_matter_lock);
+
+    int64_t now = esp_timer_get_time();
+    printf("%-4s %-12s %8s %8s %7s %8s %6s %9s %9s %10s\n",
+           "ep", "label", "report()", "update()", "event()", "per_trig", "fail", "avg_us", "max_us", "last_ago_s");
+    for (int i = 0; i < APP_MATTER_STATS_MAX_ENDPOINTS; i++) {
+        const endpoint_stats_t *s = &snap[i];
+        if (!s->used) {
+            continue;
+        }
+        uint32_t calls = s->reports + s->updates + s->events;
+        uint32_t avg = calls ? (uint32_t)(s->call_total_us / calls) : 0;
+        printf("%-4u %-12s %8" PRIu32 " %8" PRIu32 " %7" PRIu32 " %8.2f %6" PRIu32 " %9" PRIu32 " %9" PRIu32,
+               s->endpoint_id, s->label ? s->label : "-", s->reports, s->updates, s->events,
+               triggers ? (double)calls / triggers : 0.0, s->failures, avg, s->call_max_us);
+        if (s->last_us == 0) {
+            printf(" %10s\n", "never");
+        } else {
+            printf(" %10.1f\n", (now - s->last_us) / 1e6);
+        }
+    }
+    if (s_subs.first_us != 0) {
+        printf("Subscriptions: %" PRIu32 " active, %" PRIu32 " established, %" PRIu32
+               " terminated; first at %" PRId64 "ms after boot, %" PRId64 "ms after Matter start\n",
+               s_subs.active, s_subs.established, s_subs.terminated, s_subs.first_us / 1000,
+               app_sub_tracker_first_after_start_us(&s_subs) / 1000);
+    } else {
+        printf("Subscriptions: none since boot\n");
+    }
+    printf("Skit triggers: %" PRIu32 " (per_trig = API calls per trigger)\n", triggers);
+    printf("Counts are calls into esp_matter; the reporting engine merges dirty attributes\n"
+           "into at most one report per subscription and interval, so fewer reach controllers\n");
+    if (untracked) {
+        printf("Untracked endpoint writes: %" PRIu32 "\n", untracked);
+    }
+}
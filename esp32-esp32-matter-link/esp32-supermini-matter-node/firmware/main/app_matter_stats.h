@@ -0,0 +1,58 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Counted wrappers around esp_matter attribute::report(), attribute::update()
+// and Switch cluster events.
+//
+// The app writes attributes and emits events only through these so the console
+// can show how often each endpoint is written, how long the calls take, when
+// the last one happened and how many calls a single skit trigger costs.
+//
+// These are API calls, not reports on the air: report()/update() mark the
+// attribute dirty and the interaction model engine sends at most one report per
+// subscription per reporting interval, however many calls came before it.
+#pragma once
+
+#include <esp_err.h>
+#include <esp_matter.h>
+
+#define APP_MATTER_STATS_MAX_ENDPOINTS 8
+
+/** attribute::report() with per-endpoint call counting and timing. */
+esp_err_t app_matter_report(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id,
+                            esp_matter_attr_val_t *val);
+
+/** attribute::update() with per-endpoint call counting and timing. */
+esp_err_t app_matter_update(uint16_t endpoint_id, uint32_t cluster_id, uint32_t attribute_id,
+                            esp_matter_attr_val_t *val);
+
+/** Emit a momentary press (InitialPress then ShortRelease, position 1) on a
+ *  Generic Switch endpoint. Callable from any task without the CHIP stack
+ *  lock: the events are queued with PlatformMgr().ScheduleWork() and sent from
+ *  the Matter thread. Each event counts as one call on the endpoint. */
+esp_err_t app_matter_switch_press(uint16_t endpoint_id);
+
+/** Count one skit trigger, the denominator of the per-trigger column. */
+void app_matter_stats_count_trigger(void);
+
+/** Start tracking subscriptions (app_sub_tracker.h): active count, and the
+ *  time from boot and from this call to the first established subscription
+ *  (its priming report has been sent), which is what a controller waits for
+ *  after the node reboots. Call once on the Matter thread right after
+ *  esp_matter::start(), before persisted subscriptions are resumed. */
+void app_matter_stats_watch_subscriptions(void);
+
+/** Give an endpoint a printable label (not copied; pass a string literal). */
+void app_matter_stats_set_label(uint16_t endpoint_id, const char *label);
+
+/** Print per-endpoint report()/update()/event call counts, calls per trigger,
+ *  failures, call time and last timestamp. */
+void app_matter_stats_print(void);
+
+/** Clear all counters (labels and subscription timing are kept). */
+void app_matter_stats_reset(void);
@@ -0,0 +1,114 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "app_node_model.h"
+
+#define REPORT_ON_STEP  APP_NODE_MODE_COUNT     // Steps 0-3 turn mode plugs OFF, step 4 turns the target ON
+
+void app_node_model_init(app_node_model_t *m, const app_node_platform_t *platform)
+{
+    memset(m, 0, sizeof(*m));
+    m->platform = *platform;
+    m->step = -1;
+    m->label = "";
+}
+
+app_node_write_t app_node_model_on_onoff_write(app_node_model_t *m, uint16_t endpoint_id, bool on, int *mode)
+{
+    if (endpoint_id == m->trigger_endpoint_id) {
+        m->stats.writes++;
+        if (on) {
+            return APP_NODE_WRITE_TRIGGER_ON;
+        }
+        if (m->trigger_writeback) {
+            m->stats.echoes++;
+            return APP_NODE_WRITE_NONE;
+        }
+        return APP_NODE_WRITE_TRIGGER_OFF;
+    }
+
+    for (int i = 0; i < APP_NODE_MODE_COUNT; i++) {
+        if (endpoint_id != m->mode_endpoint_ids[i]) {
+            continue;
+        }
+        m->stats.writes++;
+        if (m->syncing) {
+            m->stats.echoes++;
+            return APP_NODE_WRITE_NONE;
+        }
+        // OFF is ignored: the exclusive report after the next tap turns it OFF anyway
+        if (!on) {
+            return APP_NODE_WRITE_NONE;
+        }
+        if (mode) {
+            *mode = i;
+        }
+        return APP_NODE_WRITE_MODE_TAP;
+    }
+    return APP_NODE_WRITE_NONE;
+}
+
+void app_node_model_report_start(app_node_model_t *m, uint8_t mode, const char *label)
+{
+    if (m->step >= 0) {
+        m->stats.restarts++;
+    }
+    m->stats.sequences++;
+    m->current_mode = mode < APP_NODE_MODE_COUNT ? mode : 0;
+    m->syncing = true;
+    m->label = label;
+    m->step = 0;
+    // Steps of the old sequence still queued or firing carry the old number
+    m->seq++;
+    m->platform.schedule_step(m->platform.ctx, 0, m->seq);
+}
+
+static void report(app_node_model_t *m, int mode, bool on)
+{
+    m->stats.reports++;
+    if (m->platform.report_onoff(m->platform.ctx, m->mode_endpoint_ids[mode], on) != 0) {
+        m->stats.report_errors++;
+    }
+}
+
+bool app_node_model_report_step(app_node_model_t *m, int32_t seq)
+{
+    if (m->step < 0 || seq != m->seq) {
+        m->stats.stale_steps++;
+        return false;
+    }
+    if (m->step == m->current_mode) {
+        m->step++;  // Skip the target mode
+    }
+
+    // One report per step with a short gap between steps
+    if (m->step < REPORT_ON_STEP) {
+        report(m, m->step++, false);
+        if (m->step == m->current_mode) {
+            m->step++;
+        }
+        uint32_t delay_ms = APP_NODE_REPORT_GAP_MS;
+        if (m->step >= REPORT_ON_STEP) {
+            delay_ms += APP_NODE_REPORT_SETTLE_MS;  // Small delay before turning ON the target
+        }
+        m->platform.schedule_step(m->platform.ctx, delay_ms, m->seq);
+        return false;
+    }
+
+    report(m, m->current_mode, true);
+    m->step = -1;
+    m->syncing = false;
+    return true;
+}
+
+bool app_node_model_reporting(const app_node_model_t *m)
+{
+    return m->step >= 0;
+}
@@ -0,0 +1,92 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Endpoint model of the node: the trigger plug and the four mode plugs.
+//
+// Decides what a controller's OnOff write on each endpoint means, and runs the
+// exclusive mode report (every other mode plug OFF, one at a time, then the
+// current one ON) that keeps controllers showing exactly one mode. Reports and
+// the waits between them go through app_node_platform_t, so the model has no
+// Matter, ESP-IDF or RTOS dependencies and runs unchanged on a host. The app
+// maps the platform to app_matter_report() and an esp_timer one-shot that
+// posts APP_EVT_MODE_REPORT.
+//
+// app_node_model_on_onoff_write() runs in the Matter callback; everything else
+// is serialized by the owner (the app calls it only from the event dispatcher).
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define APP_NODE_MODE_COUNT             4
+#define APP_NODE_REPORT_GAP_MS          10      // Between the OFF reports
+#define APP_NODE_REPORT_SETTLE_MS       50      // Extra wait before the ON report
+
+typedef enum {
+    APP_NODE_WRITE_NONE = 0,        // Not ours, or an echo of our own report or write-back
+    APP_NODE_WRITE_TRIGGER_ON,      // Controller turned the trigger plug ON
+    APP_NODE_WRITE_TRIGGER_OFF,     // Controller turned the trigger plug OFF
+    APP_NODE_WRITE_MODE_TAP,        // Controller turned a mode plug ON
+} app_node_write_t;
+
+typedef struct {
+    // Report the OnOff value even if it did not change. Returns 0 on success;
+    // failures are only counted (the cleanup report re-asserts every plug).
+    int (*report_onoff)(void *ctx, uint16_t endpoint_id, bool on);
+    // Call app_node_model_report_step(seq) after delay_ms, replacing any
+    // step still pending. delay_ms is 0 for the first step of a sequence.
+    void (*schedule_step)(void *ctx, uint32_t delay_ms, int32_t seq);
+    void *ctx;
+} app_node_platform_t;
+
+typedef struct {
+    uint32_t writes;                // OnOff writes seen on our endpoints
+    uint32_t echoes;                // ... ignored as our own
+    uint32_t sequences;             // Exclusive reports started
+    uint32_t restarts;              // ... while another was still running
+    uint32_t reports;
+    uint32_t report_errors;
+    uint32_t stale_steps;           // Steps of a restarted sequence, dropped
+} app_node_stats_t;
+
+typedef struct {
+    app_node_platform_t platform;
+    uint16_t trigger_endpoint_id;
+    uint16_t mode_endpoint_ids[APP_NODE_MODE_COUNT];
+    uint8_t current_mode;           // 0=Little Kid, 1=Big Kid, 2=Take One, 3=Closed
+    volatile bool syncing;          // Mode plug writes are our own reports
+    volatile bool trigger_writeback;    // Trigger plug writes are our own OFF write-back
+    int step;                       // Next report step, -1 = no report running
+    int32_t seq;                    // Bumped on every (re)start
+    const char *label;              // Of the running or last report, for logs
+    app_node_stats_t stats;
+} app_node_model_t;
+
+/** Reset to mode 0 with no report running. Endpoint IDs are set by the owner
+ *  once the endpoints exist. */
+void app_node_model_init(app_node_model_t *m, const app_node_platform_t *platform);
+
+/** Classify an OnOff write on `endpoint_id`.
+ *
+ * @param[out] mode The mode plug for APP_NODE_WRITE_MODE_TAP (may be NULL).
+ */
+app_node_write_t app_node_model_on_onoff_write(app_node_model_t *m, uint16_t endpoint_id, bool on, int *mode);
+
+/** Make `mode` current and start (or restart) the exclusive report. Only the
+ *  first step is scheduled; nothing is reported before this returns. */
+void app_node_model_report_start(app_node_model_t *m, uint8_t mode, const char *label);
+
+/** Run the report step scheduled with `seq`. Steps of a sequence restarted
+ *  since are dropped.
+ *
+ * @return true if this step turned the current mode ON and the report is complete.
+ */
+bool app_node_model_report_step(app_node_model_t *m, int32_t seq);
+
+/** True while an exclusive report is running. */
+bool app_node_model_reporting(const app_node_model_t *m);
@@ -0,0 +1,244 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include "sdkconfig.h"
+
+#if CONFIG_APP_IDLE_SLEEP
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <esp_log.h>
+#include <esp_pm.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "app_power.h"
+
+#define POWER_IDLE_AFTER_US     ((uint64_t)CONFIG_APP_IDLE_SLEEP_AFTER_S * 1000000ULL)
+#define POWER_RETRY_US          (60 * 1000000ULL)   // Arming failed: try again this much later
+
+static const char *TAG = "app_power";
+
+typedef struct {
+    uint32_t count;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} power_latency_t;
+
+typedef struct {
+    uint32_t idle_entries;
+    uint32_t arm_failures;
+    uint64_t idle_total_us;
+    power_latency_t wake_to_report;
+    power_latency_t wake_to_link;
+} power_stats_t;
+
+static app_power_config_t s_config;
+static SemaphoreHandle_t s_lock = NULL;
+static esp_pm_lock_handle_t s_no_sleep_lock = NULL;
+static esp_pm_lock_handle_t s_cpu_lock = NULL;
+static esp_timer_handle_t s_idle_timer = NULL;
+static bool s_idle = false;
+static bool s_occupied = false;
+static int64_t s_idle_since_us = 0;
+static int64_t s_wake_us = 0;
+static bool s_wait_report = false;
+static volatile bool s_wait_link = false;   // Read without the lock on every frame
+static power_stats_t s_stats;
+
+static void record_latency(power_latency_t *lat, int64_t us)
+{
+    uint32_t value = us < 0 ? 0 : (us > UINT32_MAX ? UINT32_MAX : (uint32_t)us);
+    lat->count++;
+    lat->last_us = value;
+    lat->total_us += value;
+    if (value > lat->max_us) {
+        lat->max_us = value;
+    }
+}
+
+// esp_timer task: no motion for the whole idle period
+static void idle_timer_cb(void *arg)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (s_idle || s_occupied) {
+        xSemaphoreGive(s_lock);
+        return;
+    }
+    esp_err_t err = s_config.arm_wakeup();
+    if (err != ESP_OK) {
+        s_stats.arm_failures++;
+        esp_timer_start_once(s_idle_timer, POWER_RETRY_US);
+        xSemaphoreGive(s_lock);
+        ESP_LOGW(TAG, "Staying awake: wake source not armed (%s)", esp_err_to_name(err));
+        return;
+    }
+    s_idle = true;
+    s_idle_since_us = esp_timer_get_time();
+    s_stats.idle_entries++;
+    esp_pm_lock_release(s_cpu_lock);
+    esp_pm_lock_release(s_no_sleep_lock);
+    xSemaphoreGive(s_lock);
+    ESP_LOGI(TAG, "No motion for %d s: light sleep allowed", CONFIG_APP_IDLE_SLEEP_AFTER_S);
+    if (s_config.on_idle) {
+        s_config.on_idle();
+    }
+}
+
+// Called with s_lock held; returns true if an idle period ended
+static bool leave_idle(int64_t wake_us)
+{
+    if (!s_idle) {
+        return false;
+    }
+    esp_pm_lock_acquire(s_no_sleep_lock);
+    esp_pm_lock_acquire(s_cpu_lock);
+    s_idle = false;
+    s_stats.idle_total_us += wake_us - s_idle_since_us;
+    s_wake_us = wake_us;
+    s_wait_report = true;
+    s_wait_link = true;
+    return true;
+}
+
+esp_err_t app_power_init(const app_power_config_t *config)
+{
+    if (!config || !config->arm_wakeup) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_lock) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_config = *config;
+
+    // Full speed while awake, XTAL while idle; light sleep whenever no lock forbids it
+    esp_pm_config_t pm_config = {};
+    pm_config.max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    pm_config.min_freq_mhz = CONFIG_XTAL_FREQ;
+    pm_config.light_sleep_enable = true;
+    esp_err_t err = esp_pm_configure(&pm_config);
+    if (err == ESP_OK) {
+        err = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "app_active", &s_no_sleep_lock);
+    }
+    if (err == ESP_OK) {
+        err = esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "app_cpu", &s_cpu_lock);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Power management not available: %s", esp_err_to_name(err));
+        return err;
+    }
+    esp_pm_lock_acquire(s_no_sleep_lock);
+    esp_pm_lock_acquire(s_cpu_lock);
+
+    s_lock = xSemaphoreCreateMutex();
+    if (!s_lock) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_timer_create_args_t timer_args = {};
+    timer_args.callback = idle_timer_cb;
+    timer_args.name = "idle";
+    err = esp_timer_create(&timer_args, &s_idle_timer);
+    if (err == ESP_OK) {
+        err = esp_timer_start_once(s_idle_timer, POWER_IDLE_AFTER_US);
+    }
+    return err;
+}
+
+void app_power_wake(int64_t wake_us)
+{
+    if (!s_lock) {
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    bool woke = leave_idle(wake_us);
+    xSemaphoreGive(s_lock);
+    if (woke) {
+        ESP_LOGI(TAG, "Motion: awake again (%" PRId64 " us ago)", esp_timer_get_time() - wake_us);
+        if (s_config.on_wake) {
+            s_config.on_wake();
+        }
+    }
+}
+
+void app_power_occupancy(bool occupied)
+{
+    if (!s_lock) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_occupied = occupied;
+    esp_timer_stop(s_idle_timer);
+    // Motion that did not come through the wake source (no wake_cb) still ends idle
+    bool woke = occupied && leave_idle(now);
+    if (occupied && s_wait_report) {
+        s_wait_report = false;
+        record_latency(&s_stats.wake_to_report, now - s_wake_us);
+    }
+    if (!occupied) {
+        esp_timer_start_once(s_idle_timer, POWER_IDLE_AFTER_US);
+    }
+    xSemaphoreGive(s_lock);
+    if (woke && s_config.on_wake) {
+        s_config.on_wake();
+    }
+}
+
+void app_power_link_frame(void)
+{
+    if (!s_wait_link) {
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (s_wait_link) {
+        s_wait_link = false;
+        record_latency(&s_stats.wake_to_link, now - s_wake_us);
+    }
+    xSemaphoreGive(s_lock);
+}
+
+bool app_power_is_idle(void)
+{
+    return s_idle;
+}
+
+static void print_latency(const char *label, const power_latency_t *lat)
+{
+    printf("%-16s n=%-5" PRIu32, label, lat->count);
+    if (lat->count) {
+        printf(" last=%" PRIu32 "ms avg=%" PRIu32 "ms max=%" PRIu32 "ms", lat->last_us / 1000,
+               (uint32_t)(lat->total_us / lat->count / 1000), lat->max_us / 1000);
+    }
+    printf("\n");
+}
+
+void app_power_print(void)
+{
+    if (!s_lock) {
+        printf("Idle sleep not running\n");
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    power_stats_t st = s_stats;
+    bool idle = s_idle;
+    int64_t idle_since = s_idle_since_us;
+    xSemaphoreGive(s_lock);
+
+    uint64_t idle_us = st.idle_total_us + (idle ? now - idle_since : 0);
+    printf("%s, idle %" PRIu64 " s of %" PRId64 " s uptime (%" PRIu32 " periods, %" PRIu32 " arm failures)\n",
+           idle ? "IDLE" : "active", idle_us / 1000000, now / 1000000, st.idle_entries, st.arm_failures);
+    print_latency("wake->occupancy", &st.wake_to_report);
+    print_latency("wake->link", &st.wake_to_link);
+    esp_pm_dump_locks(stdout);
+}
+
+#endif // CONFIG_APP_IDLE_SLEEP
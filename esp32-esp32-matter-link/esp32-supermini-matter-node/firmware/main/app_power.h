@@ -0,0 +1,58 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Idle light sleep.
+//
+// While the prop is in use the node holds a no-light-sleep and a max-CPU PM
+// lock. After CONFIG_APP_IDLE_SLEEP_AFTER_S without motion it arms the motion
+// wake source (the PIR pin) and releases both, so the tickless idle task puts
+// the chip in automatic light sleep between Wi-Fi beacons and timers. Motion
+// takes the locks back and calls on_wake, which restores the S3 link. Two
+// latencies are recorded per wake: wake edge -> occupancy reported, and wake
+// edge -> first frame from the S3. Bytes the S3 sends while the C3 sleeps are
+// lost; the S3 sees a timeout.
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+
+typedef struct {
+    /** Arm the motion wake source for the coming idle period (e.g.
+     *  pir_sensor_arm_wakeup). Anything but ESP_OK keeps the node awake. */
+    esp_err_t (*arm_wakeup)(void);
+    /** Idle period ended. Called from the task that reported the wake. */
+    void (*on_wake)(void);
+    /** Optional: an idle period started and the PM locks are released, e.g.
+     *  to stretch periodic work. Called from the esp_timer task. */
+    void (*on_idle)(void);
+} app_power_config_t;
+
+/** Configure automatic light sleep, take the PM locks and start the idle countdown.
+ *
+ * @return ESP_ERR_INVALID_ARG without arm_wakeup, ESP_ERR_INVALID_STATE if
+ *         already initialized, or the esp_pm error.
+ */
+esp_err_t app_power_init(const app_power_config_t *config);
+
+/** The motion wake source fired at `wake_us` (esp_timer clock). Ends the idle
+ *  period; call before reporting the occupancy it caused (pir_sensor wake_cb). */
+void app_power_wake(int64_t wake_us);
+
+/** Occupancy was reported. Occupied stops the idle countdown, unoccupied
+ *  (re)starts it. The first occupied report after a wake is timed. */
+void app_power_occupancy(bool occupied);
+
+/** A valid frame arrived from the S3. The first one after a wake is timed. */
+void app_power_link_frame(void);
+
+/** True while the PM locks are released. */
+bool app_power_is_idle(void);
+
+/** Print idle time and wake latencies to stdout. */
+void app_power_print(void);
@@ -0,0 +1,179 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "app_presence.h"
+
+static const char *TAG = "app_presence";
+
+// The PIR alone is enough to enter; a touch alone too. Leaving takes the PIR
+// fade (20 s, on top of the driver's own unoccupied delay) plus 10 s.
+static const app_presence_config_t PRESENCE_CONFIG = {
+    .pir_weight = 60,
+    .touch_weight = 100,
+    .pir_hold_ms = 20000,
+    .touch_hold_ms = 5000,
+    .enter_threshold = 50,
+    .exit_threshold = 30,
+    .engaged_hold_ms = 3000,
+    .leave_ms = 10000,
+};
+
+static SemaphoreHandle_t s_lock = NULL;     // Engine and timer state
+static app_presence_fusion_t s_fusion;
+static esp_timer_handle_t s_timer = NULL;
+static bool s_timer_running = false;
+
+static const char *input_name(app_presence_input_t input)
+{
+    switch (input) {
+    case APP_PRESENCE_IN_PIR_ON:    return "pir on";
+    case APP_PRESENCE_IN_PIR_OFF:   return "pir off";
+    case APP_PRESENCE_IN_TOUCH_ON:  return "touch on";
+    case APP_PRESENCE_IN_TOUCH_OFF: return "touch off";
+    default:                        return "?";
+    }
+}
+
+// Called with s_lock held after the engine moved to a new state
+static void log_transition(app_presence_state_t from, int64_t now_us)
+{
+    const app_presence_stats_t *st = &s_fusion.stats;
+    uint32_t decided_us = 0;
+    if (from == APP_PRESENCE_ABSENT) {
+        decided_us = st->arrive.last_us;
+    } else if (s_fusion.state == APP_PRESENCE_ENGAGED) {
+        decided_us = st->engage.last_us;
+    } else if (s_fusion.state == APP_PRESENCE_ABSENT) {
+        decided_us = st->depart.last_us;
+    }
+    ESP_LOGI(TAG, "%s -> %s (confidence %u, %" PRIu32 " ms after its evidence)",
+             app_presence_state_name(from), app_presence_state_name(s_fusion.state),
+             app_presence_fusion_confidence(&s_fusion, now_us), decided_us / 1000);
+}
+
+// Called with s_lock held: keep the update timer running exactly while needed
+static void schedule_updates(int64_t now_us)
+{
+    bool settled = app_presence_fusion_settled(&s_fusion, now_us);
+    if (settled && s_timer_running) {
+        esp_timer_stop(s_timer);
+        s_timer_running = false;
+    } else if (!settled && !s_timer_running) {
+        s_timer_running = esp_timer_start_periodic(s_timer, APP_PRESENCE_UPDATE_MS * 1000) == ESP_OK;
+    }
+}
+
+static void presence_timer_cb(void *arg)
+{
+    int64_t now = esp_timer_get_time();
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    app_presence_state_t from = s_fusion.state;
+    if (app_presence_fusion_update(&s_fusion, now)) {
+        log_transition(from, now);
+    }
+    schedule_updates(now);
+    xSemaphoreGive(s_lock);
+}
+
+esp_err_t app_presence_init(void)
+{
+    if (s_lock) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    app_presence_fusion_init(&s_fusion, &PRESENCE_CONFIG);
+
+    esp_timer_create_args_t timer_args = {};
+    timer_args.callback = presence_timer_cb;
+    timer_args.name = "presence";
+    esp_err_t err = esp_timer_create(&timer_args, &s_timer);
+    if (err != ESP_OK) {
+        return err;
+    }
+    s_lock = xSemaphoreCreateMutex();
+    if (!s_lock) {
+        esp_timer_delete(s_timer);
+        s_timer = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void app_presence_input(app_presence_input_t input, int64_t time_us)
+{
+    if (!s_lock) {
+        return;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    app_presence_state_t from = s_fusion.state;
+    ESP_LOGD(TAG, "Input %s, %" PRId64 " us ago", input_name(input), esp_timer_get_time() - time_us);
+    if (app_presence_fusion_feed(&s_fusion, input, time_us)) {
+        log_transition(from, time_us);
+    }
+    schedule_updates(time_us);
+    xSemaphoreGive(s_lock);
+}
+
+app_presence_state_t app_presence_get(uint8_t *confidence)
+{
+    if (!s_lock) {
+        if (confidence) {
+            *confidence = 0;
+        }
+        return APP_PRESENCE_ABSENT;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    app_presence_state_t state = s_fusion.state;
+    if (confidence) {
+        *confidence = app_presence_fusion_confidence(&s_fusion, esp_timer_get_time());
+    }
+    xSemaphoreGive(s_lock);
+    return state;
+}
+
+static void print_latency(const char *label, const app_presence_latency_t *lat)
+{
+    printf("  %-7s n=%-5" PRIu32, label, lat->count);
+    if (lat->count) {
+        printf(" last=%" PRIu32 "ms avg=%" PRIu32 "ms max=%" PRIu32 "ms", lat->last_us / 1000,
+               (uint32_t)(lat->total_us / lat->count / 1000), lat->max_us / 1000);
+    }
+    printf("\n");
+}
+
+void app_presence_print(void)
+{
+    if (!s_lock) {
+        printf("Presence not available\n");
+        return;
+    }
+    int64_t now = esp_timer_get_time();
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    app_presence_fusion_t f = s_fusion;
+    xSemaphoreGive(s_lock);
+
+    printf("%s for %" PRId64 " s, confidence %u (pir %s, touch %s)\n", app_presence_state_name(f.state),
+           (now - f.state_since_us) / 1000000, app_presence_fusion_confidence(&f, now),
+           f.pir_on ? "on" : "off", f.touch_on ? "on" : "off");
+    printf("inputs=%" PRIu32 " duplicates=%" PRIu32 " late=%" PRIu32 "\n",
+           f.stats.inputs, f.stats.duplicates, f.stats.late);
+    printf("entered:");
+    for (int s = 0; s < APP_PRESENCE_STATE_COUNT; s++) {
+        printf(" %s=%" PRIu32, app_presence_state_name((app_presence_state_t)s), f.stats.entered[s]);
+    }
+    printf("\ndecision latency:\n");
+    print_latency("arrive", &f.stats.arrive);
+    print_latency("engage", &f.stats.engage);
+    print_latency("depart", &f.stats.depart);
+}
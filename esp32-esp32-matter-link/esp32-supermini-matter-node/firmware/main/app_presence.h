@@ -0,0 +1,39 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Visitor presence on the C3.
+//
+// Owns one app_presence_fusion engine. The PIR callback and the S3 touch
+// command (CMD_TOUCH) feed it with the time the input happened; an esp_timer
+// re-evaluates it every APP_PRESENCE_UPDATE_MS while a confidence is fading or
+// a hold time is running, and stops once the state is settled. Every
+// transition is logged with how long after its evidence it was decided.
+#pragma once
+
+#include <stdint.h>
+#include <esp_err.h>
+
+#include "app_presence_fusion.h"
+
+#define APP_PRESENCE_UPDATE_MS  100
+
+/** Create the update timer.
+ *
+ * @return ESP_ERR_INVALID_STATE if already initialized.
+ */
+esp_err_t app_presence_init(void);
+
+/** Feed one input observed at `time_us` (esp_timer clock). Safe from any task;
+ *  ignored before app_presence_init(). */
+void app_presence_input(app_presence_input_t input, int64_t time_us);
+
+/** Current state and confidence (0..100, may be NULL). */
+app_presence_state_t app_presence_get(uint8_t *confidence);
+
+/** Print state, confidence, inputs and decision latencies to stdout. */
+void app_presence_print(void);
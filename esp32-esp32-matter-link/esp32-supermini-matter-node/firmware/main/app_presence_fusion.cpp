@@ -0,0 +1,218 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "app_presence_fusion.h"
+
+// At most one pass per state; transitions cannot cycle because enter > exit
+#define FUSION_MAX_STEPS    APP_PRESENCE_STATE_COUNT
+
+static uint8_t clamp_percent(uint8_t value, uint8_t min)
+{
+    return value < min ? min : (value > 100 ? 100 : value);
+}
+
+void app_presence_fusion_init(app_presence_fusion_t *f, const app_presence_config_t *cfg)
+{
+    memset(f, 0, sizeof(*f));
+    f->cfg = *cfg;
+    f->cfg.pir_weight = clamp_percent(cfg->pir_weight, 1);
+    f->cfg.touch_weight = clamp_percent(cfg->touch_weight, 1);
+    f->cfg.enter_threshold = clamp_percent(cfg->enter_threshold, 1);
+    if (f->cfg.exit_threshold >= f->cfg.enter_threshold) {
+        f->cfg.exit_threshold = f->cfg.enter_threshold - 1;
+    }
+    f->state = APP_PRESENCE_ABSENT;
+}
+
+// Full weight while active, then a linear fade over hold_ms
+static uint8_t input_weight(uint8_t weight, bool on, bool fading, int64_t off_us, uint32_t hold_ms, int64_t now_us)
+{
+    if (on) {
+        return weight;
+    }
+    if (!fading) {
+        return 0;
+    }
+    int64_t hold_us = (int64_t)hold_ms * 1000;
+    int64_t elapsed = now_us - off_us;
+    if (elapsed >= hold_us) {
+        return 0;
+    }
+    return (uint8_t)(weight * (hold_us - elapsed) / hold_us);
+}
+
+uint8_t app_presence_fusion_confidence(const app_presence_fusion_t *f, int64_t now_us)
+{
+    uint8_t pir = input_weight(f->cfg.pir_weight, f->pir_on, f->pir_fading, f->pir_off_us,
+                               f->cfg.pir_hold_ms, now_us);
+    uint8_t touch = input_weight(f->cfg.touch_weight, f->touch_on, f->touch_fading, f->touch_off_us,
+                                 f->cfg.touch_hold_ms, now_us);
+    uint8_t hi = pir > touch ? pir : touch;
+    uint8_t lo = pir > touch ? touch : pir;
+    uint32_t confidence = hi + lo / 2;
+    return confidence > 100 ? 100 : (uint8_t)confidence;
+}
+
+static void record_latency(app_presence_latency_t *lat, int64_t us)
+{
+    uint32_t value = us < 0 ? 0 : (us > UINT32_MAX ? UINT32_MAX : (uint32_t)us);
+    lat->count++;
+    lat->last_us = value;
+    lat->total_us += value;
+    if (value > lat->max_us) {
+        lat->max_us = value;
+    }
+}
+
+static void enter_state(app_presence_fusion_t *f, app_presence_state_t next, int64_t now_us)
+{
+    if (f->state == APP_PRESENCE_ABSENT && f->visit_open) {
+        record_latency(&f->stats.arrive, now_us - f->visit_start_us);
+    }
+    if (next == APP_PRESENCE_ENGAGED) {
+        record_latency(&f->stats.engage, now_us - f->touch_on_us);
+    }
+    if (next == APP_PRESENCE_ABSENT) {
+        record_latency(&f->stats.depart, now_us - f->last_input_us);
+        f->visit_open = false;
+    }
+    f->stats.entered[next]++;
+    f->state = next;
+    f->state_since_us = now_us;
+}
+
+// One transition at most; returns true if the state changed
+static bool fusion_step(app_presence_fusion_t *f, int64_t now_us)
+{
+    uint8_t confidence = app_presence_fusion_confidence(f, now_us);
+    const app_presence_config_t *cfg = &f->cfg;
+
+    switch (f->state) {
+    case APP_PRESENCE_ABSENT:
+        if (confidence >= cfg->enter_threshold) {
+            enter_state(f, f->touch_on ? APP_PRESENCE_ENGAGED : APP_PRESENCE_PRESENT, now_us);
+            return true;
+        }
+        if (confidence == 0 && !f->pir_on && !f->touch_on) {
+            f->visit_open = false;  // Evidence too weak to count as a visit, and gone
+        }
+        return false;
+
+    case APP_PRESENCE_PRESENT:
+        if (f->touch_on) {
+            enter_state(f, APP_PRESENCE_ENGAGED, now_us);
+            return true;
+        }
+        if (confidence < cfg->exit_threshold) {
+            enter_state(f, APP_PRESENCE_LEAVING, now_us);
+            return true;
+        }
+        return false;
+
+    case APP_PRESENCE_ENGAGED:
+        if (!f->touch_on && now_us - f->touch_off_us >= (int64_t)cfg->engaged_hold_ms * 1000) {
+            enter_state(f, confidence < cfg->exit_threshold ? APP_PRESENCE_LEAVING : APP_PRESENCE_PRESENT, now_us);
+            return true;
+        }
+        return false;
+
+    case APP_PRESENCE_LEAVING:
+        if (confidence >= cfg->enter_threshold) {
+            enter_state(f, f->touch_on ? APP_PRESENCE_ENGAGED : APP_PRESENCE_PRESENT, now_us);
+            return true;
+        }
+        if (now_us - f->state_since_us >= (int64_t)cfg->leave_ms * 1000) {
+            enter_state(f, APP_PRESENCE_ABSENT, now_us);
+            return true;
+        }
+        return false;
+
+    default:
+        return false;
+    }
+}
+
+static bool fusion_evaluate(app_presence_fusion_t *f, int64_t now_us)
+{
+    bool changed = false;
+    for (int i = 0; i < FUSION_MAX_STEPS && fusion_step(f, now_us); i++) {
+        changed = true;
+    }
+    return changed;
+}
+
+bool app_presence_fusion_feed(app_presence_fusion_t *f, app_presence_input_t input, int64_t time_us)
+{
+    f->stats.inputs++;
+    if (time_us < f->now_us) {
+        f->stats.late++;
+        time_us = f->now_us;
+    }
+    f->now_us = time_us;
+
+    bool *on;
+    bool *fading;
+    int64_t *edge_us;
+    bool rising = input == APP_PRESENCE_IN_PIR_ON || input == APP_PRESENCE_IN_TOUCH_ON;
+    if (input == APP_PRESENCE_IN_PIR_ON || input == APP_PRESENCE_IN_PIR_OFF) {
+        on = &f->pir_on;
+        fading = &f->pir_fading;
+        edge_us = rising ? NULL : &f->pir_off_us;
+    } else {
+        on = &f->touch_on;
+        fading = &f->touch_fading;
+        edge_us = rising ? &f->touch_on_us : &f->touch_off_us;
+    }
+
+    if (*on == rising) {
+        f->stats.duplicates++;
+    } else {
+        *on = rising;
+        *fading = !rising;
+        if (edge_us) {
+            *edge_us = time_us;
+        }
+        f->last_input_us = time_us;
+        if (rising && !f->visit_open) {
+            f->visit_open = true;
+            f->visit_start_us = time_us;
+        }
+    }
+    return fusion_evaluate(f, time_us);
+}
+
+bool app_presence_fusion_update(app_presence_fusion_t *f, int64_t now_us)
+{
+    if (now_us < f->now_us) {
+        return false;
+    }
+    f->now_us = now_us;
+    return fusion_evaluate(f, now_us);
+}
+
+bool app_presence_fusion_settled(const app_presence_fusion_t *f, int64_t now_us)
+{
+    if (!f->pir_on && f->pir_fading && now_us - f->pir_off_us < (int64_t)f->cfg.pir_hold_ms * 1000) {
+        return false;
+    }
+    if (!f->touch_on && f->touch_fading && now_us - f->touch_off_us < (int64_t)f->cfg.touch_hold_ms * 1000) {
+        return false;
+    }
+    if (f->state == APP_PRESENCE_LEAVING) {
+        return false;
+    }
+    return !(f->state == APP_PRESENCE_ENGAGED && !f->touch_on);
+}
+
+const char *app_presence_state_name(app_presence_state_t state)
+{
+    static const char *const names[APP_PRESENCE_STATE_COUNT] = { "absent", "present", "engaged", "leaving" };
+    return state < APP_PRESENCE_STATE_COUNT ? names[state] : "?";
+}
@@ -0,0 +1,122 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Presence fusion.
+//
+// Combines PIR occupancy (C3) and capacitive touch/approach (S3) into one
+// visitor state with a 0-100 confidence:
+//
+//   ABSENT --(confidence >= enter)--> PRESENT <--(touch)--> ENGAGED
+//      ^                                 |                     |
+//      +---(leave_ms)--- LEAVING <--(confidence < exit)--------+
+//
+// Each input holds full weight while active and fades linearly to zero over
+// its hold time once released; two sources at once corroborate each other
+// (the weaker adds half its weight). Entering needs `enter_threshold`, leaving
+// needs `exit_threshold`, which is lower, and LEAVING must last `leave_ms`
+// before the visitor counts as gone, so a flickering input cannot toggle the
+// state. Inputs carry their own timestamps, so a recorded trace replays to the
+// same decisions. Fixed-size state, no allocation and no RTOS or ESP-IDF
+// dependencies; the owner serializes all calls.
+//
+//   static app_presence_fusion_t s_fusion;
+//   app_presence_fusion_init(&s_fusion, &cfg);
+//   ...per input:   app_presence_fusion_feed(&s_fusion, APP_PRESENCE_IN_PIR_ON, edge_us);
+//   ...periodically until app_presence_fusion_settled(): app_presence_fusion_update(&s_fusion, now_us);
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum {
+    APP_PRESENCE_ABSENT = 0,
+    APP_PRESENCE_PRESENT,       // Someone is around (PIR, or a recent touch)
+    APP_PRESENCE_ENGAGED,       // Touching / approaching the prop
+    APP_PRESENCE_LEAVING,       // Evidence fading; back to PRESENT if it returns
+    APP_PRESENCE_STATE_COUNT
+} app_presence_state_t;
+
+typedef enum {
+    APP_PRESENCE_IN_PIR_ON = 0,
+    APP_PRESENCE_IN_PIR_OFF,
+    APP_PRESENCE_IN_TOUCH_ON,
+    APP_PRESENCE_IN_TOUCH_OFF,
+} app_presence_input_t;
+
+typedef struct {
+    uint8_t pir_weight;         // Confidence from the PIR alone, 1..100
+    uint8_t touch_weight;       // Confidence from touch alone, 1..100
+    uint32_t pir_hold_ms;       // PIR confidence fades to 0 over this long after PIR_OFF
+    uint32_t touch_hold_ms;     // Touch confidence fades to 0 over this long after TOUCH_OFF
+    uint8_t enter_threshold;    // ABSENT/LEAVING -> PRESENT at or above this
+    uint8_t exit_threshold;     // PRESENT -> LEAVING below this; below enter_threshold
+    uint32_t engaged_hold_ms;   // ENGAGED -> PRESENT this long after TOUCH_OFF
+    uint32_t leave_ms;          // LEAVING -> ABSENT after this long without recovering
+} app_presence_config_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} app_presence_latency_t;
+
+typedef struct {
+    uint32_t inputs;
+    uint32_t duplicates;        // ON while already on, OFF while already off
+    uint32_t late;              // Timestamps older than the previous input (clamped)
+    uint32_t entered[APP_PRESENCE_STATE_COUNT];
+    app_presence_latency_t arrive;  // First input of a visit -> PRESENT/ENGAGED decided
+    app_presence_latency_t engage;  // TOUCH_ON -> ENGAGED decided
+    app_presence_latency_t depart;  // Last input of a visit -> ABSENT decided
+} app_presence_stats_t;
+
+typedef struct {
+    app_presence_config_t cfg;
+    app_presence_state_t state;
+    int64_t state_since_us;
+    int64_t now_us;             // Latest input or update time
+    bool pir_on;
+    bool pir_fading;            // PIR released at pir_off_us and not yet faded out
+    int64_t pir_off_us;
+    bool touch_on;
+    bool touch_fading;
+    int64_t touch_on_us;
+    int64_t touch_off_us;
+    bool visit_open;            // An input arrived since the last ABSENT
+    int64_t visit_start_us;
+    int64_t last_input_us;
+    app_presence_stats_t stats;
+} app_presence_fusion_t;
+
+/** Reset to ABSENT at time 0. Weights and thresholds are clamped to 0..100
+ *  and the exit threshold is kept below the enter threshold. */
+void app_presence_fusion_init(app_presence_fusion_t *f, const app_presence_config_t *cfg);
+
+/** Apply one input observed at `time_us` and re-evaluate the state there.
+ *
+ * @return true if the state changed.
+ */
+bool app_presence_fusion_feed(app_presence_fusion_t *f, app_presence_input_t input, int64_t time_us);
+
+/** Re-evaluate at `now_us` without a new input (confidence fades, hold times
+ *  expire). Times older than the last input or update are ignored.
+ *
+ * @return true if the state changed.
+ */
+bool app_presence_fusion_update(app_presence_fusion_t *f, int64_t now_us);
+
+/** Confidence 0..100 at `now_us`. */
+uint8_t app_presence_fusion_confidence(const app_presence_fusion_t *f, int64_t now_us);
+
+/** True when nothing changes until the next input: no confidence is fading
+ *  and no hold time is running. Updates are only needed while this is false. */
+bool app_presence_fusion_settled(const app_presence_fusion_t *f, int64_t now_us);
+
+/** Short printable name of a state. */
+const char *app_presence_state_name(app_presence_state_t state);
@@ -0,0 +1,148 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_sensor_agg.h"
+
+void app_sensor_agg_init(app_sensor_agg_t *agg, const app_sensor_agg_config_t *cfg)
+{
+    memset(agg, 0, sizeof(*agg));
+    agg->cfg = *cfg;
+
+    uint8_t window = cfg->window;
+    agg->cfg.window = window < 1 ? 1 : (window > APP_SENSOR_AGG_WINDOW_MAX ? APP_SENSOR_AGG_WINDOW_MAX : window);
+
+    uint8_t median = cfg->median;
+    median = median < 1 ? 1 : (median > APP_SENSOR_AGG_MEDIAN_MAX ? APP_SENSOR_AGG_MEDIAN_MAX : median);
+    if ((median & 1) == 0) {
+        median--;
+    }
+    agg->cfg.median = median;
+}
+
+// Median of the last N raw samples. Until N have arrived, the median of what
+// is there (lower middle for an even count), so start-up is not delayed.
+static int32_t median_filter(app_sensor_agg_t *agg, int32_t value)
+{
+    agg->median_buf[agg->median_head] = value;
+    agg->median_head = (agg->median_head + 1) % agg->cfg.median;
+    if (agg->median_count < agg->cfg.median) {
+        agg->median_count++;
+    }
+
+    int32_t sorted[APP_SENSOR_AGG_MEDIAN_MAX];
+    uint8_t n = agg->median_count;
+    for (uint8_t i = 0; i < n; i++) {
+        int32_t v = agg->median_buf[i];
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    return sorted[(n - 1) / 2];
+}
+
+static void window_add(app_sensor_agg_t *agg, int32_t value)
+{
+    if (agg->window_count == agg->cfg.window) {
+        agg->window_sum -= agg->window_buf[agg->window_head];
+    } else {
+        agg->window_count++;
+    }
+    agg->window_buf[agg->window_head] = value;
+    agg->window_head = (agg->window_head + 1) % agg->cfg.window;
+    agg->window_sum += value;
+}
+
+// Rounded half away from zero, the same way for below-zero temperatures
+static int32_t window_mean(const app_sensor_agg_t *agg)
+{
+    int32_t n = agg->window_count;
+    int32_t sum = agg->window_sum;
+    return sum >= 0 ? (sum + n / 2) / n : -((-sum + n / 2) / n);
+}
+
+app_sensor_agg_result_t app_sensor_agg_push(app_sensor_agg_t *agg, int32_t value, bool valid, uint32_t now_ms,
+                                            int32_t *out)
+{
+    if (!valid) {
+        agg->stats.invalid++;
+        if (agg->invalid_run < UINT8_MAX) {
+            agg->invalid_run++;
+        }
+        if (agg->invalid_run != agg->cfg.lost_after) {
+            return APP_SENSOR_AGG_HOLD;
+        }
+        // Start over: readings from before the outage must not blend into the next ones
+        agg->stats.lost++;
+        agg->median_head = agg->median_count = 0;
+        agg->window_head = agg->window_count = 0;
+        agg->window_sum = 0;
+        agg->has_report = false;
+        return APP_SENSOR_AGG_LOST;
+    }
+    agg->invalid_run = 0;
+    agg->stats.samples++;
+
+    int32_t filtered = median_filter(agg, value);
+    if (filtered != value) {
+        agg->stats.replaced++;
+    }
+    window_add(agg, filtered);
+
+    int32_t mean = window_mean(agg);
+    uint32_t since = now_ms - agg->last_report_ms;      // Wraps correctly
+    bool report;
+    if (!agg->has_report) {
+        report = true;
+    } else if (agg->cfg.min_interval_ms && since < agg->cfg.min_interval_ms) {
+        report = false;
+    } else if (agg->cfg.max_interval_ms && since >= agg->cfg.max_interval_ms) {
+        report = true;
+    } else {
+        report = abs(mean - agg->last_report) >= agg->cfg.report_delta;
+    }
+
+    if (!report) {
+        agg->stats.suppressed++;
+        return APP_SENSOR_AGG_HOLD;
+    }
+    agg->has_report = true;
+    agg->last_report = mean;
+    agg->last_report_ms = now_ms;
+    agg->stats.reported++;
+    *out = mean;
+    return APP_SENSOR_AGG_REPORT;
+}
+
+void app_sensor_agg_summary(const app_sensor_agg_t *agg, app_sensor_agg_summary_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->count = agg->window_count;
+    if (agg->window_count == 0) {
+        return;
+    }
+
+    // The window is small; a rescan is cheaper than keeping a monotonic deque
+    out->min = out->max = agg->window_buf[0];
+    for (uint8_t i = 1; i < agg->window_count; i++) {
+        int32_t v = agg->window_buf[i];
+        out->min = v < out->min ? v : out->min;
+        out->max = v > out->max ? v : out->max;
+    }
+    out->mean = window_mean(agg);
+}
+
+const app_sensor_agg_stats_t *app_sensor_agg_stats(const app_sensor_agg_t *agg)
+{
+    return &agg->stats;
+}
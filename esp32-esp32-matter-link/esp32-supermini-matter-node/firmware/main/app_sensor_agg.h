@@ -0,0 +1,105 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Sensor sample aggregation.
+//
+// One aggregator per channel (temperature, humidity, ...) sits between a
+// sensor driver callback and whatever reports the value. Values are integers
+// in the unit the report uses (0.01 C, 0.01 %RH, ...), as the SHTC3 centi
+// callbacks deliver them, so there is no float math. Each raw sample goes
+// through a median-of-N filter that rejects single glitchy reads, then into a
+// sliding window that tracks mean/min/max. A rate limit decides whether the
+// window mean is worth reporting. Invalid samples (a failed read) are counted
+// and dropped; after lost_after of them in a row the channel is reported lost
+// once and starts over, so a dead sensor does not leave its last value
+// standing. Fixed-size state, no allocation and no RTOS or ESP-IDF
+// dependencies; the owner serializes all calls.
+//
+//   static app_sensor_agg_t s_temp;
+//   app_sensor_agg_init(&s_temp, &cfg);
+//   ...in the driver callback:
+//   int32_t out;
+//   switch (app_sensor_agg_push(&s_temp, centi, valid, esp_timer_get_time() / 1000, &out)) {
+//   case APP_SENSOR_AGG_REPORT: report(out); break;
+//   case APP_SENSOR_AGG_LOST: report_null(); break;
+//   default: break;
+//   }
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define APP_SENSOR_AGG_WINDOW_MAX   16
+#define APP_SENSOR_AGG_MEDIAN_MAX   7
+
+typedef struct {
+    uint8_t window;             // Samples in the mean/min/max window, 1..APP_SENSOR_AGG_WINDOW_MAX
+    uint8_t median;             // Median-of-N prefilter, 1 (off) .. APP_SENSOR_AGG_MEDIAN_MAX, odd
+    uint32_t min_interval_ms;   // Never report more often than this (0 = no limit)
+    uint32_t max_interval_ms;   // Report at least this often even if unchanged (0 = never forced)
+    int32_t report_delta;       // Report only when the mean moved at least this far (0 = every sample)
+    uint8_t lost_after;         // Consecutive invalid samples that make the channel lost (0 = never)
+} app_sensor_agg_config_t;
+
+typedef enum {
+    APP_SENSOR_AGG_HOLD = 0,    // Nothing to report
+    APP_SENSOR_AGG_REPORT,      // Report the window mean
+    APP_SENSOR_AGG_LOST,        // Report the value as unknown; the next good sample reports at once
+} app_sensor_agg_result_t;
+
+typedef struct {
+    int32_t mean;               // Rounded to the nearest unit
+    int32_t min;
+    int32_t max;
+    uint8_t count;              // Samples currently in the window
+} app_sensor_agg_summary_t;
+
+typedef struct {
+    uint32_t samples;           // Valid samples pushed
+    uint32_t invalid;           // Invalid samples dropped
+    uint32_t lost;              // Times lost_after was reached
+    uint32_t replaced;          // Raw samples that were not their own median (outlier candidates)
+    uint32_t reported;
+    uint32_t suppressed;        // Filtered samples the rate limit held back
+} app_sensor_agg_stats_t;
+
+typedef struct {
+    app_sensor_agg_config_t cfg;
+    int32_t median_buf[APP_SENSOR_AGG_MEDIAN_MAX];
+    uint8_t invalid_run;        // Consecutive invalid samples
+    uint8_t median_head;
+    uint8_t median_count;
+    int32_t window_buf[APP_SENSOR_AGG_WINDOW_MAX];
+    uint8_t window_head;
+    uint8_t window_count;
+    int32_t window_sum;         // Exact in integers, so kept running
+    bool has_report;
+    int32_t last_report;
+    uint32_t last_report_ms;
+    app_sensor_agg_stats_t stats;
+} app_sensor_agg_t;
+
+/** Reset the aggregator. Out-of-range window and median sizes are clamped;
+ *  an even median size is rounded down to the next odd one. */
+void app_sensor_agg_init(app_sensor_agg_t *agg, const app_sensor_agg_config_t *cfg);
+
+/** Feed one raw sample taken at `now_ms`; `valid` is false for a failed read.
+ *
+ * @param[out] out The window mean to report, valid when APP_SENSOR_AGG_REPORT is returned.
+ *
+ * @return APP_SENSOR_AGG_REPORT if the rate limit lets this sample through,
+ *         APP_SENSOR_AGG_LOST on the lost_after'th invalid sample in a row (once per outage).
+ */
+app_sensor_agg_result_t app_sensor_agg_push(app_sensor_agg_t *agg, int32_t value, bool valid, uint32_t now_ms,
+                                            int32_t *out);
+
+/** Mean/min/max over the current window. count is 0 before the first valid sample. */
+void app_sensor_agg_summary(const app_sensor_agg_t *agg, app_sensor_agg_summary_t *out);
+
+/** Counters since init. */
+const app_sensor_agg_stats_t *app_sensor_agg_stats(const app_sensor_agg_t *agg);
@@ -0,0 +1,45 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "app_sub_tracker.h"
+
+void app_sub_tracker_start(app_sub_tracker_t *t, int64_t now_us)
+{
+    memset(t, 0, sizeof(*t));
+    t->start_us = now_us;
+}
+
+bool app_sub_tracker_established(app_sub_tracker_t *t, int64_t now_us)
+{
+    t->active++;
+    t->established++;
+    if (t->first_us != 0) {
+        return false;
+    }
+    t->first_us = now_us > 0 ? now_us : 1;     // 0 means none
+    return true;
+}
+
+void app_sub_tracker_terminated(app_sub_tracker_t *t)
+{
+    // Handlers resumed before the callback was registered end without a start
+    if (t->active > 0) {
+        t->active--;
+    }
+    t->terminated++;
+}
+
+int64_t app_sub_tracker_first_after_start_us(const app_sub_tracker_t *t)
+{
+    if (t->first_us == 0) {
+        return -1;
+    }
+    return t->first_us > t->start_us ? t->first_us - t->start_us : 0;
+}
@@ -0,0 +1,45 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Subscription bookkeeping behind the 'matter' console command.
+//
+// Counts active, established and terminated subscriptions and times the first
+// one after boot: the moment a controller sees fresh state again. With
+// CONFIG_ENABLE_PERSIST_SUBSCRIPTIONS that is the first subscription the node
+// resumes itself; without it, the first controller that notices the reboot
+// and subscribes again. Pure bookkeeping with no Matter or RTOS dependencies;
+// app_matter_stats feeds it from its ReadHandler callback on the Matter thread.
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    uint32_t active;
+    uint32_t established;
+    uint32_t terminated;
+    int64_t start_us;           // Matter stack started, since boot
+    int64_t first_us;           // First subscription established, since boot; 0 = none yet
+} app_sub_tracker_t;
+
+/** Reset the counters and start the first-subscription timer at `now_us`
+ *  (when the Matter stack has started). */
+void app_sub_tracker_start(app_sub_tracker_t *t, int64_t now_us);
+
+/** A subscription was established (its priming report has been sent), new
+ *  or resumed.
+ *
+ * @return true for the first one since start: log its time.
+ */
+bool app_sub_tracker_established(app_sub_tracker_t *t, int64_t now_us);
+
+/** A subscription ended, or was replaced by a new one from the same controller. */
+void app_sub_tracker_terminated(app_sub_tracker_t *t);
+
+/** Time from start to the first subscription, or -1 if there has been none. */
+int64_t app_sub_tracker_first_after_start_us(const app_sub_tracker_t *t);
@@ -0,0 +1,210 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+#include "app_trace.h"
+
+typedef struct {
+    uint16_t id;                            // 0 = slot unused
+    int64_t t_us[APP_TRACE_POINT_COUNT];    // 0 = point not reached
+} trace_timeline_t;
+
+static trace_timeline_t s_timelines[APP_TRACE_HISTORY];
+static uint16_t s_next_id = 1;
+// Timelines start in the Matter task and are completed by the dispatcher
+static portMUX_TYPE s_trace_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *s_point_names[APP_TRACE_POINT_COUNT] = {
+    "matter_pre_update",
+    "debounce_decision",
+    "uart_tx_done",
+    "s3_frame_parsed",
+    "s3_handler_run",
+    "gpio_edge",
+};
+
+uint16_t app_trace_begin(void)
+{
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_trace_lock);
+    uint16_t id = s_next_id++;
+    if (s_next_id == 0) {
+        s_next_id = 1;  // 0 means "not traced"
+    }
+    trace_timeline_t *tl = &s_timelines[id % APP_TRACE_HISTORY];
+    memset(tl, 0, sizeof(*tl));
+    tl->id = id;
+    tl->t_us[APP_TRACE_MATTER_PRE_UPDATE] = now;
+    portEXIT_CRITICAL(&s_trace_lock);
+
+    return id;
+}
+
+void app_trace_mark_at(uint16_t trace_id, app_trace_point_t point, int64_t time_us)
+{
+    if (trace_id == 0 || (unsigned)point >= APP_TRACE_POINT_COUNT) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_trace_lock);
+    trace_timeline_t *tl = &s_timelines[trace_id % APP_TRACE_HISTORY];
+    if (tl->id == trace_id) {
+        tl->t_us[point] = time_us;
+    }
+    portEXIT_CRITICAL(&s_trace_lock);
+}
+
+void app_trace_mark(uint16_t trace_id, app_trace_point_t point)
+{
+    app_trace_mark_at(trace_id, point, esp_timer_get_time());
+}
+
+void app_trace_mark_s3_ack(uint16_t trace_id, int64_t ack_rx_us, uint32_t handler_offset_us,
+                           uint32_t ack_offset_us)
+{
+    if (trace_id == 0) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_trace_lock);
+    trace_timeline_t *tl = &s_timelines[trace_id % APP_TRACE_HISTORY];
+    int64_t tx_done = tl->t_us[APP_TRACE_UART_TX_DONE];
+    if (tl->id == trace_id && tx_done != 0) {
+        int64_t one_way = (ack_rx_us - tx_done - (int64_t)ack_offset_us) / 2;
+        if (one_way < 0) {
+            one_way = 0;
+        }
+        tl->t_us[APP_TRACE_S3_FRAME_PARSED] = tx_done + one_way;
+        tl->t_us[APP_TRACE_S3_HANDLER_RUN] = tx_done + one_way + handler_offset_us;
+    }
+    portEXIT_CRITICAL(&s_trace_lock);
+}
+
+void app_trace_reset(void)
+{
+    portENTER_CRITICAL(&s_trace_lock);
+    memset(s_timelines, 0, sizeof(s_timelines));
+    portEXIT_CRITICAL(&s_trace_lock);
+}
+
+// Copy the timelines out, most recent first, so printing never holds the lock
+static int trace_snapshot(trace_timeline_t *out, int last_n)
+{
+    if (last_n <= 0 || last_n > APP_TRACE_HISTORY) {
+        last_n = APP_TRACE_HISTORY;
+    }
+
+    int count = 0;
+    portENTER_CRITICAL(&s_trace_lock);
+    uint16_t newest = s_next_id - 1;
+    for (int i = 0; i < APP_TRACE_HISTORY && count < last_n; i++) {
+        uint16_t id = newest - i;
+        const trace_timeline_t *tl = &s_timelines[id % APP_TRACE_HISTORY];
+        if (id != 0 && tl->id == id) {
+            out[count++] = *tl;
+        }
+    }
+    portEXIT_CRITICAL(&s_trace_lock);
+    return count;
+}
+
+static void sort_u32(uint32_t *v, int n)
+{
+    for (int i = 1; i < n; i++) {
+        uint32_t key = v[i];
+        int j = i - 1;
+        while (j >= 0 && v[j] > key) {
+            v[j + 1] = v[j];
+            j--;
+        }
+        v[j + 1] = key;
+    }
+}
+
+static uint32_t percentile(const uint32_t *sorted, int n, int pct)
+{
+    int idx = (n * pct + 99) / 100 - 1;  // nearest-rank
+    if (idx < 0) {
+        idx = 0;
+    }
+    return sorted[idx];
+}
+
+void app_trace_print_report(int last_n)
+{
+    static trace_timeline_t snap[APP_TRACE_HISTORY];
+    uint32_t values[APP_TRACE_HISTORY];
+
+    int count = trace_snapshot(snap, last_n);
+    printf("Trigger latency over last %d triggers (us from matter_pre_update)\n", count);
+    printf("%-18s %4s %9s %9s %9s %9s\n", "point", "n", "p50", "p90", "p99", "max");
+
+    for (int p = APP_TRACE_MATTER_PRE_UPDATE + 1; p < APP_TRACE_POINT_COUNT; p++) {
+        int n = 0;
+        for (int i = 0; i < count; i++) {
+            int64_t start = snap[i].t_us[APP_TRACE_MATTER_PRE_UPDATE];
+            int64_t t = snap[i].t_us[p];
+            if (t != 0 && t >= start) {
+                values[n++] = (uint32_t)(t - start);
+            }
+        }
+        if (n == 0) {
+            printf("%-18s %4d %9s %9s %9s %9s\n", s_point_names[p], 0, "-", "-", "-", "-");
+            continue;
+        }
+        sort_u32(values, n);
+        printf("%-18s %4d %9" PRIu32 " %9" PRIu32 " %9" PRIu32 " %9" PRIu32 "\n", s_point_names[p], n,
+               percentile(values, n, 50), percentile(values, n, 90), percentile(values, n, 99), values[n - 1]);
+    }
+}
+
+void app_trace_print_last(void)
+{
+    trace_timeline_t last;
+    int order[APP_TRACE_POINT_COUNT];
+    int reached = 0;
+
+    if (trace_snapshot(&last, 1) == 0) {
+        printf("No triggers traced yet\n");
+        return;
+    }
+
+    // Print in time order: the GPIO edge usually lands before the S3 points
+    for (int p = 0; p < APP_TRACE_POINT_COUNT; p++) {
+        if (last.t_us[p] == 0) {
+            continue;
+        }
+        int j = reached++;
+        while (j > 0 && last.t_us[order[j - 1]] > last.t_us[p]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = p;
+    }
+
+    int64_t start = last.t_us[APP_TRACE_MATTER_PRE_UPDATE];
+    int64_t prev = start;
+    printf("Trace %u\n", last.id);
+    printf("%-18s %10s %10s\n", "point", "+total_us", "+step_us");
+    for (int i = 0; i < reached; i++) {
+        int64_t t = last.t_us[order[i]];
+        printf("%-18s %10" PRId64 " %10" PRId64 "\n", s_point_names[order[i]], t - start, t - prev);
+        prev = t;
+    }
+    for (int p = 0; p < APP_TRACE_POINT_COUNT; p++) {
+        if (last.t_us[p] == 0) {
+            printf("%-18s %10s %10s\n", s_point_names[p], "-", "-");
+        }
+    }
+}
@@ -0,0 +1,66 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// End-to-end trigger latency tracing.
+//
+// Each HomeKit trigger gets a trace ID at the Matter PRE_UPDATE callback. Every
+// later step marks its timestamp against that ID, giving one timeline per
+// trigger. The S3 steps are reconstructed from the offsets the S3 returns in its
+// ACK (see app_trace_mark_s3_ack). The last APP_TRACE_HISTORY timelines are kept.
+#pragma once
+
+#include <stdint.h>
+
+#define APP_TRACE_HISTORY 32
+
+typedef enum {
+    APP_TRACE_MATTER_PRE_UPDATE = 0,    // HomeKit write seen by app_attribute_update_cb
+    APP_TRACE_DEBOUNCE_DECISION,        // Dispatcher decided to run (or reject) the trigger
+    APP_TRACE_UART_TX_DONE,             // CMD_TRIGGER fully shifted out on UART
+    APP_TRACE_S3_FRAME_PARSED,          // S3 validated the frame (estimated)
+    APP_TRACE_S3_HANDLER_RUN,           // S3 ran its trigger handler (estimated)
+    APP_TRACE_GPIO_EDGE,                // Signal GPIO went HIGH
+    APP_TRACE_POINT_COUNT
+} app_trace_point_t;
+
+/** Start a new timeline and mark APP_TRACE_MATTER_PRE_UPDATE now.
+ *  Safe to call from any task.
+ *
+ * @return the trace ID (never 0).
+ */
+uint16_t app_trace_begin(void);
+
+/** Mark a point of a timeline with the current time. Unknown or evicted IDs,
+ *  and ID 0, are ignored. */
+void app_trace_mark(uint16_t trace_id, app_trace_point_t point);
+
+/** Mark a point of a timeline with an explicit esp_timer_get_time() value. */
+void app_trace_mark_at(uint16_t trace_id, app_trace_point_t point, int64_t time_us);
+
+/** Fill in the S3 points from the offsets reported in its ACK.
+ *
+ * The S3 clock is not shared, so one-way UART latency is estimated as half of
+ * the round trip minus the S3's own turnaround.
+ *
+ * @param trace_id          ID echoed by the S3
+ * @param ack_rx_us         when the ACK frame was received on the C3
+ * @param handler_offset_us S3 time from frame parsed to handler run
+ * @param ack_offset_us     S3 time from frame parsed to ACK sent
+ */
+void app_trace_mark_s3_ack(uint16_t trace_id, int64_t ack_rx_us, uint32_t handler_offset_us,
+                           uint32_t ack_offset_us);
+
+/** Print p50/p90/p99/max of every point relative to PRE_UPDATE over the last
+ *  `last_n` timelines (0 or more than APP_TRACE_HISTORY means all). */
+void app_trace_print_report(int last_n);
+
+/** Print the full timeline of the most recent trigger. */
+void app_trace_print_last(void);
+
+/** Forget all timelines. */
+void app_trace_reset(void);
@@ -0,0 +1,103 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "app_trigger_queue.h"
+
+void app_trigger_queue_init(app_trigger_queue_t *q, app_trigger_policy_t policy, uint8_t depth)
+{
+    memset(q, 0, sizeof(*q));
+    q->policy = policy;
+    switch (policy) {
+    case APP_TRIGGER_POLICY_DROP:
+        q->depth = 0;
+        break;
+    case APP_TRIGGER_POLICY_COALESCE:
+        q->depth = 1;
+        break;
+    case APP_TRIGGER_POLICY_QUEUE:
+    default:
+        q->depth = depth < 1 ? 1 : (depth > APP_TRIGGER_QUEUE_MAX ? APP_TRIGGER_QUEUE_MAX : depth);
+        break;
+    }
+}
+
+app_trigger_result_t app_trigger_queue_submit(app_trigger_queue_t *q, const app_trigger_t *trigger)
+{
+    if (!q->active) {
+        q->active = true;
+        q->current = *trigger;
+        q->stats.started++;
+        return APP_TRIGGER_STARTED;
+    }
+
+    if (q->count < q->depth) {
+        q->pending[(q->head + q->count) % APP_TRIGGER_QUEUE_MAX] = *trigger;
+        q->count++;
+        if (q->count > q->stats.max_pending) {
+            q->stats.max_pending = q->count;
+        }
+        q->stats.queued++;
+        return APP_TRIGGER_QUEUED;
+    }
+
+    if (q->policy == APP_TRIGGER_POLICY_COALESCE) {
+        // The pending run keeps its original source and trace; it will satisfy this one too
+        q->stats.coalesced++;
+        return APP_TRIGGER_COALESCED;
+    }
+
+    q->stats.dropped++;
+    return APP_TRIGGER_DROPPED;
+}
+
+bool app_trigger_queue_complete(app_trigger_queue_t *q, app_trigger_t *finished, app_trigger_t *next)
+{
+    if (!q->active) {
+        return false;
+    }
+
+    if (finished) {
+        *finished = q->current;
+    }
+    q->stats.completed++;
+
+    if (q->count == 0) {
+        q->active = false;
+        return false;
+    }
+
+    q->current = q->pending[q->head];
+    q->head = (q->head + 1) % APP_TRIGGER_QUEUE_MAX;
+    q->count--;
+    q->stats.started++;
+    if (next) {
+        *next = q->current;
+    }
+    return true;
+}
+
+uint8_t app_trigger_queue_pending(const app_trigger_queue_t *q)
+{
+    return q->count;
+}
+
+const char *app_trigger_policy_name(app_trigger_policy_t policy)
+{
+    switch (policy) {
+    case APP_TRIGGER_POLICY_DROP:
+        return "drop";
+    case APP_TRIGGER_POLICY_COALESCE:
+        return "coalesce";
+    case APP_TRIGGER_POLICY_QUEUE:
+        return "queue";
+    default:
+        return "unknown";
+    }
+}
@@ -0,0 +1,92 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Bounded skit trigger queue.
+//
+// Decides what happens to a trigger that arrives while a skit is running:
+// drop it, coalesce it into a single pending run, or queue up to N runs.
+// Pure bookkeeping with no RTOS dependencies; the owner serializes all calls
+// (the app calls it only from the event dispatcher).
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define APP_TRIGGER_QUEUE_MAX 8
+
+typedef enum {
+    APP_TRIGGER_POLICY_DROP = 0,    // Reject while busy (S3 gets BUSY)
+    APP_TRIGGER_POLICY_COALESCE,    // At most one pending run; extra triggers merge into it
+    APP_TRIGGER_POLICY_QUEUE,       // Up to `depth` pending runs, then reject
+} app_trigger_policy_t;
+
+typedef enum {
+    APP_TRIGGER_SRC_HOMEKIT = 0,    // Trigger plug written by a Matter controller
+    APP_TRIGGER_SRC_LINK,           // CMD_TRIGGER from the S3
+} app_trigger_source_t;
+
+typedef struct {
+    app_trigger_source_t source;
+    uint16_t trace_id;              // 0 if not traced
+} app_trigger_t;
+
+typedef enum {
+    APP_TRIGGER_STARTED = 0,        // Idle: the caller must start this skit now
+    APP_TRIGGER_QUEUED,             // Will start after the pending ones
+    APP_TRIGGER_COALESCED,          // Merged into the already pending run
+    APP_TRIGGER_DROPPED,            // Rejected by the policy
+} app_trigger_result_t;
+
+typedef struct {
+    uint32_t started;
+    uint32_t queued;
+    uint32_t coalesced;
+    uint32_t dropped;
+    uint32_t completed;
+    uint8_t max_pending;
+} app_trigger_stats_t;
+
+typedef struct {
+    app_trigger_policy_t policy;
+    uint8_t depth;
+    bool active;
+    app_trigger_t current;
+    app_trigger_t pending[APP_TRIGGER_QUEUE_MAX];
+    uint8_t head;
+    uint8_t count;
+    app_trigger_stats_t stats;
+} app_trigger_queue_t;
+
+/** Reset the queue to idle with the given policy.
+ *
+ * @param depth Pending capacity for APP_TRIGGER_POLICY_QUEUE, clamped to
+ *              1..APP_TRIGGER_QUEUE_MAX. Ignored by the other policies.
+ */
+void app_trigger_queue_init(app_trigger_queue_t *q, app_trigger_policy_t policy, uint8_t depth);
+
+/** Submit a trigger.
+ *
+ * @return APP_TRIGGER_STARTED if the queue was idle; the trigger is now the
+ *         current skit and the caller must start it.
+ */
+app_trigger_result_t app_trigger_queue_submit(app_trigger_queue_t *q, const app_trigger_t *trigger);
+
+/** Mark the current skit finished.
+ *
+ * @param[out] finished The skit that just completed (may be NULL).
+ * @param[out] next     The next skit to start, valid when true is returned.
+ *
+ * @return true if a pending skit became current and must be started now.
+ */
+bool app_trigger_queue_complete(app_trigger_queue_t *q, app_trigger_t *finished, app_trigger_t *next);
+
+/** Number of triggers waiting behind the current skit. */
+uint8_t app_trigger_queue_pending(const app_trigger_queue_t *q);
+
+/** Printable policy name. */
+const char *app_trigger_policy_name(app_trigger_policy_t policy);
@@ -0,0 +1,304 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <rom/ets_sys.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <driver/i2c_master.h>
+
+#include "i2c_bus.h"
+
+static const char *TAG = "i2c_bus";
+
+#define I2C_BUS_QUEUE_DEPTH     4       // Per priority; one in-flight batch per caller task
+#define I2C_BUS_TASK_STACK      3072
+#define I2C_BUS_TASK_PRIO       6       // Above the sensor sampling tasks
+
+struct i2c_bus_device {
+    bool in_use;
+    const char *name;
+    i2c_bus_prio_t prio;
+    i2c_master_dev_handle_t handle;
+    i2c_bus_device_stats_t stats;
+};
+
+// Lives on the submitting task's stack until `done` is given
+typedef struct {
+    i2c_bus_device *dev;
+    const i2c_bus_op_t *ops;
+    size_t count;
+    uint32_t timeout_ms;
+    int64_t queued_us;
+    esp_err_t result;
+    SemaphoreHandle_t done;
+} i2c_bus_request_t;
+
+static i2c_master_bus_handle_t s_bus = NULL;
+static int s_port = -1;
+static int s_sda = -1;
+static int s_scl = -1;
+static i2c_bus_device s_devices[I2C_BUS_MAX_DEVICES];
+static QueueHandle_t s_queues[I2C_BUS_PRIO_COUNT];
+static SemaphoreHandle_t s_pending = NULL;      // Counts requests across all queues
+static SemaphoreHandle_t s_config_lock = NULL;  // Guards init and device add/remove
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static esp_err_t run_op(i2c_master_dev_handle_t handle, const i2c_bus_op_t *op, uint32_t timeout_ms)
+{
+    switch (op->type) {
+    case I2C_BUS_OP_WRITE:
+        return i2c_master_transmit(handle, op->tx, op->tx_len, timeout_ms);
+    case I2C_BUS_OP_READ:
+        return i2c_master_receive(handle, op->rx, op->rx_len, timeout_ms);
+    case I2C_BUS_OP_WRITE_READ:
+        return i2c_master_transmit_receive(handle, op->tx, op->tx_len, op->rx, op->rx_len, timeout_ms);
+    case I2C_BUS_OP_DELAY_US:
+        ets_delay_us(op->delay_us);
+        return ESP_OK;
+    default:
+        return ESP_ERR_INVALID_ARG;
+    }
+}
+
+static void run_request(i2c_bus_request_t *req)
+{
+    int64_t start = esp_timer_get_time();
+    size_t done = 0;
+    esp_err_t err = ESP_OK;
+    for (; done < req->count && err == ESP_OK; done++) {
+        err = run_op(req->dev->handle, &req->ops[done], req->timeout_ms);
+    }
+    int64_t end = esp_timer_get_time();
+    uint32_t bus_us = (uint32_t)(end - start);
+    uint32_t wait_us = (uint32_t)(start - req->queued_us);
+
+    i2c_bus_device_stats_t *st = &req->dev->stats;
+    portENTER_CRITICAL(&s_stats_lock);
+    st->batches++;
+    st->ops += done;
+    if (err != ESP_OK) {
+        st->errors++;
+    }
+    st->bus_total_us += bus_us;
+    if (bus_us > st->bus_max_us) {
+        st->bus_max_us = bus_us;
+    }
+    if (wait_us > st->wait_max_us) {
+        st->wait_max_us = wait_us;
+    }
+    portEXIT_CRITICAL(&s_stats_lock);
+
+    req->result = err;
+    xSemaphoreGive(req->done);
+}
+
+// One batch per pending count, always the oldest of the highest priority waiting
+static void i2c_bus_task(void *arg)
+{
+    while (true) {
+        xSemaphoreTake(s_pending, portMAX_DELAY);
+        for (int prio = 0; prio < I2C_BUS_PRIO_COUNT; prio++) {
+            i2c_bus_request_t *req = NULL;
+            if (xQueueReceive(s_queues[prio], &req, 0) == pdTRUE) {
+                run_request(req);
+                break;
+            }
+        }
+    }
+}
+
+esp_err_t i2c_bus_init(int port, int sda_io, int scl_io)
+{
+    // First caller creates the lock; drivers initialize from app_main, one at a time
+    if (!s_config_lock) {
+        s_config_lock = xSemaphoreCreateMutex();
+        if (!s_config_lock) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    xSemaphoreTake(s_config_lock, portMAX_DELAY);
+    esp_err_t err = ESP_OK;
+    if (s_bus) {
+        if (port != s_port || sda_io != s_sda || scl_io != s_scl) {
+            ESP_LOGE(TAG, "Bus already up on port %d (SDA %d, SCL %d)", s_port, s_sda, s_scl);
+            err = ESP_ERR_INVALID_STATE;
+        }
+        xSemaphoreGive(s_config_lock);
+        return err;
+    }
+
+    for (int prio = 0; prio < I2C_BUS_PRIO_COUNT; prio++) {
+        s_queues[prio] = xQueueCreate(I2C_BUS_QUEUE_DEPTH, sizeof(i2c_bus_request_t *));
+        if (!s_queues[prio]) {
+            err = ESP_ERR_NO_MEM;
+        }
+    }
+    s_pending = xSemaphoreCreateCounting(I2C_BUS_QUEUE_DEPTH * I2C_BUS_PRIO_COUNT, 0);
+    if (!s_pending) {
+        err = ESP_ERR_NO_MEM;
+    }
+
+    if (err == ESP_OK) {
+        i2c_master_bus_config_t bus_config = {};
+        bus_config.i2c_port = port;
+        bus_config.sda_io_num = (gpio_num_t)sda_io;
+        bus_config.scl_io_num = (gpio_num_t)scl_io;
+        bus_config.clk_source = I2C_CLK_SRC_DEFAULT;
+        bus_config.glitch_ignore_cnt = 7;
+        bus_config.flags.enable_internal_pullup = true;
+        err = i2c_new_master_bus(&bus_config, &s_bus);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "I2C master bus init failed: %s", esp_err_to_name(err));
+        }
+    }
+
+    if (err == ESP_OK && xTaskCreate(i2c_bus_task, "i2c_bus", I2C_BUS_TASK_STACK, NULL, I2C_BUS_TASK_PRIO,
+                                     NULL) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create I2C bus task");
+        err = ESP_ERR_NO_MEM;
+    }
+
+    if (err != ESP_OK) {
+        if (s_bus) {
+            i2c_del_master_bus(s_bus);
+            s_bus = NULL;
+        }
+        for (int prio = 0; prio < I2C_BUS_PRIO_COUNT; prio++) {
+            if (s_queues[prio]) {
+                vQueueDelete(s_queues[prio]);
+                s_queues[prio] = NULL;
+            }
+        }
+        if (s_pending) {
+            vSemaphoreDelete(s_pending);
+            s_pending = NULL;
+        }
+    } else {
+        s_port = port;
+        s_sda = sda_io;
+        s_scl = scl_io;
+        ESP_LOGI(TAG, "I2C bus on port %d (SDA %d, SCL %d)", port, sda_io, scl_io);
+    }
+    xSemaphoreGive(s_config_lock);
+    return err;
+}
+
+esp_err_t i2c_bus_add_device(const char *name, uint16_t address, uint32_t speed_hz, i2c_bus_prio_t prio,
+                             i2c_bus_device_handle_t *out)
+{
+    if (!s_bus || !out || (unsigned)prio >= I2C_BUS_PRIO_COUNT) {
+        return s_bus ? ESP_ERR_INVALID_ARG : ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_config_lock, portMAX_DELAY);
+    i2c_bus_device *dev = NULL;
+    for (int i = 0; i < I2C_BUS_MAX_DEVICES; i++) {
+        if (!s_devices[i].in_use) {
+            dev = &s_devices[i];
+            break;
+        }
+    }
+    if (!dev) {
+        xSemaphoreGive(s_config_lock);
+        ESP_LOGE(TAG, "No free device slot for %s", name);
+        return ESP_ERR_NO_MEM;
+    }
+
+    i2c_device_config_t dev_config = {};
+    dev_config.dev_addr_length = I2C_ADDR_BIT_LEN_7;
+    dev_config.device_address = address;
+    dev_config.scl_speed_hz = speed_hz;
+    esp_err_t err = i2c_master_bus_add_device(s_bus, &dev_config, &dev->handle);
+    if (err == ESP_OK) {
+        memset(&dev->stats, 0, sizeof(dev->stats));
+        dev->name = name;
+        dev->prio = prio;
+        dev->in_use = true;
+        *out = dev;
+    } else {
+        ESP_LOGE(TAG, "Failed to add %s at 0x%02x: %s", name, address, esp_err_to_name(err));
+    }
+    xSemaphoreGive(s_config_lock);
+    return err;
+}
+
+esp_err_t i2c_bus_remove_device(i2c_bus_device_handle_t dev)
+{
+    if (!dev || !dev->in_use) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    xSemaphoreTake(s_config_lock, portMAX_DELAY);
+    esp_err_t err = i2c_master_bus_rm_device(dev->handle);
+    dev->handle = NULL;
+    dev->in_use = false;
+    xSemaphoreGive(s_config_lock);
+    return err;
+}
+
+esp_err_t i2c_bus_run(i2c_bus_device_handle_t dev, const i2c_bus_op_t *ops, size_t count, uint32_t timeout_ms)
+{
+    if (!dev || !dev->in_use || !ops || count == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Static storage on the caller's stack: no heap per transaction
+    StaticSemaphore_t done_buf;
+    i2c_bus_request_t req = {};
+    req.dev = dev;
+    req.ops = ops;
+    req.count = count;
+    req.timeout_ms = timeout_ms;
+    req.queued_us = esp_timer_get_time();
+    req.result = ESP_FAIL;
+    req.done = xSemaphoreCreateBinaryStatic(&done_buf);
+
+    i2c_bus_request_t *p = &req;
+    if (xQueueSend(s_queues[dev->prio], &p, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    xSemaphoreGive(s_pending);
+
+    // Each operation is bounded by timeout_ms, so this always returns; the
+    // request must stay alive until the worker has finished with it
+    xSemaphoreTake(req.done, portMAX_DELAY);
+    return req.result;
+}
+
+void i2c_bus_get_stats(i2c_bus_device_handle_t dev, i2c_bus_device_stats_t *out)
+{
+    portENTER_CRITICAL(&s_stats_lock);
+    *out = dev->stats;
+    portEXIT_CRITICAL(&s_stats_lock);
+}
+
+void i2c_bus_print(void)
+{
+    static const char *const prio_names[I2C_BUS_PRIO_COUNT] = { "high", "normal", "low" };
+
+    printf("%-10s %-6s %8s %8s %6s %10s %8s %8s\n", "device", "prio", "batches", "ops", "err", "bus_ms",
+           "max_us", "wait_us");
+    for (int i = 0; i < I2C_BUS_MAX_DEVICES; i++) {
+        if (!s_devices[i].in_use) {
+            continue;
+        }
+        i2c_bus_device_stats_t st;
+        i2c_bus_get_stats(&s_devices[i], &st);
+        printf("%-10s %-6s %8" PRIu32 " %8" PRIu32 " %6" PRIu32 " %10" PRIu64 " %8" PRIu32 " %8" PRIu32 "\n",
+               s_devices[i].name, prio_names[s_devices[i].prio], st.batches, st.ops, st.errors,
+               st.bus_total_us / 1000, st.bus_max_us, st.wait_max_us);
+    }
+}
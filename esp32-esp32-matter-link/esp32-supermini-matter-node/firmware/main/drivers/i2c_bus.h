@@ -0,0 +1,98 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Shared I2C bus manager.
+//
+// Owns one I2C master port and serializes every transaction on it through a
+// single worker task, so several sensor drivers can share the bus without
+// knowing about each other. Drivers register a device with a priority and
+// submit batches of operations; a batch runs back to back, without another
+// device's traffic in between, and the worker always picks the oldest batch of
+// the highest priority waiting. Bus time and queue wait are counted per device.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <esp_err.h>
+
+#define I2C_BUS_MAX_DEVICES     4
+
+typedef enum {
+    I2C_BUS_PRIO_HIGH = 0,
+    I2C_BUS_PRIO_NORMAL,
+    I2C_BUS_PRIO_LOW,
+    I2C_BUS_PRIO_COUNT,
+} i2c_bus_prio_t;
+
+typedef enum {
+    I2C_BUS_OP_WRITE = 0,       // tx[tx_len]
+    I2C_BUS_OP_READ,            // rx[rx_len]
+    I2C_BUS_OP_WRITE_READ,      // tx then rx with a repeated start
+    I2C_BUS_OP_DELAY_US,        // Busy-wait delay_us while holding the bus (keep it short)
+} i2c_bus_op_type_t;
+
+typedef struct {
+    i2c_bus_op_type_t type;
+    const uint8_t *tx;
+    size_t tx_len;
+    uint8_t *rx;
+    size_t rx_len;
+    uint32_t delay_us;
+} i2c_bus_op_t;
+
+typedef struct {
+    uint32_t batches;
+    uint32_t ops;
+    uint32_t errors;            // Batches that stopped on a failed operation
+    uint32_t bus_max_us;        // Longest single batch on the bus
+    uint64_t bus_total_us;
+    uint32_t wait_max_us;       // Longest time a batch waited for the bus
+} i2c_bus_device_stats_t;
+
+typedef struct i2c_bus_device *i2c_bus_device_handle_t;
+
+/**
+ * @brief Install the I2C master on `port` and start the bus worker.
+ *        Calling it again with the same port and pins is a no-op, so every
+ *        driver on the bus can call it from its own init.
+ *
+ * @return ESP_OK on success,
+ *         ESP_ERR_INVALID_STATE if the bus is already up with different pins,
+ *         appropriate error code otherwise
+ */
+esp_err_t i2c_bus_init(int port, int sda_io, int scl_io);
+
+/**
+ * @brief Register a 7-bit device on the bus.
+ *
+ * @param name    Shown in i2c_bus_print(); must outlive the device.
+ * @param prio    Queue priority for every batch this device submits.
+ *
+ * @return ESP_ERR_NO_MEM when I2C_BUS_MAX_DEVICES are registered.
+ */
+esp_err_t i2c_bus_add_device(const char *name, uint16_t address, uint32_t speed_hz, i2c_bus_prio_t prio,
+                             i2c_bus_device_handle_t *out);
+
+/** Unregister a device. The bus itself stays up for the others. */
+esp_err_t i2c_bus_remove_device(i2c_bus_device_handle_t dev);
+
+/**
+ * @brief Run `count` operations back to back on the bus and wait for them.
+ *        Stops at the first failed operation. Must not be called from the bus
+ *        worker or an ISR. The caller blocks on a semaphore, not the CPU.
+ *
+ * @param timeout_ms Per-operation I2C timeout.
+ */
+esp_err_t i2c_bus_run(i2c_bus_device_handle_t dev, const i2c_bus_op_t *ops, size_t count, uint32_t timeout_ms);
+
+/** Copy a device's counters. */
+void i2c_bus_get_stats(i2c_bus_device_handle_t dev, i2c_bus_device_stats_t *out);
+
+/** Print per-device bus time and queue wait to the console. */
+void i2c_bus_print(void);
@@ -13,7 +13,8 @@ extern "C" {
 #endif
 
 /**
- * @brief Callback function type for PIR sensor events.
+ * @brief Callback function type for PIR sensor events. Always called from the
+ *        PIR task, never from the GPIO ISR, so it may log and touch Matter.
  *
  * @param endpoint_id The Matter endpoint ID associated with this sensor.
  * @param occupancy True if occupied, false if not.
@@ -21,6 +22,15 @@ extern "C" {
  */
 typedef void (*pir_sensor_event_cb_t)(uint16_t endpoint_id, bool occupancy, void *user_data);
 
+/**
+ * @brief Called from the PIR task when motion ended an idle period armed with
+ *        pir_sensor_arm_wakeup(), before the occupancy callback for that motion.
+ *
+ * @param wake_us esp_timer time of the wake edge, taken in the ISR.
+ * @param user_data User data pointer passed during initialization.
+ */
+typedef void (*pir_sensor_wake_cb_t)(int64_t wake_us, void *user_data);
+
 /**
  * @brief Configuration structure for the PIR sensor.
  */
@@ -28,19 +38,84 @@ typedef struct {
     pir_sensor_event_cb_t cb;       /**< Callback function to report occupancy changes. */
     uint16_t endpoint_id;         /**< Matter endpoint ID for this sensor. */
     void *user_data;              /**< Optional user data for the callback. */
-    // We might add timer configuration here later (e.g., unoccupied_delay_sec)
+    uint32_t min_pulse_us;        /**< Ignore HIGH pulses shorter than this (0 = off). Delays the
+                                       occupied report by this much. */
+    bool hw_glitch_filter;        /**< Enable the GPIO glitch filter where the SoC has one (C3 does). */
+    uint16_t unoccupied_delay_s;  /**< Initial PIROccupiedToUnoccupiedDelay (0 = Kconfig default). */
+    pir_sensor_wake_cb_t wake_cb; /**< Optional, see pir_sensor_arm_wakeup(). */
 } pir_sensor_config_t;
 
+/**
+ * @brief Edge and callback timing counters.
+ */
+typedef struct {
+    uint32_t edges;               /**< GPIO edges seen by the ISR. */
+    uint32_t dropped;             /**< Edges that did not fit the edge ring; the newest one's level is
+                                       still applied. */
+    uint32_t isr_max_us;          /**< Longest ISR run. */
+    uint64_t isr_total_us;
+    uint32_t glitches;            /**< Pulses rejected by min_pulse_us. */
+    uint32_t processed;           /**< Edges run through the task's edge handler. */
+    uint32_t process_max_us;      /**< Longest handling of one edge, callback included. */
+    uint64_t process_total_us;
+    uint32_t wakeups;             /**< Wake edges after pir_sensor_arm_wakeup(). */
+    uint32_t callbacks;           /**< Occupancy changes reported. */
+    uint32_t latency_max_us;      /**< Worst edge (or timer expiry) to callback start. */
+    uint64_t latency_total_us;
+} pir_sensor_stats_t;
+
 /**
  * @brief Initialize the PIR motion sensor
  *
  * Configures the GPIO pin for the PIR sensor and sets up interrupt handling.
+ * The ISR only records the level and time of each edge in a ring, keeping
+ * the newest edge aside when the ring is full; a task runs the pulse filter,
+ * the occupancy logic and the callback.
  *
  * @param config Pointer to the PIR sensor configuration structure.
- * @return esp_err_t ESP_OK on success, or an error code on failure.
+ * @return esp_err_t ESP_OK on success,
+ *                   ESP_ERR_INVALID_STATE if the driver is already initialized,
+ *                   or an error code on failure.
  */
 esp_err_t pir_sensor_init(const pir_sensor_config_t *config);
 
+/**
+ * @brief Make the next rising edge a light-sleep wake source.
+ *
+ * Switches the pin to a HIGH-level wake-up and enables GPIO wake-up, so motion
+ * ends light sleep (automatic or explicit). The first HIGH level after this is
+ * handled as a normal rising edge, calls wake_cb and disarms the wake-up again.
+ * Arm once per idle period.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if the driver is not running, already
+ *         armed or the PIR output is HIGH now, or the GPIO error.
+ */
+esp_err_t pir_sensor_arm_wakeup(void);
+
+/**
+ * @brief Set the occupied-to-unoccupied delay.
+ *
+ * The driver keeps its own copy so the PIR task never reads Matter attributes.
+ * Call this from the Matter attribute callback on a POST_UPDATE of
+ * OccupancySensing PIROccupiedToUnoccupiedDelay, and once after the endpoint is
+ * created with the stored value. Safe from any task and before pir_sensor_init().
+ * A running timer keeps its old deadline; the new value applies from the next motion.
+ *
+ * @param seconds Delay in seconds.
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG for 0.
+ */
+esp_err_t pir_sensor_set_unoccupied_delay(uint16_t seconds);
+
+/**
+ * @brief Current occupied-to-unoccupied delay in seconds.
+ */
+uint16_t pir_sensor_get_unoccupied_delay(void);
+
+/**
+ * @brief Copy the edge and callback timing counters.
+ */
+void pir_sensor_get_stats(pir_sensor_stats_t *stats);
+
 /**
  * @brief Get the current occupancy state.
  * 
@@ -1,97 +1,346 @@
 #include <stdio.h>
+#include <inttypes.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
 #include "driver/gpio.h"
+#include "driver/gpio_filter.h"
+#include "esp_sleep.h"
+#include "soc/soc_caps.h"
 #include "esp_log.h"
 #include "pir_sensor.h"
 
 // ESP IDF timer includes
 #include "esp_timer.h"
 
-// Forward declaration for the C-callable function in app_main.cpp
-extern uint16_t get_pir_unoccupied_delay_seconds(uint16_t endpoint_id);
-
 static const char *TAG = "pir_sensor";
 
-// Queue to send GPIO events from ISR to a task
-static QueueHandle_t gpio_evt_queue = NULL;
+// One GPIO edge as seen by the ISR: the level right after the edge and when
+// it happened. The task works from these, so a late task still sees accurate
+// edge timing, and an edge that is already over by the time it runs is not
+// misread from the pin.
+typedef struct {
+    int64_t time_us;
+    uint8_t level;
+} pir_edge_t;
+
+// Single-producer (ISR) / single-consumer (task) ring; power of two. When it
+// is full the ISR still records the newest edge in g_last_edge and flags the
+// overflow, so the task ends on the pin's latest level instead of the last
+// edge that fitted.
+#define PIR_EDGE_RING_SIZE 16
+static pir_edge_t g_ring[PIR_EDGE_RING_SIZE];
+static uint32_t g_ring_head = 0;    // Written by the ISR only
+static uint32_t g_ring_tail = 0;    // Written by the task only
+static pir_edge_t g_last_edge;      // Newest edge, ring or not
+static bool g_ring_overflow = false;
+static portMUX_TYPE g_edge_lock = portMUX_INITIALIZER_UNLOCKED;    // Head, last edge and overflow together
+
+// Task notification bits
+#define PIR_NOTIFY_EDGE     (1 << 0)
+#define PIR_NOTIFY_TIMEOUT  (1 << 1)
+#define PIR_NOTIFY_WAKE     (1 << 2)
+
+static TaskHandle_t g_pir_task = NULL;
+static int64_t g_timeout_us = 0;    // When the unoccupied timer fired
+
+// Set by pir_sensor_arm_wakeup(): the pin is a HIGH-level wake source, so
+// its interrupt is level-triggered until the task restores edge interrupts
+static volatile bool g_wake_armed = false;
+static int64_t g_wake_us = 0;       // ISR time of the wake edge
 
 // Occupancy state - true if occupied, false if not.
-// This should be updated and used to drive Matter cluster updates.
+// Owned by pir_sensor_task; the only place the callback runs.
 static volatile bool g_occupancy_state = false; 
 static pir_sensor_config_t g_pir_config;
 static esp_timer_handle_t g_unoccupied_timer = NULL;
 
-// Forward declaration of the ISR handler
-static void IRAM_ATTR gpio_isr_handler(void* arg);
-// Forward declaration of the task that will process PIR events
-static void pir_sensor_task(void* arg);
-// Forward declaration for timer callback
-static void unoccupied_timer_callback(void* arg);
+// Filtered PIR output, owned by the task
+static bool g_level_high = false;
+static bool g_rise_pending = false; // Rising edge waiting out min_pulse_us
+static int64_t g_rise_us = 0;
+
+// PIROccupiedToUnoccupiedDelay, seconds. Written by whatever task runs the
+// Matter attribute callback, read by the PIR task on every rising edge.
+static uint32_t g_unoccupied_delay_s = CONFIG_PIR_OCCUPIED_TO_UNOCCUPIED_DELAY_SECONDS;
+
+static pir_sensor_stats_t g_stats;
+static portMUX_TYPE g_stats_lock = portMUX_INITIALIZER_UNLOCKED;
 
 static void IRAM_ATTR gpio_isr_handler(void* arg)
 {
+    int64_t start = esp_timer_get_time();
     uint32_t gpio_num = (uint32_t) arg;
-    // For now, we just send the event to the queue. 
-    // More sophisticated logic might be needed if debouncing becomes an issue,
-    // or if we want to distinguish RISING/FALLING edges directly in ISR (though generally better in task).
-    xQueueSendFromISR(gpio_evt_queue, &gpio_num, NULL);
+    uint32_t notify = PIR_NOTIFY_EDGE;
+
+    if (g_wake_armed) {
+        // The level interrupt would keep firing while the pin is HIGH
+        g_wake_armed = false;
+        gpio_intr_disable(gpio_num);
+        g_wake_us = start;
+        notify |= PIR_NOTIFY_WAKE;
+    }
+
+    pir_edge_t edge = { start, (uint8_t)gpio_get_level(gpio_num) };
+    portENTER_CRITICAL_ISR(&g_edge_lock);
+    uint32_t head = g_ring_head;
+    uint32_t tail = __atomic_load_n(&g_ring_tail, __ATOMIC_ACQUIRE);
+    bool full = head - tail >= PIR_EDGE_RING_SIZE;
+    if (!full) {
+        g_ring[head % PIR_EDGE_RING_SIZE] = edge;
+        __atomic_store_n(&g_ring_head, head + 1, __ATOMIC_RELEASE);
+    } else {
+        g_ring_overflow = true;
+    }
+    g_last_edge = edge;
+    portEXIT_CRITICAL_ISR(&g_edge_lock);
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(g_pir_task, notify, eSetBits, &woken);
+
+    uint32_t duration = (uint32_t)(esp_timer_get_time() - start);
+    portENTER_CRITICAL_ISR(&g_stats_lock);
+    g_stats.edges++;
+    if (full) {
+        g_stats.dropped++;
+    }
+    g_stats.isr_total_us += duration;
+    if (duration > g_stats.isr_max_us) {
+        g_stats.isr_max_us = duration;
+    }
+    portEXIT_CRITICAL_ISR(&g_stats_lock);
+
+    if (woken) {
+        portYIELD_FROM_ISR();
+    }
 }
 
 static void unoccupied_timer_callback(void* arg)
 {
-    ESP_LOGI(TAG, "Unoccupied timer expired. Setting state to UNOCCUPIED.");
-    g_occupancy_state = false;
-    if (g_pir_config.cb) {
-        g_pir_config.cb(g_pir_config.endpoint_id, g_occupancy_state, g_pir_config.user_data);
+    g_timeout_us = esp_timer_get_time();
+    xTaskNotify(g_pir_task, PIR_NOTIFY_TIMEOUT, eSetBits);
+}
+
+static void pir_report(bool occupied, int64_t event_us)
+{
+    g_occupancy_state = occupied;
+    if (!g_pir_config.cb) {
+        return;
+    }
+    // Latency up to the start of the callback: task wake-up, plus min_pulse_us
+    // for a rising edge when the pulse filter is on
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - event_us);
+    portENTER_CRITICAL(&g_stats_lock);
+    g_stats.callbacks++;
+    g_stats.latency_total_us += latency;
+    if (latency > g_stats.latency_max_us) {
+        g_stats.latency_max_us = latency;
+    }
+    portEXIT_CRITICAL(&g_stats_lock);
+    g_pir_config.cb(g_pir_config.endpoint_id, occupied, g_pir_config.user_data);
+}
+
+// Motion detected (PIR output HIGH) at rise_us
+static void pir_accept_rise(int64_t rise_us)
+{
+    g_level_high = true;
+    if (!g_occupancy_state) {
+        ESP_LOGI(TAG, "Motion DETECTED. Setting state to OCCUPIED.");
+        pir_report(true, rise_us);
+    }
+    // Whether previously occupied or not, if motion is detected, (re)start the unoccupied timer.
+    if (g_unoccupied_timer) {
+        uint32_t delay_seconds = __atomic_load_n(&g_unoccupied_delay_s, __ATOMIC_RELAXED);
+        esp_timer_stop(g_unoccupied_timer);
+        esp_timer_start_once(g_unoccupied_timer, (uint64_t)delay_seconds * 1000000ULL);
+        ESP_LOGI(TAG, "Unoccupied timer (re)started for %" PRIu32 " seconds.", delay_seconds);
+    }
+}
+
+// Motion stopped (PIR output LOW - this happens after PIR's internal delay)
+static void pir_accept_fall(void)
+{
+    g_level_high = false;
+    // The PIR output going LOW doesn't immediately mean UNOCCUPIED from Matter's perspective.
+    // The g_unoccupied_timer handles the transition to UNOCCUPIED.
+    // We log this event for debugging but don't change g_occupancy_state here.
+    ESP_LOGI(TAG, "PIR output LOW (raw signal). Occupancy state remains %s until the unoccupied timer expires.",
+             g_occupancy_state ? "OCCUPIED" : "UNOCCUPIED");
+}
+
+// Works from levels rather than edge direction: repeated levels are ignored,
+// so the task can replay the newest edge after an overflow without inverting
+// the state
+static void pir_process_edge(const pir_edge_t *edge)
+{
+    ESP_LOGD(TAG, "PIR edge level %d at %" PRId64 " us. Current g_occupancy_state: %s",
+             edge->level, edge->time_us, g_occupancy_state ? "OCCUPIED" : "UNOCCUPIED");
+
+    if (edge->level) {
+        if (g_level_high || g_rise_pending) {
+            return;
+        }
+        if (g_pir_config.min_pulse_us == 0) {
+            pir_accept_rise(edge->time_us);
+        } else {
+            g_rise_pending = true;
+            g_rise_us = edge->time_us;
+        }
+        return;
+    }
+
+    if (g_rise_pending) {
+        g_rise_pending = false;
+        if (edge->time_us - g_rise_us < g_pir_config.min_pulse_us) {
+            portENTER_CRITICAL(&g_stats_lock);
+            g_stats.glitches++;
+            portEXIT_CRITICAL(&g_stats_lock);
+            ESP_LOGD(TAG, "Rejected %" PRId64 " us pulse", edge->time_us - g_rise_us);
+            return;
+        }
+        // Long enough, but both edges arrived together: take the rise first
+        pir_accept_rise(g_rise_us);
+    }
+    if (g_level_high) {
+        pir_accept_fall();
     }
 }
 
 static void pir_sensor_task(void* arg)
 {
-    uint32_t io_num;
     for(;;) {
-        if(xQueueReceive(gpio_evt_queue, &io_num, portMAX_DELAY)) {
-            bool current_level = gpio_get_level(io_num);
-            ESP_LOGD(TAG, "GPIO[%lu] intr, val: %d. Current g_occupancy_state: %s", 
-                     io_num, current_level, g_occupancy_state ? "OCCUPIED" : "UNOCCUPIED");
-
-            if (current_level == 1) { // Motion detected (PIR output HIGH)
-                if (!g_occupancy_state) {
-                    ESP_LOGI(TAG, "Motion DETECTED. Setting state to OCCUPIED.");
-                    g_occupancy_state = true;
-                    if (g_pir_config.cb) {
-                        g_pir_config.cb(g_pir_config.endpoint_id, g_occupancy_state, g_pir_config.user_data);
-                    }
-                }
-                // Whether previously occupied or not, if motion is detected, (re)start the unoccupied timer.
-                if (g_unoccupied_timer) {
-                    uint16_t delay_seconds = get_pir_unoccupied_delay_seconds(g_pir_config.endpoint_id);
-                    ESP_LOGI(TAG, "Using unoccupied delay of %u seconds from Matter attribute.", delay_seconds);
-                    esp_timer_stop(g_unoccupied_timer);
-                    esp_timer_start_once(g_unoccupied_timer, (uint64_t)delay_seconds * 1000000ULL);
-                    ESP_LOGI(TAG, "Unoccupied timer (re)started for %u seconds.", delay_seconds);
-                }
-            } else { // Motion stopped (PIR output LOW - this happens after PIR's internal delay)
-                // The PIR output going LOW doesn't immediately mean UNOCCUPIED from Matter's perspective.
-                // The g_unoccupied_timer handles the transition to UNOCCUPIED.
-                // We log this event for debugging but don't change g_occupancy_state here.
-                uint16_t delay_seconds = get_pir_unoccupied_delay_seconds(g_pir_config.endpoint_id);
-                ESP_LOGI(TAG, "PIR output LOW (raw signal). Occupancy state remains %s until %us timer expires.", 
-                         g_occupancy_state ? "OCCUPIED" : "UNOCCUPIED", delay_seconds);
+        // While a rise is pending, wake up when its pulse becomes long enough
+        TickType_t wait = portMAX_DELAY;
+        if (g_rise_pending) {
+            int64_t remaining_us = g_rise_us + g_pir_config.min_pulse_us - esp_timer_get_time();
+            wait = remaining_us > 0 ? pdMS_TO_TICKS((remaining_us + 999) / 1000) + 1 : 0;
+        }
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, wait);
+
+        if (bits & PIR_NOTIFY_WAKE) {
+            // Back to edge interrupts; wake_cb runs before the occupied report
+            gpio_wakeup_disable(PIR_SENSOR_GPIO_PIN);
+            gpio_set_intr_type(PIR_SENSOR_GPIO_PIN, GPIO_INTR_ANYEDGE);
+            gpio_intr_enable(PIR_SENSOR_GPIO_PIN);
+            portENTER_CRITICAL(&g_stats_lock);
+            g_stats.wakeups++;
+            portEXIT_CRITICAL(&g_stats_lock);
+            if (g_pir_config.wake_cb) {
+                g_pir_config.wake_cb(g_wake_us, g_pir_config.user_data);
             }
         }
+
+        // The last edge is read with the head, so it is never older than the
+        // ring entries drained below
+        portENTER_CRITICAL(&g_edge_lock);
+        uint32_t head = g_ring_head;
+        bool overflow = g_ring_overflow;
+        g_ring_overflow = false;
+        pir_edge_t last = g_last_edge;
+        portEXIT_CRITICAL(&g_edge_lock);
+
+        while (g_ring_tail != head || overflow) {
+            pir_edge_t edge;
+            if (g_ring_tail != head) {
+                edge = g_ring[g_ring_tail % PIR_EDGE_RING_SIZE];
+                __atomic_store_n(&g_ring_tail, g_ring_tail + 1, __ATOMIC_RELEASE);
+            } else {
+                // Edges were dropped after the ring filled: finish on the newest
+                edge = last;
+                overflow = false;
+            }
+
+            int64_t start = esp_timer_get_time();
+            pir_process_edge(&edge);
+            uint32_t duration = (uint32_t)(esp_timer_get_time() - start);
+            portENTER_CRITICAL(&g_stats_lock);
+            g_stats.processed++;
+            g_stats.process_total_us += duration;
+            if (duration > g_stats.process_max_us) {
+                g_stats.process_max_us = duration;
+            }
+            portEXIT_CRITICAL(&g_stats_lock);
+        }
+
+        // A fall between the wake edge and the restore raised no edge, so
+        // feed the current level in case it is LOW again already
+        if ((bits & PIR_NOTIFY_WAKE) && !gpio_get_level(PIR_SENSOR_GPIO_PIN)) {
+            pir_edge_t edge = { esp_timer_get_time(), 0 };
+            pir_process_edge(&edge);
+        }
+
+        if (g_rise_pending && esp_timer_get_time() - g_rise_us >= g_pir_config.min_pulse_us) {
+            g_rise_pending = false;
+            pir_accept_rise(g_rise_us);
+        }
+
+        // Checked after the edges: motion that raced the timer has re-armed it
+        if ((bits & PIR_NOTIFY_TIMEOUT) && g_occupancy_state && !esp_timer_is_active(g_unoccupied_timer)) {
+            ESP_LOGI(TAG, "Unoccupied timer expired. Setting state to UNOCCUPIED.");
+            pir_report(false, g_timeout_us);
+        }
     }
 }
 
+void pir_sensor_get_stats(pir_sensor_stats_t *stats)
+{
+    portENTER_CRITICAL(&g_stats_lock);
+    *stats = g_stats;
+    portEXIT_CRITICAL(&g_stats_lock);
+}
+
+esp_err_t pir_sensor_arm_wakeup(void)
+{
+    if (!g_pir_task || g_wake_armed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (gpio_get_level(PIR_SENSOR_GPIO_PIN)) {
+        return ESP_ERR_INVALID_STATE;   // Motion right now; it would wake at once
+    }
+    // Armed before the interrupt type changes, so a HIGH level that arrives
+    // in between is already handled as the wake edge by the ISR
+    g_wake_armed = true;
+    esp_err_t ret = gpio_wakeup_enable(PIR_SENSOR_GPIO_PIN, GPIO_INTR_HIGH_LEVEL);
+    if (ret == ESP_OK) {
+        ret = esp_sleep_enable_gpio_wakeup();
+    }
+    if (ret != ESP_OK) {
+        g_wake_armed = false;
+        gpio_wakeup_disable(PIR_SENSOR_GPIO_PIN);
+        gpio_set_intr_type(PIR_SENSOR_GPIO_PIN, GPIO_INTR_ANYEDGE);
+        gpio_intr_enable(PIR_SENSOR_GPIO_PIN);
+        ESP_LOGE(TAG, "Failed to arm GPIO wake-up: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t pir_sensor_set_unoccupied_delay(uint16_t seconds)
+{
+    if (seconds == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    __atomic_store_n(&g_unoccupied_delay_s, (uint32_t)seconds, __ATOMIC_RELAXED);
+    ESP_LOGI(TAG, "Unoccupied delay set to %u seconds", seconds);
+    return ESP_OK;
+}
+
+uint16_t pir_sensor_get_unoccupied_delay(void)
+{
+    return (uint16_t)__atomic_load_n(&g_unoccupied_delay_s, __ATOMIC_RELAXED);
+}
+
 esp_err_t pir_sensor_init(const pir_sensor_config_t *config)
 {
     if (!config || !config->cb) {
         ESP_LOGE(TAG, "Invalid configuration or callback missing.");
         return ESP_ERR_INVALID_ARG;
     }
+    if (g_pir_task) {
+        return ESP_ERR_INVALID_STATE;
+    }
     g_pir_config = *config;
+    if (config->unoccupied_delay_s) {
+        pir_sensor_set_unoccupied_delay(config->unoccupied_delay_s);
+    }
 
     ESP_LOGI(TAG, "Initializing PIR sensor on GPIO %d", PIR_SENSOR_GPIO_PIN);
 
@@ -107,19 +356,27 @@ esp_err_t pir_sensor_init(const pir_sensor_config_t *config)
         return ret;
     }
 
-    // Create a queue to handle gpio event from isr
-    gpio_evt_queue = xQueueCreate(10, sizeof(uint32_t));
-    if (!gpio_evt_queue) {
-        ESP_LOGE(TAG, "Failed to create GPIO event queue");
-        return ESP_FAIL;
+    if (g_pir_config.hw_glitch_filter) {
+#if SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER
+        // Drops pulses shorter than two IO_MUX clock cycles before they reach the ISR
+        gpio_pin_glitch_filter_config_t filter_conf = {};
+        filter_conf.clk_src = GLITCH_FILTER_CLK_SRC_DEFAULT;
+        filter_conf.gpio_num = PIR_SENSOR_GPIO_PIN;
+        gpio_glitch_filter_handle_t filter = NULL;
+        ret = gpio_new_pin_glitch_filter(&filter_conf, &filter);
+        if (ret == ESP_OK) {
+            ret = gpio_glitch_filter_enable(filter);
+        }
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "GPIO glitch filter not enabled: %s", esp_err_to_name(ret));  // Not fatal
+        }
+#else
+        ESP_LOGW(TAG, "No GPIO glitch filter on this target");
+#endif
     }
 
-    // Start the PIR sensor task
-    if (xTaskCreate(pir_sensor_task, "pir_sensor_task", 3072, NULL, 10, NULL) != pdPASS) {
-        ESP_LOGE(TAG, "Failed to create PIR sensor task");
-        vQueueDelete(gpio_evt_queue);
-        return ESP_FAIL;
-    }
+    // Level at init, so the first edge is classified correctly
+    g_level_high = gpio_get_level(PIR_SENSOR_GPIO_PIN);
 
     // Initialize the one-shot timer for unoccupied delay
     const esp_timer_create_args_t unoccupied_timer_args = {
@@ -129,39 +386,40 @@ esp_err_t pir_sensor_init(const pir_sensor_config_t *config)
     ret = esp_timer_create(&unoccupied_timer_args, &g_unoccupied_timer);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to create unoccupied timer: %s", esp_err_to_name(ret));
-        // Proper cleanup of queue and task would be needed here
         return ret;
     }
 
+    // Start the PIR sensor task
+    if (xTaskCreate(pir_sensor_task, "pir_sensor_task", 3072, NULL, 10, &g_pir_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create PIR sensor task");
+        esp_timer_delete(g_unoccupied_timer);
+        g_unoccupied_timer = NULL;
+        g_pir_task = NULL;
+        return ESP_FAIL;
+    }
+
     // Install gpio isr service
     ret = gpio_install_isr_service(ESP_INTR_FLAG_LEVEL1); // Using LEVEL1 for potentially faster response
-    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) { // ESP_ERR_INVALID_STATE means already installed
-        ESP_LOGE(TAG, "Error installing GPIO ISR service: %s", esp_err_to_name(ret));
-        vQueueDelete(gpio_evt_queue);
-        // Potentially stop task if created, but it won't receive events.
-        return ret;
-    }
-    if (ret == ESP_ERR_INVALID_STATE) {
+    if (ret == ESP_ERR_INVALID_STATE) { // ESP_ERR_INVALID_STATE means already installed
         ESP_LOGW(TAG, "GPIO ISR service already installed. Proceeding.");
+        ret = ESP_OK;
     }
 
     // Hook isr handler for specific gpio pin
-    ret = gpio_isr_handler_add(PIR_SENSOR_GPIO_PIN, gpio_isr_handler, (void*) PIR_SENSOR_GPIO_PIN);
+    if (ret == ESP_OK) {
+        ret = gpio_isr_handler_add(PIR_SENSOR_GPIO_PIN, gpio_isr_handler, (void*) PIR_SENSOR_GPIO_PIN);
+    }
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Error adding ISR handler for GPIO %d: %s", PIR_SENSOR_GPIO_PIN, esp_err_to_name(ret));
-        // Clean up: remove ISR service if we exclusively installed it, delete queue, stop task
-        if (ret != ESP_ERR_INVALID_STATE) gpio_uninstall_isr_service();
-        vQueueDelete(gpio_evt_queue);
-        // Need a way to stop the task here, or ensure it handles queue deletion gracefully.
+        ESP_LOGE(TAG, "Error hooking ISR for GPIO %d: %s", PIR_SENSOR_GPIO_PIN, esp_err_to_name(ret));
+        // The ISR service may be shared with other drivers, so it stays installed
+        vTaskDelete(g_pir_task);
+        g_pir_task = NULL;
+        esp_timer_delete(g_unoccupied_timer);
+        g_unoccupied_timer = NULL;
         return ret;
     }
 
-    ESP_LOGI(TAG, "PIR sensor initialized successfully. Unoccupied delay will be read from Matter attribute.");
+    ESP_LOGI(TAG, "PIR sensor initialized successfully. Unoccupied delay %u seconds.",
+             pir_sensor_get_unoccupied_delay());
     return ESP_OK;
 }
-
-// TODO:
-// 1. Implement timer logic for "unoccupied" delay.
-// 2. Integrate with Matter: call esp_matter_attribute_update when g_occupancy_state changes.
-//    - Need to know the endpoint ID and cluster ID for OccupancySensing.
-// 3. Add Kconfig option for PIR_SENSOR_GPIO_PIN (e.g., CONFIG_PIR_SENSOR_GPIO_NUM) 
\ No newline at end of file
@@ -4,171 +4,445 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <freertos/timers.h>
-#include <esp_heap_caps.h>
+#include <stdio.h>
 #include <string.h>
 #include <math.h>
-#include <driver/i2c.h> // Use legacy I2C driver
 #include <cmath> // For NAN
 #include <inttypes.h> // For PRIu32
 
-#include <lib/support/CodeUtils.h>
-#include <esp_matter.h> // For chip::app::Clusters and esp_matter_invalid
-#include <app/ConcreteAttributePath.h> // For chip::app::Clusters definitions
+#if CONFIG_SHTC3_CONVERSION_BENCHMARK
+#include <esp_cpu.h>
+#endif
 
+#include "i2c_bus.h"
 #include "shtc3.h"
+#include "shtc3_proto.h"
 
 #define I2C_MASTER_SCL_IO           CONFIG_SHTC3_I2C_SCL_PIN      /*!< gpio number for I2C master clock */
 #define I2C_MASTER_SDA_IO           CONFIG_SHTC3_I2C_SDA_PIN      /*!< gpio number for I2C master data  */
-#define I2C_MASTER_NUM              I2C_NUM_0                     /*!< I2C port number for master dev */
+#define I2C_MASTER_NUM              0                             /*!< I2C port number for master dev */
 #define I2C_MASTER_FREQ_HZ          400000                        /*!< I2C master clock frequency */
-#define SHTC3_SENSOR_ADDR           0x70                          /*!< slave address for SHTC3 sensor */
-
-// SHTC3 Commands (Needed for shtc3_sensor_init internal operations)
-#define SHTC3_WAKE_UP_COMMAND_MSB           0x35
-#define SHTC3_WAKE_UP_COMMAND_LSB           0x17
-#define SHTC3_SLEEP_COMMAND_MSB             0xB0
-#define SHTC3_SLEEP_COMMAND_LSB             0x98
-#define SHTC3_READ_ID_COMMAND_MSB           0xEF
-#define SHTC3_READ_ID_COMMAND_LSB           0xC8
-#define SHTC3_MEASURE_T_FIRST_MSB           0x7C // Low power, T first, Clock stretching enabled
-#define SHTC3_MEASURE_T_FIRST_LSB           0xA2 // Low power, T first, Clock stretching enabled
+#define I2C_MASTER_TIMEOUT_MS       20                            /*!< a 6-byte transfer takes ~0.2 ms */
+
+// Measurement commands, T first, without clock stretching: the sensor NACKs
+// reads until the conversion is done, so the bus is free while it converts
+// and we come back after a timer. Conversion times are datasheet maxima; the
+// timer uses the time measured at init when there is one.
+typedef struct {
+    uint16_t cmd;
+    uint32_t conversion_us;
+    const char *name;
+} shtc3_profile_desc_t;
+
+static const shtc3_profile_desc_t g_profiles[SHTC3_PROFILE_COUNT] = {
+    { SHTC3_CMD_MEASURE_NORMAL,    12100, "normal" },      // SHTC3_PROFILE_NORMAL
+    { SHTC3_CMD_MEASURE_LOW_POWER, 800,   "low-power" },   // SHTC3_PROFILE_LOW_POWER
+};
 
 static const char *TAG = "shtc3_driver";
 
-#define SHTC3_PRODUCT_CODE_MASK             0x083F // From datasheet, bits 5 and 11-15 are don't care
-#define SHTC3_PRODUCT_CODE_SHTC3            0x0807 // SHTC3 product code is 0b0000_1000_0xxx_0111
+// Conversion measurement at init: poll every SHTC3_POLL_US until the read is
+// ACKed, for at most twice the datasheet time. The timer then waits the
+// measured time plus a quarter, never longer than the datasheet maximum.
+#define SHTC3_POLL_US               100
+#define SHTC3_WAIT_MARGIN(us)       ((us) + (us) / 4)
 
-#define SHTC3_PRODUCT_CODE_SIZE_BYTES       2
+// Sampling task notification bits
+#define SHTC3_NOTIFY_SAMPLE                 (1 << 0)    // Interval timer: start a measurement
+#define SHTC3_NOTIFY_READY                  (1 << 1)    // Conversion timer: collect the result
 
 // Global static variable to store the sensor configuration
 static shtc3_sensor_config_t *g_sensor_config = NULL;
 // Global static variable for the timer handle
 static TimerHandle_t g_sensor_timer_handle = NULL;
+// Long-lived sampling task, woken by the timer once per interval
+static TaskHandle_t g_sensor_task_handle = NULL;
+#define SHTC3_SAMPLING_TASK_STACK   3072
+#define SHTC3_SAMPLING_TASK_PRIO    5
+// One-shot timer that fires when the conversion is done
+static esp_timer_handle_t g_conversion_timer = NULL;
+// The bus itself belongs to i2c_bus and may be shared with other sensors
+static i2c_bus_device_handle_t g_dev = NULL;
+// Every bus access goes through here: the config's transport, or g_dev
+static shtc3_i2c_run_t g_i2c_run = NULL;
+static void *g_i2c_ctx = NULL;
 static bool g_is_sensor_initialized = false;
 
-static esp_err_t shtc3_read(uint8_t *data, size_t size)
+static const shtc3_profile_desc_t *g_profile = &g_profiles[SHTC3_PROFILE_NORMAL];
+static uint32_t g_conversion_wait_us;
+// Bus time of the sample in progress, summed by shtc3_timed_i2c_run()
+static uint32_t g_sample_bus_us;
+// Adaptive sampling state, owned by the sampling task
+static uint32_t g_interval_ms;
+#define SHTC3_CENTI_INVALID     INT32_MIN
+static int32_t g_last_temperature = SHTC3_CENTI_INVALID;
+static int32_t g_last_humidity = SHTC3_CENTI_INVALID;
+static int32_t g_stable_temperature_centi;
+static int32_t g_stable_humidity_centi;
+
+static shtc3_sensor_stats_t g_stats;
+static portMUX_TYPE g_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static esp_err_t shtc3_default_i2c_run(void *ctx, const i2c_bus_op_t *ops, size_t count, uint32_t timeout_ms)
 {
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (SHTC3_SENSOR_ADDR << 1) | I2C_MASTER_WRITE, true /* enable_ack */);
-    // Read temperature first then humidity, with clock stretching enabled
-    // SHTC3 specific command: Wakeup (0x3517) then Read Temp/RH High Precision with Clock Stretching (0x7CA2)
-    // However, simpler approach is to send measurement command, wait, then read.
-    // Command: Measure T & RH, clock stretching, high precision (0x7CA2)
-    i2c_master_write_byte(cmd, 0x7C, true /* enable_ack */); // SHTC3_CMD_MEASURE_HPM
-    i2c_master_write_byte(cmd, 0xA2, true /* enable_ack */); // 
-    i2c_master_stop(cmd);
-    esp_err_t err = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, pdMS_TO_TICKS(1000));
-    i2c_cmd_link_delete(cmd);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "SHTC3: Failed to send measurement command: %s", esp_err_to_name(err));
-        return err;
-    }
-    cmd = NULL;
+    return i2c_bus_run((i2c_bus_device_handle_t)ctx, ops, count, timeout_ms);
+}
 
-    // Wait for measurement to complete. SHTC3 datasheet specifies max 12.1 ms for HPM.
-    vTaskDelay(pdMS_TO_TICKS(15)); 
+// The transport the protocol sequences see: g_i2c_run, timed per batch
+static esp_err_t shtc3_timed_i2c_run(void *ctx, const i2c_bus_op_t *ops, size_t count, uint32_t timeout_ms)
+{
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = g_i2c_run(g_i2c_ctx, ops, count, timeout_ms);
+    g_sample_bus_us += (uint32_t)(esp_timer_get_time() - start);
+    return err;
+}
+
+static const shtc3_bus_t g_bus = { shtc3_timed_i2c_run, NULL, I2C_MASTER_TIMEOUT_MS };
 
-    cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (SHTC3_SENSOR_ADDR << 1) | I2C_MASTER_READ, true /* enable_ack */);
-    // Read 6 bytes: Temp_MSB, Temp_LSB, Temp_CRC, RH_MSB, RH_LSB, RH_CRC
-    err = i2c_master_read(cmd, data, size, I2C_MASTER_LAST_NACK);
-     if (err != ESP_OK) { // Check error after read setup
-        ESP_LOGE(TAG, "SHTC3: Failed to setup read: %s", esp_err_to_name(err));
-        i2c_cmd_link_delete(cmd);
+// Start a measurement and return; the result is collected by shtc3_collect_measurement()
+static esp_err_t shtc3_start_measurement(void)
+{
+    esp_err_t err = shtc3_start(&g_bus, g_profile->cmd);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "SHTC3: Failed to start measurement: %s", esp_err_to_name(err));
         return err;
     }
-    i2c_master_stop(cmd);
-    err = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, pdMS_TO_TICKS(1000));
-    i2c_cmd_link_delete(cmd);
+    return esp_timer_start_once(g_conversion_timer, g_conversion_wait_us);
+}
 
+// Read 6 bytes: Temp_MSB, Temp_LSB, Temp_CRC, RH_MSB, RH_LSB, RH_CRC, then sleep again
+static esp_err_t shtc3_collect_measurement(uint8_t data[SHTC3_SAMPLE_SIZE])
+{
+    esp_err_t err = shtc3_collect(&g_bus, 0, data);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to receive data from SHTC3, err:%d (%s)", err, esp_err_to_name(err));
+        if (g_conversion_wait_us < g_profile->conversion_us) {
+            // Maybe still converting: stop trusting the measured time
+            ESP_LOGW(TAG, "Conversion wait back to the datasheet %" PRIu32 " us", g_profile->conversion_us);
+            g_conversion_wait_us = g_profile->conversion_us;
+            portENTER_CRITICAL(&g_stats_lock);
+            g_stats.conversion_wait_us = g_conversion_wait_us;
+            portEXIT_CRITICAL(&g_stats_lock);
+        }
         return err;
     }
+    esp_err_t sleep_err = shtc3_sleep(&g_bus);
+    if (sleep_err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to put SHTC3 to sleep: %s", esp_err_to_name(sleep_err));
+    }
     return ESP_OK;
 }
 
-// SHTC3 CRC checksum function
-static uint8_t shtc3_crc8(const uint8_t *data, int len)
+static void shtc3_report_failure(void)
 {
-    uint8_t crc = 0xFF;
-    for (int j = 0; j < len; j++) {
-        crc ^= data[j];
-        for (int i = 0; i < 8; i++) {
-            if ((crc & 0x80) != 0) {
-                crc = (uint8_t)((crc << 1) ^ 0x31);
-            } else {
-                crc <<= 1;
-            }
+    ESP_LOGE(TAG, "Failed to read from SHTC3 sensor");
+    // Optionally, report a default/error value or NaN
+    if (g_sensor_config->temperature.cb) {
+         g_sensor_config->temperature.cb(g_sensor_config->temperature.endpoint_id, NAN, g_sensor_config->user_data);
+    }
+    if (g_sensor_config->temperature.centi_cb) {
+        g_sensor_config->temperature.centi_cb(g_sensor_config->temperature.endpoint_id, 0, false,
+                                              g_sensor_config->user_data);
+    }
+    if (g_sensor_config->humidity.cb) {
+        g_sensor_config->humidity.cb(g_sensor_config->humidity.endpoint_id, NAN, g_sensor_config->user_data);
+    }
+    if (g_sensor_config->humidity.centi_cb) {
+        g_sensor_config->humidity.centi_cb(g_sensor_config->humidity.endpoint_id, 0, false, g_sensor_config->user_data);
+    }
+}
+
+// Reports the sample and returns the centi values that passed CRC
+// (SHTC3_CENTI_INVALID otherwise). Float math only runs for float callbacks.
+static void shtc3_sensor_process(const uint8_t *data_rd, int32_t *temperature_out, int32_t *humidity_out)
+{
+    *temperature_out = SHTC3_CENTI_INVALID;
+    *humidity_out = SHTC3_CENTI_INVALID;
+
+    shtc3_raw_sample_t raw;
+    unsigned ok = shtc3_decode(data_rd, &raw);
+
+    if (!(ok & SHTC3_DECODE_T_OK)) {
+        ESP_LOGE(TAG, "Temperature CRC check failed");
+    } else {
+        int32_t temperature = shtc3_temperature_centi(raw.temperature_raw);
+        int32_t magnitude = temperature < 0 ? -temperature : temperature;
+        ESP_LOGI(TAG, "Temperature: %s%" PRId32 ".%02" PRId32 " C", temperature < 0 ? "-" : "", magnitude / 100,
+                 magnitude % 100);
+        *temperature_out = temperature;
+        if (g_sensor_config->temperature.centi_cb) {
+            g_sensor_config->temperature.centi_cb(g_sensor_config->temperature.endpoint_id, temperature, true,
+                                                  g_sensor_config->user_data);
+        }
+        if (g_sensor_config->temperature.cb) {
+            g_sensor_config->temperature.cb(g_sensor_config->temperature.endpoint_id,
+                                            shtc3_temperature_c(raw.temperature_raw), g_sensor_config->user_data);
+        }
+    }
+
+    if (!(ok & SHTC3_DECODE_RH_OK)) {
+        ESP_LOGE(TAG, "Humidity CRC check failed");
+    } else {
+        int32_t humidity = shtc3_humidity_centi(raw.humidity_raw);
+        ESP_LOGI(TAG, "Humidity: %" PRId32 ".%02" PRId32 " %%", humidity / 100, humidity % 100);
+        *humidity_out = humidity;
+        if (g_sensor_config->humidity.centi_cb) {
+            g_sensor_config->humidity.centi_cb(g_sensor_config->humidity.endpoint_id, humidity, true,
+                                               g_sensor_config->user_data);
+        }
+        if (g_sensor_config->humidity.cb) {
+            g_sensor_config->humidity.cb(g_sensor_config->humidity.endpoint_id,
+                                         shtc3_humidity_pct(raw.humidity_raw), g_sensor_config->user_data);
         }
     }
-    return crc;
 }
 
+#if CONFIG_SHTC3_CONVERSION_BENCHMARK
+// Runs both conversion paths over every raw word, counts where the integer
+// path differs from the rounded float reference and logs cycles per sample
+static void shtc3_conversion_benchmark(void)
+{
+    volatile int32_t sink = 0;
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (uint32_t raw = 0; raw <= UINT16_MAX; raw++) {
+        sink = sink + (int32_t)lroundf(shtc3_temperature_c(raw) * 100.0f) +
+               (int32_t)lroundf(shtc3_humidity_pct(raw) * 100.0f);
+    }
+    uint32_t float_cycles = esp_cpu_get_cycle_count() - start;
+
+    start = esp_cpu_get_cycle_count();
+    for (uint32_t raw = 0; raw <= UINT16_MAX; raw++) {
+        sink = sink + shtc3_temperature_centi(raw) + shtc3_humidity_centi(raw);
+    }
+    uint32_t fixed_cycles = esp_cpu_get_cycle_count() - start;
+
+    uint32_t t_diff = 0;
+    uint32_t rh_diff = 0;
+    for (uint32_t raw = 0; raw <= UINT16_MAX; raw++) {
+        t_diff += lroundf(shtc3_temperature_c(raw) * 100.0f) != shtc3_temperature_centi(raw);
+        rh_diff += lroundf(shtc3_humidity_pct(raw) * 100.0f) != shtc3_humidity_centi(raw);
+    }
+
+    ESP_LOGI(TAG, "Conversion: float %" PRIu32 " cycles/sample, fixed %" PRIu32 " cycles/sample",
+             float_cycles / 65536, fixed_cycles / 65536);
+    ESP_LOGI(TAG, "Conversion: %" PRIu32 " T and %" PRIu32 " RH words differ from the float reference (float rounding)",
+             t_diff, rh_diff);
+}
+#endif
+
+static bool shtc3_within(int32_t last, int32_t value, int32_t delta)
+{
+    if (last == SHTC3_CENTI_INVALID || value == SHTC3_CENTI_INVALID) {
+        return false;
+    }
+    int32_t diff = value - last;
+    return (diff < 0 ? -diff : diff) <= delta;
+}
 
-static void shtc3_sensor_report_task(void *pvParameters)
+// Double the interval while readings stay within the stable deltas, up to
+// max_interval_ms; drop straight back to interval_ms on any change or error
+static void shtc3_adapt_interval(int32_t temperature, int32_t humidity)
 {
-    if (!g_sensor_config) {
-        ESP_LOGE(TAG, "Sensor not configured, cannot report.");
-        vTaskDelete(NULL);
+    if (g_sensor_config->max_interval_ms <= g_sensor_config->interval_ms) {
         return;
     }
 
-    uint8_t data_rd[6]; // Temp MSB, LSB, CRC, RH MSB, LSB, CRC
-    esp_err_t err = shtc3_read(data_rd, sizeof(data_rd));
+    bool stable = shtc3_within(g_last_temperature, temperature, g_stable_temperature_centi) &&
+                  shtc3_within(g_last_humidity, humidity, g_stable_humidity_centi);
+    // Compare against the last value that changed the interval, so a slow
+    // drift still adds up to a change
+    if (!stable) {
+        g_last_temperature = temperature;
+        g_last_humidity = humidity;
+    }
+
+    uint32_t next = g_sensor_config->interval_ms;
+    if (stable) {
+        next = g_interval_ms * 2;
+        if (next > g_sensor_config->max_interval_ms) {
+            next = g_sensor_config->max_interval_ms;
+        }
+    }
+    if (next != g_interval_ms) {
+        ESP_LOGD(TAG, "Sampling interval %" PRIu32 " -> %" PRIu32 " ms", g_interval_ms, next);
+        g_interval_ms = next;
+        xTimerChangePeriod(g_sensor_timer_handle, pdMS_TO_TICKS(next), 0);
+        portENTER_CRITICAL(&g_stats_lock);
+        g_stats.interval_ms = next;
+        portEXIT_CRITICAL(&g_stats_lock);
+    }
+}
 
-    if (err == ESP_OK) {
-        uint16_t temp_raw = (data_rd[0] << 8) | data_rd[1];
-        uint8_t temp_crc = data_rd[2];
-        uint16_t humidity_raw = (data_rd[3] << 8) | data_rd[4];
-        uint8_t humidity_crc = data_rd[5];
+static void shtc3_record_busy(uint32_t busy_us, uint32_t bus_us, bool failed)
+{
+    portENTER_CRITICAL(&g_stats_lock);
+    g_stats.bus_last_us = bus_us;
+    g_stats.bus_total_us += bus_us;
+    if (bus_us > g_stats.bus_max_us) {
+        g_stats.bus_max_us = bus_us;
+    }
+    if (failed) {
+        g_stats.errors++;
+    } else {
+        g_stats.samples++;
+    }
+    g_stats.busy_total_us += busy_us;
+    if (busy_us > g_stats.busy_max_us) {
+        g_stats.busy_max_us = busy_us;
+    }
+    portEXIT_CRITICAL(&g_stats_lock);
+}
 
-        if (shtc3_crc8(data_rd, 2) != temp_crc) {
-            ESP_LOGE(TAG, "Temperature CRC check failed");
-        } else {
-            float temperature = -45.0f + 175.0f * (temp_raw / 65535.0f);
-            ESP_LOGI(TAG, "Temperature: %.2f C", temperature);
-            if (g_sensor_config->temperature.cb) {
-                g_sensor_config->temperature.cb(g_sensor_config->temperature.endpoint_id, temperature, g_sensor_config->user_data);
+// Created once at init and never deleted, so sampling allocates nothing.
+// Each sample is two short bursts of work; the conversion in between is a
+// timer, not a blocking wait.
+static void shtc3_sensor_task(void *pvParameters)
+{
+    // Reused for every sample; only this task touches it
+    static uint8_t data_rd[SHTC3_SAMPLE_SIZE];
+    bool measuring = false;
+    uint32_t busy_us = 0;
+
+    while (true) {
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+
+        if ((bits & SHTC3_NOTIFY_READY) && measuring) {
+            int64_t start = esp_timer_get_time();
+            measuring = false;
+            int32_t temperature = SHTC3_CENTI_INVALID;
+            int32_t humidity = SHTC3_CENTI_INVALID;
+            esp_err_t err = shtc3_collect_measurement(data_rd);
+            if (err == ESP_OK) {
+                shtc3_sensor_process(data_rd, &temperature, &humidity);
+            } else {
+                shtc3_report_failure();
             }
+            busy_us += (uint32_t)(esp_timer_get_time() - start);
+            shtc3_record_busy(busy_us, g_sample_bus_us, err != ESP_OK);
+            shtc3_adapt_interval(temperature, humidity);
         }
 
-        if (shtc3_crc8(data_rd + 3, 2) != humidity_crc) {
-            ESP_LOGE(TAG, "Humidity CRC check failed");
-        } else {
-            float humidity = 100.0f * (humidity_raw / 65535.0f);
-            // Ensure humidity is within 0-100%
-            humidity = (humidity < 0.0f) ? 0.0f : humidity;
-            humidity = (humidity > 100.0f) ? 100.0f : humidity;
-            ESP_LOGI(TAG, "Humidity: %.2f %%", humidity);
-            if (g_sensor_config->humidity.cb) {
-                g_sensor_config->humidity.cb(g_sensor_config->humidity.endpoint_id, humidity, g_sensor_config->user_data);
+        // A tick that lands during a conversion is skipped, not queued
+        if ((bits & SHTC3_NOTIFY_SAMPLE) && !measuring) {
+            int64_t start = esp_timer_get_time();
+            g_sample_bus_us = 0;
+            esp_err_t err = shtc3_start_measurement();
+            busy_us = (uint32_t)(esp_timer_get_time() - start);
+            if (err == ESP_OK) {
+                measuring = true;
+            } else {
+                shtc3_report_failure();
+                shtc3_record_busy(busy_us, g_sample_bus_us, true);
+                shtc3_adapt_interval(SHTC3_CENTI_INVALID, SHTC3_CENTI_INVALID);
             }
         }
-    } else {
-        ESP_LOGE(TAG, "Failed to read from SHTC3 sensor");
-        // Optionally, report a default/error value or NaN
-        if (g_sensor_config->temperature.cb) {
-             g_sensor_config->temperature.cb(g_sensor_config->temperature.endpoint_id, NAN, g_sensor_config->user_data);
-        }
-        if (g_sensor_config->humidity.cb) {
-            g_sensor_config->humidity.cb(g_sensor_config->humidity.endpoint_id, NAN, g_sensor_config->user_data);
+    }
+}
+
+static void shtc3_sensor_timer_cb(TimerHandle_t xTimer)
+{
+    // Wake the sampling task; the timer callback itself must stay short
+    xTaskNotify(g_sensor_task_handle, SHTC3_NOTIFY_SAMPLE, eSetBits);
+}
+
+static void shtc3_conversion_timer_cb(void *arg)
+{
+    xTaskNotify(g_sensor_task_handle, SHTC3_NOTIFY_READY, eSetBits);
+}
+
+// Leaves the bus installed for the other devices on it
+static void shtc3_release_bus(void)
+{
+    if (g_dev) {
+        i2c_bus_remove_device(g_dev);
+        g_dev = NULL;
+    }
+}
+
+// Init only: time one conversion of `profile` by polling the result. Returns
+// microseconds from the end of the measure command to the first ACKed read,
+// within SHTC3_POLL_US plus one bus round trip, or 0 if it failed.
+static uint32_t shtc3_measure_conversion(const shtc3_profile_desc_t *profile)
+{
+    if (shtc3_start(&g_bus, profile->cmd) != ESP_OK) {
+        return 0;
+    }
+    int64_t start = esp_timer_get_time();
+    uint8_t data[SHTC3_SAMPLE_SIZE];
+    uint32_t elapsed_us = 0;
+    while (elapsed_us <= 2 * profile->conversion_us) {
+        esp_err_t err = shtc3_collect(&g_bus, SHTC3_POLL_US, data);
+        elapsed_us = (uint32_t)(esp_timer_get_time() - start);
+        if (err == ESP_OK) {
+            return elapsed_us;
         }
     }
-    vTaskDelete(NULL);
+    return 0;
 }
 
+// Measures every profile, then picks the wait for the active one
+static void shtc3_measure_profiles(void)
+{
+    // Each poll before the result is ready is a NACK the I2C driver logs as an error
+    esp_log_level_t master_level = esp_log_level_get("i2c.master");
+    if (!g_sensor_config->i2c_run) {
+        esp_log_level_set("i2c.master", ESP_LOG_NONE);
+    }
+    for (int i = 0; i < SHTC3_PROFILE_COUNT; i++) {
+        g_stats.conversion_us[i] = shtc3_measure_conversion(&g_profiles[i]);
+    }
+    if (!g_sensor_config->i2c_run) {
+        esp_log_level_set("i2c.master", master_level);
+    }
 
-static void shtc3_sensor_timer_cb(TimerHandle_t xTimer)
+    uint32_t measured = g_stats.conversion_us[g_sensor_config->profile];
+    g_conversion_wait_us = g_profile->conversion_us;
+    if (measured && SHTC3_WAIT_MARGIN(measured) < g_conversion_wait_us) {
+        g_conversion_wait_us = SHTC3_WAIT_MARGIN(measured);
+    }
+    g_stats.conversion_wait_us = g_conversion_wait_us;
+    for (int i = 0; i < SHTC3_PROFILE_COUNT; i++) {
+        ESP_LOGI(TAG, "Conversion %s: %" PRIu32 " us measured, %" PRIu32 " us datasheet max", g_profiles[i].name,
+                 g_stats.conversion_us[i], g_profiles[i].conversion_us);
+    }
+}
+
+void shtc3_sensor_get_stats(shtc3_sensor_stats_t *stats)
 {
-    // Create a task to handle sensor reading and reporting
-    // This avoids blocking the timer callback, which should be short
-    xTaskCreate(shtc3_sensor_report_task, "shtc3_report", 2048, NULL, 5, NULL);
+    portENTER_CRITICAL(&g_stats_lock);
+    *stats = g_stats;
+    portEXIT_CRITICAL(&g_stats_lock);
+}
+
+void shtc3_sensor_print(void)
+{
+    if (!g_is_sensor_initialized) {
+        printf("SHTC3 not running\n");
+        return;
+    }
+    shtc3_sensor_stats_t st;
+    shtc3_sensor_get_stats(&st);
+    uint32_t reads = st.samples + st.errors;
+
+    printf("SHTC3 %s profile, interval %" PRIu32 " ms, %" PRIu32 " samples, %" PRIu32 " errors\n", g_profile->name,
+           st.interval_ms, st.samples, st.errors);
+    printf("%-10s %10s %10s\n", "profile", "conv_us", "max_us");
+    for (int i = 0; i < SHTC3_PROFILE_COUNT; i++) {
+        printf("%-10s %10" PRIu32 " %10" PRIu32 "\n", g_profiles[i].name, st.conversion_us[i],
+               g_profiles[i].conversion_us);
+    }
+    printf("conversion wait %" PRIu32 " us\n", st.conversion_wait_us);
+    if (reads) {
+        printf("bus  last=%" PRIu32 "us avg=%" PRIu32 "us max=%" PRIu32 "us\n", st.bus_last_us,
+               (uint32_t)(st.bus_total_us / reads), st.bus_max_us);
+        printf("busy avg=%" PRIu32 "us max=%" PRIu32 "us\n", (uint32_t)(st.busy_total_us / reads), st.busy_max_us);
+    }
 }
 
 esp_err_t shtc3_sensor_init(shtc3_sensor_config_t *config_param)
@@ -183,116 +457,110 @@ esp_err_t shtc3_sensor_init(shtc3_sensor_config_t *config_param)
         ESP_LOGE(TAG, "SHTC3 config cannot be NULL");
         return ESP_ERR_INVALID_ARG;
     }
-    if (!config_param->temperature.cb && !config_param->humidity.cb) {
+    if (!config_param->temperature.cb && !config_param->temperature.centi_cb &&
+        !config_param->humidity.cb && !config_param->humidity.centi_cb) {
         ESP_LOGE(TAG, "At least one callback (temperature or humidity) must be provided");
         return ESP_ERR_INVALID_ARG;
     }
 
+    if ((unsigned)config_param->profile >= SHTC3_PROFILE_COUNT) {
+        ESP_LOGE(TAG, "Invalid SHTC3 profile %d", (int)config_param->profile);
+        return ESP_ERR_INVALID_ARG;
+    }
+
     g_sensor_config = config_param; // Store the provided config
+    g_profile = &g_profiles[config_param->profile];
+    g_conversion_wait_us = g_profile->conversion_us;
+    g_interval_ms = config_param->interval_ms;
+    g_stats.interval_ms = g_interval_ms;
+    // Once at init, so the sample path compares integers only
+    g_stable_temperature_centi = (int32_t)lroundf(config_param->stable_temperature_delta * 100.0f);
+    g_stable_humidity_centi = (int32_t)lroundf(config_param->stable_humidity_delta * 100.0f);
+
+    esp_err_t err = ESP_OK;
+    if (config_param->i2c_run) {
+        g_i2c_run = config_param->i2c_run;
+        g_i2c_ctx = config_param->i2c_ctx;
+    } else {
+        // Join the shared bus (installed by whichever driver gets here first)
+        err = i2c_bus_init(I2C_MASTER_NUM, I2C_MASTER_SDA_IO, I2C_MASTER_SCL_IO);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "I2C bus init failed: %s", esp_err_to_name(err));
+            g_sensor_config = NULL;
+            return err;
+        }
 
-    // Initialize I2C master
-    i2c_config_t conf = {
-        .mode = I2C_MODE_MASTER,
-        .sda_io_num = I2C_MASTER_SDA_IO,
-        .scl_io_num = I2C_MASTER_SCL_IO,
-        .sda_pullup_en = GPIO_PULLUP_ENABLE,
-        .scl_pullup_en = GPIO_PULLUP_ENABLE,
-        .master = {.clk_speed = I2C_MASTER_FREQ_HZ},
-        .clk_flags = 0, // Explicitly initialize clk_flags
-    };
-    esp_err_t err = i2c_param_config(I2C_MASTER_NUM, &conf);
-    if (err != ESP_OK) {
-        ESP_LOGE(TAG, "I2C master config failed: %s", esp_err_to_name(err));
-        g_sensor_config = NULL;
-        return err;
+        err = i2c_bus_add_device("shtc3", SHTC3_I2C_ADDR, I2C_MASTER_FREQ_HZ, I2C_BUS_PRIO_NORMAL, &g_dev);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "I2C add device failed: %s", esp_err_to_name(err));
+            g_sensor_config = NULL;
+            return err;
+        }
+        g_i2c_run = shtc3_default_i2c_run;
+        g_i2c_ctx = g_dev;
+    }
+
+    // Verify sensor presence and product code: wake up, then read ID
+    uint16_t product_code = 0;
+    err = shtc3_probe(&g_bus, &product_code);
+    if (err == ESP_ERR_INVALID_RESPONSE) {
+        ESP_LOGE(TAG, "SHTC3 product code mismatch, got: 0x%04X", product_code);
+    } else if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read SHTC3 product code: %s", esp_err_to_name(err));
     }
-    err = i2c_driver_install(I2C_MASTER_NUM, conf.mode, 0, 0, 0);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "I2C driver install failed: %s", esp_err_to_name(err));
+        shtc3_release_bus();
         g_sensor_config = NULL;
         return err;
     }
+    ESP_LOGI(TAG, "SHTC3 Product code: 0x%04X", product_code);
 
-    // Verify sensor presence and product code (simplified from shtc3_init)
-    // Wake up sensor
-    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (SHTC3_SENSOR_ADDR << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, SHTC3_WAKE_UP_COMMAND_MSB, true);
-    i2c_master_write_byte(cmd, SHTC3_WAKE_UP_COMMAND_LSB, true);
-    i2c_master_stop(cmd);
-    err = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, pdMS_TO_TICKS(1000));
-    i2c_cmd_link_delete(cmd);
+    // Leaves the sensor idle after the last read; the sleep command follows
+    shtc3_measure_profiles();
+
+    // Put sensor to sleep
+    err = shtc3_sleep(&g_bus);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to wake up SHTC3 during init: %s", esp_err_to_name(err));
-        i2c_driver_delete(I2C_MASTER_NUM);
-        g_sensor_config = NULL;
-        return err;
-    }
-    vTaskDelay(pdMS_TO_TICKS(1)); // Short delay after wakeup
-
-    // Read ID
-    uint8_t id_data[SHTC3_PRODUCT_CODE_SIZE_BYTES];
-    cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (SHTC3_SENSOR_ADDR << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, SHTC3_READ_ID_COMMAND_MSB, true);
-    i2c_master_write_byte(cmd, SHTC3_READ_ID_COMMAND_LSB, true);
-    i2c_master_stop(cmd);
-    err = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, pdMS_TO_TICKS(1000));
-    i2c_cmd_link_delete(cmd);
-     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to send read ID command SHTC3: %s", esp_err_to_name(err));
-        i2c_driver_delete(I2C_MASTER_NUM);
-        g_sensor_config = NULL;
-        return err;
+        ESP_LOGW(TAG, "Failed to put SHTC3 to sleep during init: %s", esp_err_to_name(err));
+        // Not a fatal error for init, sensor might just consume more power
     }
-    vTaskDelay(pdMS_TO_TICKS(1)); // Short delay
 
-    cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (SHTC3_SENSOR_ADDR << 1) | I2C_MASTER_READ, true);
-    i2c_master_read(cmd, id_data, SHTC3_PRODUCT_CODE_SIZE_BYTES, I2C_MASTER_LAST_NACK);
-    i2c_master_stop(cmd);
-    err = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, pdMS_TO_TICKS(1000));
-    i2c_cmd_link_delete(cmd);
+#if CONFIG_SHTC3_CONVERSION_BENCHMARK
+    shtc3_conversion_benchmark();
+#endif
+
+    esp_timer_create_args_t conversion_timer_args = {};
+    conversion_timer_args.callback = shtc3_conversion_timer_cb;
+    conversion_timer_args.name = "shtc3_conv";
+    err = esp_timer_create(&conversion_timer_args, &g_conversion_timer);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to read SHTC3 product code: %s", esp_err_to_name(err));
-        i2c_driver_delete(I2C_MASTER_NUM);
+        ESP_LOGE(TAG, "Failed to create SHTC3 conversion timer");
+        shtc3_release_bus();
         g_sensor_config = NULL;
         return err;
     }
 
-    uint16_t product_code = (id_data[0] << 8) | id_data[1];
-    if ((product_code & SHTC3_PRODUCT_CODE_MASK) != SHTC3_PRODUCT_CODE_SHTC3) {
-        ESP_LOGE(TAG, "SHTC3 product code mismatch. Expected: 0x%04X, Got: 0x%04X", SHTC3_PRODUCT_CODE_SHTC3, product_code);
-        i2c_driver_delete(I2C_MASTER_NUM);
+    // Create the sampling task before the timer that wakes it
+    if (xTaskCreate(shtc3_sensor_task, "shtc3_sample", SHTC3_SAMPLING_TASK_STACK, NULL,
+                    SHTC3_SAMPLING_TASK_PRIO, &g_sensor_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create SHTC3 sampling task");
+        esp_timer_delete(g_conversion_timer);
+        g_conversion_timer = NULL;
+        shtc3_release_bus();
         g_sensor_config = NULL;
-        return ESP_FAIL;
+        return ESP_ERR_NO_MEM;
     }
-    ESP_LOGI(TAG, "SHTC3 Product code: 0x%04X", product_code);
-
-    // Put sensor to sleep
-    cmd = i2c_cmd_link_create();
-    i2c_master_start(cmd);
-    i2c_master_write_byte(cmd, (SHTC3_SENSOR_ADDR << 1) | I2C_MASTER_WRITE, true);
-    i2c_master_write_byte(cmd, SHTC3_SLEEP_COMMAND_MSB, true);
-    i2c_master_write_byte(cmd, SHTC3_SLEEP_COMMAND_LSB, true);
-    i2c_master_stop(cmd);
-    err = i2c_master_cmd_begin(I2C_MASTER_NUM, cmd, pdMS_TO_TICKS(1000));
-    i2c_cmd_link_delete(cmd);
-    if (err != ESP_OK) {
-        ESP_LOGW(TAG, "Failed to put SHTC3 to sleep during init: %s", esp_err_to_name(err));
-        // Not a fatal error for init, sensor might just consume more power
-    }
-
 
     // Create timer for periodic reading
     g_sensor_timer_handle = xTimerCreate("shtc3_timer", pdMS_TO_TICKS(g_sensor_config->interval_ms),
                                        true /* auto-reload */, NULL /* timer ID */, shtc3_sensor_timer_cb);
     if (g_sensor_timer_handle == NULL) {
         ESP_LOGE(TAG, "Failed to create SHTC3 timer");
-        i2c_driver_delete(I2C_MASTER_NUM);
+        vTaskDelete(g_sensor_task_handle);
+        g_sensor_task_handle = NULL;
+        esp_timer_delete(g_conversion_timer);
+        g_conversion_timer = NULL;
+        shtc3_release_bus();
         g_sensor_config = NULL;
         return ESP_FAIL;
     }
@@ -301,12 +569,17 @@ esp_err_t shtc3_sensor_init(shtc3_sensor_config_t *config_param)
         ESP_LOGE(TAG, "Failed to start SHTC3 timer");
         xTimerDelete(g_sensor_timer_handle, 0);
         g_sensor_timer_handle = NULL;
-        i2c_driver_delete(I2C_MASTER_NUM);
+        vTaskDelete(g_sensor_task_handle);
+        g_sensor_task_handle = NULL;
+        esp_timer_delete(g_conversion_timer);
+        g_conversion_timer = NULL;
+        shtc3_release_bus();
         g_sensor_config = NULL;
         return ESP_FAIL;
     }
 
     g_is_sensor_initialized = true;
-    ESP_LOGI(TAG, "SHTC3 sensor initialized successfully, polling every %" PRIu32 " ms", g_sensor_config->interval_ms);
+    ESP_LOGI(TAG, "SHTC3 sensor initialized successfully, %s profile, polling every %" PRIu32 " ms",
+             g_profile->name, g_sensor_config->interval_ms);
     return ESP_OK;
 }
@@ -13,14 +13,46 @@
 
 #pragma once
 
+#include <stdint.h>
+#include <stddef.h>
 #include <esp_err.h>
 
+#include "i2c_bus.h"
+#include "shtc3_proto.h"
+
+/**
+ * Measurement profiles. Both use the T-first, no-clock-stretching commands and
+ * wake the sensor before and put it to sleep after every sample, so between
+ * samples it draws sleep current only.
+ *
+ * | profile   | command | conversion (datasheet max) | repeatability (T / RH) |
+ * |-----------|---------|----------------------------|------------------------|
+ * | normal    | 0x7866  | 12.1 ms                    | 0.07 C / 0.21 %RH      |
+ * | low-power | 0x609C  | 0.8 ms                     | 0.09 C / 0.44 %RH      |
+ *
+ * The actual conversion time of both profiles is measured at init by polling
+ * the sensor until it ACKs the read, and the bus time of every sample (both
+ * batches, including the 240 us wake-up wait) is timed as it runs. Both are in
+ * shtc3_sensor_stats_t.
+ */
+typedef enum {
+    SHTC3_PROFILE_NORMAL = 0,
+    SHTC3_PROFILE_LOW_POWER,
+    SHTC3_PROFILE_COUNT,
+} shtc3_power_profile_t;
+
 using shtc3_sensor_cb_t = void (*)(uint16_t endpoint_id, float value, void *user_data);
 
+// Matter-native integer reporting: 0.01 C or 0.01 %RH, computed without any
+// float math. `valid` is false on a read or CRC failure (report null).
+using shtc3_sensor_centi_cb_t = void (*)(uint16_t endpoint_id, int32_t centi, bool valid, void *user_data);
+
 typedef struct {
     struct {
         // This callback functon will be called periodically to report the temperature.
         shtc3_sensor_cb_t cb = NULL;
+        // Integer alternative to cb, in 0.01 C; either or both may be set
+        shtc3_sensor_centi_cb_t centi_cb = NULL;
         // endpoint_id associated with temperature sensor
         uint16_t endpoint_id;
     } temperature;
@@ -28,6 +60,8 @@ typedef struct {
     struct {
         // This callback functon will be called periodically to report the humidity.
         shtc3_sensor_cb_t cb = NULL;
+        // Integer alternative to cb, in 0.01 %RH; either or both may be set
+        shtc3_sensor_centi_cb_t centi_cb = NULL;
         // endpoint_id associated with humidity sensor
         uint16_t endpoint_id;
     } humidity;
@@ -35,10 +69,40 @@ typedef struct {
     // user data
     void *user_data = NULL;
 
+    // Optional transport (see shtc3_i2c_run_t) for every sensor access. Leave
+    // it NULL to use the shared bus on CONFIG_SHTC3_I2C_SDA_PIN/SCL_PIN; set it
+    // to drive the sensor through another bus or a scripted mock.
+    shtc3_i2c_run_t i2c_run = NULL;
+    void *i2c_ctx = NULL;
+
     // polling interval in milliseconds, defaults to 5000 ms
     uint32_t interval_ms = 5000;
+
+    // measurement precision / power trade-off
+    shtc3_power_profile_t profile = SHTC3_PROFILE_NORMAL;
+
+    // Adaptive sampling: while both readings stay within the stable deltas the
+    // interval doubles after each sample, up to max_interval_ms, and returns to
+    // interval_ms on the first change or error. Disabled when max_interval_ms
+    // is not above interval_ms.
+    uint32_t max_interval_ms = 0;
+    float stable_temperature_delta = 0.1f;     // degrees C
+    float stable_humidity_delta = 0.5f;        // %RH
 } shtc3_sensor_config_t;
 
+typedef struct {
+    uint32_t samples;           // successful reads
+    uint32_t errors;            // failed reads (I2C error, sensor absent)
+    uint32_t busy_max_us;       // worst CPU time of one sample
+    uint32_t interval_ms;       // current sampling interval (adaptive)
+    uint64_t busy_total_us;     // CPU time spent in the driver, excluding the conversion wait
+    uint32_t conversion_us[SHTC3_PROFILE_COUNT];    // measured at init, 0 if the measurement failed
+    uint32_t conversion_wait_us;    // wait between start and collect for the active profile
+    uint32_t bus_last_us;       // bus time of the last sample, including any queue wait
+    uint32_t bus_max_us;
+    uint64_t bus_total_us;
+} shtc3_sensor_stats_t;
+
 /**
  * @brief Initialize sensor driver. This function should be called only once
  *        When initializing, at least one callback should be provided, else it
@@ -50,6 +114,19 @@ typedef struct {
  * @return esp_err_t - ESP_OK on success,
  *                     ESP_ERR_INVALID_ARG if config is NULL
  *                     ESP_ERR_INVALID_STATE if driver is already initialized
+ *                     ESP_ERR_INVALID_RESPONSE if the device is not an SHTC3
  *                     appropriate error code otherwise
  */
 esp_err_t shtc3_sensor_init(shtc3_sensor_config_t *config);
+
+/**
+ * @brief Copy the sampling statistics. The CPU busy time covers starting the
+ *        measurement, reading the result, CRC checks, unit conversion and the
+ *        callbacks. The sensor's own conversion runs on a one-shot
+ *        timer and is not counted. The conversion wait is the measured
+ *        conversion time plus a 25% margin, capped at the datasheet maximum.
+ */
+void shtc3_sensor_get_stats(shtc3_sensor_stats_t *stats);
+
+/** Print the profile, sampling statistics and measured timings to the console. */
+void shtc3_sensor_print(void);
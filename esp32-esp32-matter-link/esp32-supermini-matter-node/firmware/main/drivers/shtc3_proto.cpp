@@ -0,0 +1,131 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include "shtc3_proto.h"
+
+// ID register per the datasheet: 0bxxxx_1xxx_xx00_0111. Only bit 11 and bits
+// 0-5 are defined, so (id & 0x083F) must equal 0x0807; parts read e.g. 0x0887.
+#define SHTC3_PRODUCT_CODE_MASK     0x083F  // Bits 6-10 and 12-15 are don't care
+#define SHTC3_PRODUCT_CODE_SHTC3    0x0807  // Expected value under the mask
+
+uint8_t shtc3_crc8(const uint8_t *data, int len)
+{
+    uint8_t crc = 0xFF;
+    for (int j = 0; j < len; j++) {
+        crc ^= data[j];
+        for (int i = 0; i < 8; i++) {
+            if ((crc & 0x80) != 0) {
+                crc = (uint8_t)((crc << 1) ^ 0x31);
+            } else {
+                crc <<= 1;
+            }
+        }
+    }
+    return crc;
+}
+
+bool shtc3_product_code_ok(const uint8_t id[SHTC3_ID_SIZE], uint16_t *product_code)
+{
+    uint16_t code = (uint16_t)((id[0] << 8) | id[1]);
+    if (product_code) {
+        *product_code = code;
+    }
+    return (code & SHTC3_PRODUCT_CODE_MASK) == SHTC3_PRODUCT_CODE_SHTC3;
+}
+
+unsigned shtc3_decode(const uint8_t data[SHTC3_SAMPLE_SIZE], shtc3_raw_sample_t *out)
+{
+    unsigned ok = 0;
+    out->temperature_raw = (uint16_t)((data[0] << 8) | data[1]);
+    out->humidity_raw = (uint16_t)((data[3] << 8) | data[4]);
+    if (shtc3_crc8(data, 2) == data[2]) {
+        ok |= SHTC3_DECODE_T_OK;
+    }
+    if (shtc3_crc8(data + 3, 2) == data[5]) {
+        ok |= SHTC3_DECODE_RH_OK;
+    }
+    return ok;
+}
+
+float shtc3_temperature_c(uint16_t raw)
+{
+    return -45.0f + 175.0f * (raw / 65535.0f);
+}
+
+// 17500 * 65535 and 10000 * 65535 both fit in 32 bits. 65535 is odd, so an
+// exact .5 never occurs and adding half the divisor rounds to nearest. The
+// float versions above misround 17 (T) and 18 (RH) of the 65536 words by 0.01, where
+// the single-precision product lands on the wrong side of .5.
+int16_t shtc3_temperature_centi(uint16_t raw)
+{
+    return (int16_t)(-4500 + (int32_t)(((uint32_t)raw * 17500u + 32767u) / 65535u));
+}
+
+uint16_t shtc3_humidity_centi(uint16_t raw)
+{
+    return (uint16_t)(((uint32_t)raw * 10000u + 32767u) / 65535u);
+}
+
+float shtc3_humidity_pct(uint16_t raw)
+{
+    float humidity = 100.0f * (raw / 65535.0f);
+    // Ensure humidity is within 0-100%
+    humidity = (humidity < 0.0f) ? 0.0f : humidity;
+    humidity = (humidity > 100.0f) ? 100.0f : humidity;
+    return humidity;
+}
+
+static const uint8_t s_wake_cmd[2] = { SHTC3_CMD_WAKE_UP >> 8, SHTC3_CMD_WAKE_UP & 0xFF };
+
+esp_err_t shtc3_probe(const shtc3_bus_t *bus, uint16_t *product_code)
+{
+    uint8_t id[SHTC3_ID_SIZE];
+    uint8_t id_cmd[2];
+    shtc3_cmd_bytes(SHTC3_CMD_READ_ID, id_cmd);
+    const i2c_bus_op_t ops[] = {
+        { I2C_BUS_OP_WRITE, s_wake_cmd, sizeof(s_wake_cmd), NULL, 0, 0 },
+        { I2C_BUS_OP_DELAY_US, NULL, 0, NULL, 0, SHTC3_WAKE_UP_US },
+        { I2C_BUS_OP_WRITE_READ, id_cmd, sizeof(id_cmd), id, sizeof(id), 0 },
+    };
+    esp_err_t err = bus->run(bus->ctx, ops, sizeof(ops) / sizeof(ops[0]), bus->timeout_ms);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return shtc3_product_code_ok(id, product_code) ? ESP_OK : ESP_ERR_INVALID_RESPONSE;
+}
+
+esp_err_t shtc3_start(const shtc3_bus_t *bus, uint16_t measure_cmd)
+{
+    // One batch, so no other device's traffic lands between wake-up and measure
+    uint8_t cmd[2];
+    shtc3_cmd_bytes(measure_cmd, cmd);
+    const i2c_bus_op_t ops[] = {
+        { I2C_BUS_OP_WRITE, s_wake_cmd, sizeof(s_wake_cmd), NULL, 0, 0 },
+        { I2C_BUS_OP_DELAY_US, NULL, 0, NULL, 0, SHTC3_WAKE_UP_US },
+        { I2C_BUS_OP_WRITE, cmd, sizeof(cmd), NULL, 0, 0 },
+    };
+    return bus->run(bus->ctx, ops, sizeof(ops) / sizeof(ops[0]), bus->timeout_ms);
+}
+
+esp_err_t shtc3_collect(const shtc3_bus_t *bus, uint32_t delay_us, uint8_t data[SHTC3_SAMPLE_SIZE])
+{
+    const i2c_bus_op_t ops[] = {
+        { I2C_BUS_OP_DELAY_US, NULL, 0, NULL, 0, delay_us },
+        { I2C_BUS_OP_READ, NULL, 0, data, SHTC3_SAMPLE_SIZE, 0 },
+    };
+    size_t skip = delay_us ? 0 : 1;
+    return bus->run(bus->ctx, ops + skip, sizeof(ops) / sizeof(ops[0]) - skip, bus->timeout_ms);
+}
+
+esp_err_t shtc3_sleep(const shtc3_bus_t *bus)
+{
+    uint8_t cmd[2];
+    shtc3_cmd_bytes(SHTC3_CMD_SLEEP, cmd);
+    const i2c_bus_op_t op = { I2C_BUS_OP_WRITE, cmd, sizeof(cmd), NULL, 0, 0 };
+    return bus->run(bus->ctx, &op, 1, bus->timeout_ms);
+}
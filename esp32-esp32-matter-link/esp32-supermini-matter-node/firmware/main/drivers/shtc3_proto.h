@@ -0,0 +1,112 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// SHTC3 command set, bus sequences and sample decoding.
+//
+// Command words, the product-code check, CRC validation and raw-to-engineering
+// conversion, plus the I2C sequences (probe, start, collect, sleep) expressed
+// as i2c_bus operation batches handed to a caller-supplied transport. No RTOS
+// or driver calls, so it builds and runs unchanged on a host compiler against
+// a mock bus; shtc3.cpp supplies the real bus, the timers and the task.
+//
+// Datasheet: https://sensirion.com/media/documents/643F9C8E/63A5A436/Datasheet_SHTC3.pdf
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <esp_err.h>
+
+#include "i2c_bus.h"
+
+#define SHTC3_I2C_ADDR                  0x70
+
+// 16-bit commands, sent MSB first
+#define SHTC3_CMD_WAKE_UP               0x3517
+#define SHTC3_CMD_SLEEP                 0xB098
+#define SHTC3_CMD_READ_ID               0xEFC8
+#define SHTC3_CMD_MEASURE_NORMAL        0x7866  // T first, no clock stretching
+#define SHTC3_CMD_MEASURE_LOW_POWER     0x609C  // T first, no clock stretching
+
+#define SHTC3_WAKE_UP_US                240     // Datasheet max wake-up time
+#define SHTC3_ID_SIZE                   2       // ID word; its CRC byte is not read
+#define SHTC3_SAMPLE_SIZE               6       // T MSB, LSB, CRC, RH MSB, LSB, CRC
+
+// shtc3_decode() result bits
+#define SHTC3_DECODE_T_OK               (1 << 0)
+#define SHTC3_DECODE_RH_OK              (1 << 1)
+
+typedef struct {
+    uint16_t temperature_raw;
+    uint16_t humidity_raw;
+} shtc3_raw_sample_t;
+
+/**
+ * I2C transport. Runs `count` operations back to back and stops at the first
+ * failure, with the semantics of i2c_bus_run().
+ */
+typedef esp_err_t (*shtc3_i2c_run_t)(void *ctx, const i2c_bus_op_t *ops, size_t count, uint32_t timeout_ms);
+
+typedef struct {
+    shtc3_i2c_run_t run;
+    void *ctx;
+    uint32_t timeout_ms;        // Per-operation I2C timeout
+} shtc3_bus_t;
+
+/** Split a command word into the two bytes sent on the bus. */
+static inline void shtc3_cmd_bytes(uint16_t cmd, uint8_t out[2])
+{
+    out[0] = (uint8_t)(cmd >> 8);
+    out[1] = (uint8_t)cmd;
+}
+
+/** CRC-8, poly 0x31, init 0xFF, over `len` bytes. */
+uint8_t shtc3_crc8(const uint8_t *data, int len);
+
+/** True if the ID word read with SHTC3_CMD_READ_ID identifies an SHTC3. */
+bool shtc3_product_code_ok(const uint8_t id[SHTC3_ID_SIZE], uint16_t *product_code);
+
+/** Check both CRCs of a 6-byte sample and extract the raw words.
+ *
+ * @return SHTC3_DECODE_T_OK / SHTC3_DECODE_RH_OK for each half that passed;
+ *         a raw word is only valid when its bit is set.
+ */
+unsigned shtc3_decode(const uint8_t data[SHTC3_SAMPLE_SIZE], shtc3_raw_sample_t *out);
+
+/** Degrees C from a raw temperature word. Float reference; soft-float on the C3. */
+float shtc3_temperature_c(uint16_t raw);
+
+/** %RH from a raw humidity word, clamped to 0..100. Float reference. */
+float shtc3_humidity_pct(uint16_t raw);
+
+/** Temperature in 0.01 C (Matter MeasuredValue units), -4500..13000.
+ *  Integer only: round(-4500 + 17500 * raw / 65535), exact for every raw word. */
+int16_t shtc3_temperature_centi(uint16_t raw);
+
+/** Humidity in 0.01 %RH (Matter MeasuredValue units), 0..10000.
+ *  Integer only: round(10000 * raw / 65535), exact for every raw word. */
+uint16_t shtc3_humidity_centi(uint16_t raw);
+
+/** Wake the sensor and read its ID word.
+ *
+ * @return ESP_OK for an SHTC3, ESP_ERR_INVALID_RESPONSE for another product
+ *         code, or the transport error. The code read is stored either way
+ *         once the read succeeded.
+ */
+esp_err_t shtc3_probe(const shtc3_bus_t *bus, uint16_t *product_code);
+
+/** Wake the sensor and send `measure_cmd` in one batch. The result can be
+ *  collected once the conversion is done; until then the sensor NACKs reads. */
+esp_err_t shtc3_start(const shtc3_bus_t *bus, uint16_t measure_cmd);
+
+/** Read the 6-byte result. A non-zero `delay_us` holds the bus that long
+ *  before the read, so a polling loop does not hammer the sensor. */
+esp_err_t shtc3_collect(const shtc3_bus_t *bus, uint32_t delay_us, uint8_t data[SHTC3_SAMPLE_SIZE]);
+
+/** Put the sensor to sleep until the next wake-up. */
+esp_err_t shtc3_sleep(const shtc3_bus_t *bus);
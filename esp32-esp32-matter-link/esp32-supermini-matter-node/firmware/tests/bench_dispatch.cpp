@@ -0,0 +1,146 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Per-event cost of the platform-free part of the dispatch path.
+//
+// Drives the work app_main does per event at a high rate: S3 frames are fed
+// byte by byte through the link parser, triggers (from the link or from an
+// attribute write) go through the trigger queue, the ACK/DONE replies are
+// encoded, and OnOff writes and exclusive mode reports go through the endpoint
+// model. UART, Matter and RTOS costs are not included; on the C3 they come on
+// top of these numbers (see the `latency` and `matter` console commands).
+
+#include <string.h>
+
+#include "test_util.h"
+#include "app_link_proto.h"
+#include "app_trigger_queue.h"
+#include "app_node_model.h"
+
+#define BENCH_EVENTS    1000000
+
+static volatile uint32_t g_sink;    // Keeps the optimizer from dropping the work
+
+static void report(const char *name, uint64_t elapsed_ns, uint32_t events)
+{
+    printf("%-28s %8u events  %7.1f ns/event\n", name, (unsigned)events, (double)elapsed_ns / events);
+}
+
+static void bench_link_rx(void)
+{
+    const uint8_t payload[] = { 0x12, 0x34 };
+    uint8_t frame_bytes[LINK_MAX_FRAME];
+    size_t size = link_encode(CMD_TRIGGER, payload, sizeof(payload), frame_bytes, sizeof(frame_bytes));
+
+    link_parser_t p;
+    link_frame_t frame;
+    link_parser_init(&p);
+    uint32_t frames = 0;
+    uint64_t start = test_now_ns();
+    for (uint32_t i = 0; i < BENCH_EVENTS; i++) {
+        for (size_t b = 0; b < size; b++) {
+            if (link_parser_feed(&p, frame_bytes[b], &frame) == LINK_PARSE_FRAME) {
+                frames++;
+                g_sink += frame.cmd;
+            }
+        }
+    }
+    report("link rx (5-byte payload)", test_now_ns() - start, BENCH_EVENTS);
+    CHECK_EQ(frames, BENCH_EVENTS);
+}
+
+static void bench_link_tx(void)
+{
+    uint8_t out[LINK_MAX_FRAME];
+    uint64_t start = test_now_ns();
+    for (uint32_t i = 0; i < BENCH_EVENTS; i++) {
+        uint8_t pending = (uint8_t)i;
+        g_sink += (uint32_t)link_encode(RSP_ACK, &pending, 1, out, sizeof(out));
+    }
+    report("link tx (ACK + pending)", test_now_ns() - start, BENCH_EVENTS);
+}
+
+// Triggers arrive faster than skits finish: one completion per `ratio` triggers
+static void bench_triggers(app_trigger_policy_t policy, uint32_t ratio)
+{
+    app_trigger_queue_t q;
+    app_trigger_queue_init(&q, policy, APP_TRIGGER_QUEUE_MAX);
+    app_trigger_t next;
+    uint64_t start = test_now_ns();
+    for (uint32_t i = 0; i < BENCH_EVENTS; i++) {
+        app_trigger_t t = { (i & 1) ? APP_TRIGGER_SRC_LINK : APP_TRIGGER_SRC_HOMEKIT, (uint16_t)i };
+        g_sink += app_trigger_queue_submit(&q, &t);
+        if (i % ratio == 0) {
+            g_sink += app_trigger_queue_complete(&q, NULL, &next);
+        }
+    }
+    char name[40];
+    snprintf(name, sizeof(name), "trigger %s 1:%u", app_trigger_policy_name(policy), (unsigned)ratio);
+    report(name, test_now_ns() - start, BENCH_EVENTS);
+    CHECK(q.stats.started + q.stats.queued + q.stats.coalesced + q.stats.dropped >= BENCH_EVENTS);
+}
+
+// Matter callback side: classify a write on one of the five plugs
+static void bench_onoff_writes(app_node_model_t *m)
+{
+    int mode = 0;
+    uint64_t start = test_now_ns();
+    for (uint32_t i = 0; i < BENCH_EVENTS; i++) {
+        g_sink += app_node_model_on_onoff_write(m, (uint16_t)(1 + i % 5), (i & 2) != 0, &mode);
+    }
+    report("onoff write (5 plugs)", test_now_ns() - start, BENCH_EVENTS);
+}
+
+static uint32_t g_reports;
+static int32_t g_next_seq;
+
+static int count_report(void *, uint16_t, bool)
+{
+    g_reports++;
+    return 0;
+}
+
+// Steps run back to back here; on the node the gaps add 80 ms per change
+static void next_step(void *, uint32_t, int32_t seq)
+{
+    g_next_seq = seq;
+}
+
+static void bench_mode_changes(app_node_model_t *m)
+{
+    uint64_t start = test_now_ns();
+    for (uint32_t i = 0; i < BENCH_EVENTS / 10; i++) {
+        app_node_model_report_start(m, (uint8_t)(i % APP_NODE_MODE_COUNT), "bench");
+        while (!app_node_model_report_step(m, g_next_seq)) {
+        }
+    }
+    report("mode change (full report)", test_now_ns() - start, BENCH_EVENTS / 10);
+    printf("%-28s %8.1f reports/change, model %u bytes\n", "mode report fan-out",
+           (double)g_reports / (BENCH_EVENTS / 10), (unsigned)sizeof(*m));
+    CHECK_EQ(g_reports, (BENCH_EVENTS / 10) * APP_NODE_MODE_COUNT);
+}
+
+int main(void)
+{
+    bench_link_rx();
+    bench_link_tx();
+    bench_triggers(APP_TRIGGER_POLICY_DROP, 4);
+    bench_triggers(APP_TRIGGER_POLICY_COALESCE, 4);
+    bench_triggers(APP_TRIGGER_POLICY_QUEUE, 4);
+
+    app_node_model_t m;
+    app_node_platform_t platform = { count_report, next_step, NULL };
+    app_node_model_init(&m, &platform);
+    m.trigger_endpoint_id = 1;
+    for (int i = 0; i < APP_NODE_MODE_COUNT; i++) {
+        m.mode_endpoint_ids[i] = (uint16_t)(2 + i);
+    }
+    bench_onoff_writes(&m);
+    bench_mode_changes(&m);
+    TEST_EXIT();
+}
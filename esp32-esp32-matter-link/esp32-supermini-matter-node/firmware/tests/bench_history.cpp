@@ -0,0 +1,140 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// A year of one-minute history samples through the flash log on a RAM NOR
+// flash the size of the "history" partition: bytes programmed and erased per
+// sample, wear per sector, how far back the ring reaches, and what the usual
+// queries cost in records decoded, sectors and flash bytes read. The stream is
+// shaped like the aggregated SHTC3 output: a daily temperature swing reported
+// in 0.05 C steps, humidity in 0.25 %RH steps, and occupied evenings.
+
+#include <math.h>
+
+#include "test_util.h"
+#include "ram_flash.h"
+#include "app_history_log.h"
+
+#define SECTORS         16          // 64 KB partition
+#define PERIOD_S        60
+#define DAYS            365
+#define SAMPLE_BYTES    9           // ts, temperature, humidity, occupancy unpacked
+#define ENDURANCE       100000      // Erase cycles, datasheet minimum for the C3's flash
+#define QUERY_ROUNDS    200
+
+static ram_flash_t g_flash;
+static volatile uint32_t g_sink;
+
+static uint32_t g_rng = 12345;
+
+static int32_t noise(int32_t span)
+{
+    g_rng = g_rng * 1103515245u + 12345u;
+    return (int32_t)((g_rng >> 16) % (uint32_t)(2 * span + 1)) - span;
+}
+
+static app_history_sample_t make_sample(uint32_t minute)
+{
+    double day = (minute % 1440) / 1440.0;
+    int32_t t = 2100 + (int32_t)lround(150 * sin(2 * M_PI * day)) + noise(5);
+    int32_t h = 4800 - (int32_t)lround(600 * sin(2 * M_PI * day)) + noise(20);
+    app_history_sample_t s;
+    s.ts = 1700000000 + minute * PERIOD_S;
+    s.temperature = (int16_t)(t / 5 * 5);
+    s.humidity = (uint16_t)(h / 25 * 25);
+    uint32_t hour = (minute / 60) % 24;
+    s.occupied = hour >= 18 && hour < 23 && noise(1) >= 0;
+    return s;
+}
+
+static bool count_visit(const app_history_sample_t *sample, void *ctx)
+{
+    (*(uint32_t *)ctx)++;
+    g_sink += sample->temperature;
+    return true;
+}
+
+typedef struct {
+    uint32_t first_ts;
+    uint32_t count;
+} span_t;
+
+static bool span_visit(const app_history_sample_t *sample, void *ctx)
+{
+    span_t *span = (span_t *)ctx;
+    if (span->count++ == 0) {
+        span->first_ts = sample->ts;
+    }
+    return true;
+}
+
+static void bench_query(app_history_log_t *log, const char *name, uint32_t from_ts, uint32_t to_ts)
+{
+    uint32_t visited = 0;
+    uint64_t read_before = g_flash.bytes_read;
+    uint64_t start = test_now_ns();
+    for (uint32_t i = 0; i < QUERY_ROUNDS; i++) {
+        visited = 0;
+        app_history_log_query(log, from_ts, to_ts, count_visit, &visited);
+    }
+    uint64_t elapsed = test_now_ns() - start;
+    printf("query %-10s %6u samples  %5u decoded  %2u sectors  %6u flash bytes  %8.1f us\n", name,
+           (unsigned)visited, (unsigned)log->stats.last_query_records, (unsigned)log->stats.last_query_sectors,
+           (unsigned)((g_flash.bytes_read - read_before) / QUERY_ROUNDS), (double)elapsed / QUERY_ROUNDS / 1000);
+    CHECK(visited > 0);
+}
+
+int main(void)
+{
+    ram_flash_init(&g_flash, SECTORS);
+    app_history_flash_t flash = ram_flash_bind(&g_flash);
+    app_history_log_t log;
+    CHECK_EQ(app_history_log_open(&log, &flash, PERIOD_S), 0);
+
+    const uint32_t n = DAYS * 1440;
+    uint64_t start = test_now_ns();
+    for (uint32_t i = 0; i < n; i++) {
+        app_history_sample_t s = make_sample(i);
+        CHECK_EQ(app_history_log_append(&log, &s), 0);
+    }
+    uint64_t elapsed = test_now_ns() - start;
+    CHECK_EQ(g_flash.violations, 0);
+
+    uint32_t max_erases = 0;
+    uint32_t min_erases = UINT32_MAX;
+    uint32_t erases = 0;
+    for (uint32_t i = 0; i < SECTORS; i++) {
+        erases += g_flash.erases[i];
+        max_erases = g_flash.erases[i] > max_erases ? g_flash.erases[i] : max_erases;
+        min_erases = g_flash.erases[i] < min_erases ? g_flash.erases[i] : min_erases;
+    }
+    double programmed = (double)g_flash.bytes_programmed / n;
+    double erased = (double)erases * APP_HISTORY_LOG_SECTOR_SIZE / n;
+    printf("%u samples over %u days, %.1f ns/append\n", (unsigned)n, DAYS, (double)elapsed / n);
+    printf("record bytes/sample %.2f (%u keyframes), programmed %.2f, erased %.2f\n",
+           (double)log.stats.bytes_written / n, (unsigned)log.stats.keyframes, programmed, erased);
+    printf("write amplification vs %d-byte raw samples: %.2f programmed, %.2f erased\n", SAMPLE_BYTES,
+           programmed / SAMPLE_BYTES, erased / SAMPLE_BYTES);
+    printf("one erase per %.0f minutes; erases/sector/year %u..%u, %u cycles last %.0f years\n",
+           (double)n / erases, (unsigned)min_erases, (unsigned)max_erases, ENDURANCE,
+           (double)ENDURANCE / max_erases * DAYS / 365);
+    // One sector erase per minute (or anything near it) would wear the flash out in months
+    CHECK(erases < n / 1000);
+    CHECK(max_erases - min_erases <= 1);
+
+    uint32_t newest = make_sample(n - 1).ts;
+    span_t span = {};
+    app_history_log_query(&log, 0, UINT32_MAX, span_visit, &span);
+    printf("ring holds %u samples, %.1f days\n", (unsigned)span.count, (newest - span.first_ts) / 86400.0);
+    CHECK(span.count > 7 * 1440);
+
+    bench_query(&log, "last hour", newest - 3600 + 1, UINT32_MAX);
+    bench_query(&log, "last day", newest - 86400 + 1, UINT32_MAX);
+    bench_query(&log, "a day ago", newest - 2 * 86400 + 1, newest - 86400);
+    bench_query(&log, "all", 0, UINT32_MAX);
+    TEST_EXIT();
+}
@@ -0,0 +1,113 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Per-sample cost of the SHTC3 validation and conversion code, and of a
+// whole start/collect/decode/sleep cycle against the mock bus (the mock's
+// own bookkeeping included). Host numbers: the C3 has no FPU, so the float
+// rows are far slower there (CONFIG_SHTC3_CONVERSION_BENCHMARK measures it).
+
+#include <math.h>
+
+#include "test_util.h"
+#include "mock_shtc3.h"
+#include "shtc3_proto.h"
+
+#define BENCH_ROUNDS    16          // x 65536 raw words
+#define BENCH_CYCLES    1000000
+
+static volatile uint32_t g_sink;    // Keeps the optimizer from dropping the work
+
+static void report(const char *name, uint64_t elapsed_ns, uint32_t samples)
+{
+    printf("%-30s %9u samples  %7.1f ns/sample\n", name, (unsigned)samples, (double)elapsed_ns / samples);
+}
+
+static void make_sample(uint16_t raw, uint8_t data[SHTC3_SAMPLE_SIZE])
+{
+    data[0] = (uint8_t)(raw >> 8);
+    data[1] = (uint8_t)raw;
+    data[2] = shtc3_crc8(data, 2);
+    data[3] = (uint8_t)~data[0];
+    data[4] = (uint8_t)~data[1];
+    data[5] = shtc3_crc8(data + 3, 2);
+}
+
+static void bench_decode(void)
+{
+    uint8_t data[SHTC3_SAMPLE_SIZE];
+    uint32_t valid = 0;
+    uint64_t start = test_now_ns();
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++) {
+        for (uint32_t raw = 0; raw <= UINT16_MAX; raw++) {
+            make_sample((uint16_t)raw, data);
+            shtc3_raw_sample_t s;
+            valid += shtc3_decode(data, &s) == (SHTC3_DECODE_T_OK | SHTC3_DECODE_RH_OK);
+            g_sink += s.temperature_raw;
+        }
+    }
+    report("crc (build + check 2 words)", test_now_ns() - start, BENCH_ROUNDS * 65536);
+    CHECK_EQ(valid, BENCH_ROUNDS * 65536);
+}
+
+static void bench_convert_centi(void)
+{
+    uint64_t start = test_now_ns();
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++) {
+        for (uint32_t raw = 0; raw <= UINT16_MAX; raw++) {
+            g_sink += (uint32_t)shtc3_temperature_centi((uint16_t)raw) + shtc3_humidity_centi((uint16_t)raw);
+        }
+    }
+    report("convert T+RH, integer centi", test_now_ns() - start, BENCH_ROUNDS * 65536);
+}
+
+static void bench_convert_float(void)
+{
+    uint64_t start = test_now_ns();
+    for (uint32_t round = 0; round < BENCH_ROUNDS; round++) {
+        for (uint32_t raw = 0; raw <= UINT16_MAX; raw++) {
+            g_sink += (uint32_t)lroundf(shtc3_temperature_c((uint16_t)raw) * 100.0f) +
+                      (uint32_t)lroundf(shtc3_humidity_pct((uint16_t)raw) * 100.0f);
+        }
+    }
+    report("convert T+RH, float reference", test_now_ns() - start, BENCH_ROUNDS * 65536);
+}
+
+static void bench_mock_cycle(void)
+{
+    mock_shtc3_t m;
+    mock_shtc3_init(&m);
+    shtc3_bus_t bus = { mock_shtc3_run, &m, 20 };
+    uint8_t data[SHTC3_SAMPLE_SIZE];
+    uint32_t ok = 0;
+    uint64_t start = test_now_ns();
+    for (uint32_t i = 0; i < BENCH_CYCLES; i++) {
+        m.temperature_raw = (uint16_t)i;
+        shtc3_start(&bus, SHTC3_CMD_MEASURE_LOW_POWER);
+        mock_shtc3_advance(&m, m.low_power_us);
+        if (shtc3_collect(&bus, 0, data) == ESP_OK) {
+            shtc3_raw_sample_t s;
+            if (shtc3_decode(data, &s) == (SHTC3_DECODE_T_OK | SHTC3_DECODE_RH_OK)) {
+                g_sink += (uint32_t)shtc3_temperature_centi(s.temperature_raw) + shtc3_humidity_centi(s.humidity_raw);
+                ok++;
+            }
+        }
+        shtc3_sleep(&bus);
+    }
+    report("mock cycle start..sleep", test_now_ns() - start, BENCH_CYCLES);
+    CHECK_EQ(ok, BENCH_CYCLES);
+    CHECK_EQ(m.nacks, 0);
+}
+
+int main(void)
+{
+    bench_decode();
+    bench_convert_centi();
+    bench_convert_float();
+    bench_mock_cycle();
+    TEST_EXIT();
+}
@@ -0,0 +1,36 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Stub: see README.md
+#pragma once
+
+#include "driver/gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    GLITCH_FILTER_CLK_SRC_DEFAULT = 0,
+} glitch_filter_clock_source_t;
+
+typedef struct gpio_glitch_filter_t *gpio_glitch_filter_handle_t;
+
+typedef struct {
+    glitch_filter_clock_source_t clk_src;
+    gpio_num_t gpio_num;
+} gpio_pin_glitch_filter_config_t;
+
+esp_err_t gpio_new_pin_glitch_filter(const gpio_pin_glitch_filter_config_t *config,
+                                     gpio_glitch_filter_handle_t *ret_filter);
+esp_err_t gpio_glitch_filter_enable(gpio_glitch_filter_handle_t filter);
+esp_err_t gpio_glitch_filter_disable(gpio_glitch_filter_handle_t filter);
+
+#ifdef __cplusplus
+}
+#endif
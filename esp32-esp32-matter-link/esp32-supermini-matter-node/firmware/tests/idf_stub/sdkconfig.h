@@ -0,0 +1,24 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Stub: see README.md. The options the compile check builds with; every
+// optional path is switched on so it gets type-checked.
+#pragma once
+
+#define CONFIG_IDF_TARGET_ESP32C3               1
+#define CONFIG_APP_SHTC3                        1
+#define CONFIG_SHTC3_I2C_SDA_PIN                0
+#define CONFIG_SHTC3_I2C_SCL_PIN                1
+#define CONFIG_SHTC3_CONVERSION_BENCHMARK       1
+#define CONFIG_APP_PIR_SENSOR                   1
+#define CONFIG_PIR_SENSOR_GPIO_NUM              3
+#define CONFIG_PIR_OCCUPIED_TO_UNOCCUPIED_DELAY_SECONDS 10
+#define CONFIG_APP_IDLE_SLEEP                   1
+#define CONFIG_APP_IDLE_SLEEP_AFTER_S           900
+#define CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ         160
+#define CONFIG_XTAL_FREQ                        40
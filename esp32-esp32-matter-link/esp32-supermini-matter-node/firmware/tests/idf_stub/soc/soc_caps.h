@@ -0,0 +1,12 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Stub: see README.md. ESP32-C3 capabilities the firmware tests for.
+#pragma once
+
+#define SOC_GPIO_SUPPORT_PIN_GLITCH_FILTER  1
@@ -0,0 +1,168 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "mock_shtc3.h"
+#include "shtc3_proto.h"
+
+void mock_shtc3_init(mock_shtc3_t *m)
+{
+    memset(m, 0, sizeof(*m));
+    m->present = true;
+    m->id_word = 0x0887;
+    m->temperature_raw = 0x6666;    // 25.00 C
+    m->humidity_raw = 0x8000;       // 50.00 %RH
+    m->normal_us = 10800;
+    m->low_power_us = 700;
+    m->corrupt_index = -1;
+    m->state = MOCK_SHTC3_ASLEEP;
+}
+
+void mock_shtc3_advance(mock_shtc3_t *m, uint32_t us)
+{
+    m->now_us += us;
+}
+
+static void log_cmd(mock_shtc3_t *m, uint16_t cmd)
+{
+    if (m->cmd_count < MOCK_SHTC3_LOG_MAX) {
+        m->cmds[m->cmd_count++] = cmd;
+    }
+}
+
+static esp_err_t nack(mock_shtc3_t *m)
+{
+    m->nacks++;
+    return ESP_FAIL;
+}
+
+static bool awake(const mock_shtc3_t *m)
+{
+    return m->state != MOCK_SHTC3_ASLEEP && m->now_us >= m->awake_at_us;
+}
+
+static esp_err_t write_cmd(mock_shtc3_t *m, const uint8_t *tx, size_t len)
+{
+    m->now_us += (1 + len) * MOCK_SHTC3_BYTE_US;
+    if (len != 2) {
+        return nack(m);
+    }
+    uint16_t cmd = (uint16_t)((tx[0] << 8) | tx[1]);
+    if (cmd == SHTC3_CMD_WAKE_UP) {
+        if (m->state == MOCK_SHTC3_ASLEEP) {
+            m->state = MOCK_SHTC3_IDLE;
+            m->awake_at_us = m->now_us + SHTC3_WAKE_UP_US;
+        }
+        log_cmd(m, cmd);
+        return ESP_OK;
+    }
+    if (!awake(m) || m->state == MOCK_SHTC3_CONVERTING) {
+        return nack(m);
+    }
+    switch (cmd) {
+    case SHTC3_CMD_SLEEP:
+        m->state = MOCK_SHTC3_ASLEEP;
+        break;
+    case SHTC3_CMD_READ_ID:
+        break;
+    case SHTC3_CMD_MEASURE_NORMAL:
+    case SHTC3_CMD_MEASURE_LOW_POWER:
+        m->state = MOCK_SHTC3_CONVERTING;
+        m->ready_at_us = m->now_us + (cmd == SHTC3_CMD_MEASURE_NORMAL ? m->normal_us : m->low_power_us);
+        break;
+    default:
+        return nack(m);
+    }
+    log_cmd(m, cmd);
+    return ESP_OK;
+}
+
+static esp_err_t read_bytes(mock_shtc3_t *m, uint8_t *rx, size_t len, bool id, uint32_t timeout_ms)
+{
+    if (m->stretch_us > timeout_ms * 1000) {
+        m->now_us += timeout_ms * 1000;
+        return ESP_ERR_TIMEOUT;
+    }
+    uint8_t data[SHTC3_SAMPLE_SIZE];
+    if (!id && (m->state != MOCK_SHTC3_CONVERTING || m->now_us < m->ready_at_us)) {
+        m->now_us += MOCK_SHTC3_BYTE_US;    // Address byte, then NACK
+        return nack(m);
+    }
+    m->now_us += (1 + len) * MOCK_SHTC3_BYTE_US + m->stretch_us;
+
+    if (id) {
+        data[0] = (uint8_t)(m->id_word >> 8);
+        data[1] = (uint8_t)m->id_word;
+        data[2] = shtc3_crc8(data, 2);
+    } else {
+        m->state = MOCK_SHTC3_IDLE;
+        data[0] = (uint8_t)(m->temperature_raw >> 8);
+        data[1] = (uint8_t)m->temperature_raw;
+        data[2] = shtc3_crc8(data, 2);
+        data[3] = (uint8_t)(m->humidity_raw >> 8);
+        data[4] = (uint8_t)m->humidity_raw;
+        data[5] = shtc3_crc8(data + 3, 2);
+        if (m->corrupt_index >= 0 && m->corrupt_index < SHTC3_SAMPLE_SIZE) {
+            data[m->corrupt_index] ^= 0x01;
+            m->corrupt_index = -1;
+        }
+    }
+    size_t max = id ? 3 : SHTC3_SAMPLE_SIZE;
+    if (len > max) {
+        return nack(m);
+    }
+    memcpy(rx, data, len);
+    return ESP_OK;
+}
+
+esp_err_t mock_shtc3_run(void *ctx, const i2c_bus_op_t *ops, size_t count, uint32_t timeout_ms)
+{
+    mock_shtc3_t *m = (mock_shtc3_t *)ctx;
+    m->batches++;
+    for (size_t i = 0; i < count; i++) {
+        const i2c_bus_op_t *op = &ops[i];
+        if (op->type == I2C_BUS_OP_DELAY_US) {
+            m->now_us += op->delay_us;
+            continue;
+        }
+        if (!m->present) {
+            m->now_us += MOCK_SHTC3_BYTE_US;    // Address byte, then NACK
+            return nack(m);
+        }
+        if (m->nack_ops > 0) {
+            m->nack_ops--;
+            m->now_us += MOCK_SHTC3_BYTE_US;
+            return nack(m);
+        }
+        esp_err_t err = ESP_OK;
+        switch (op->type) {
+        case I2C_BUS_OP_WRITE:
+            err = write_cmd(m, op->tx, op->tx_len);
+            break;
+        case I2C_BUS_OP_READ:
+            err = read_bytes(m, op->rx, op->rx_len, false, timeout_ms);
+            break;
+        case I2C_BUS_OP_WRITE_READ: {
+            err = write_cmd(m, op->tx, op->tx_len);
+            bool id = op->tx_len == 2 && ((op->tx[0] << 8) | op->tx[1]) == SHTC3_CMD_READ_ID;
+            if (err == ESP_OK) {
+                err = id ? read_bytes(m, op->rx, op->rx_len, true, timeout_ms) : nack(m);
+            }
+            break;
+        }
+        default:
+            err = ESP_ERR_INVALID_ARG;
+            break;
+        }
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
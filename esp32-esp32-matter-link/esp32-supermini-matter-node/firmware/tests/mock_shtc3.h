@@ -0,0 +1,68 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Scripted SHTC3 on a mock I2C bus, for the host tests and benchmarks.
+//
+// mock_shtc3_run() has the shape of shtc3_i2c_run_t and models the sensor's
+// state machine on virtual time: asleep until WAKE_UP, NACKs for 240 us
+// while it wakes, NACKs reads until a conversion is done, NACKs commands
+// while converting. Faults are injected per test: an absent sensor, NACKs of
+// the next N operations, a wrong ID word, a corrupted byte in the next
+// sample, and clock stretching on reads (ESP_ERR_TIMEOUT past the timeout).
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <esp_err.h>
+
+#include "i2c_bus.h"
+
+#define MOCK_SHTC3_LOG_MAX      32
+#define MOCK_SHTC3_BYTE_US      23      // One byte plus ACK at 400 kHz
+
+typedef enum {
+    MOCK_SHTC3_ASLEEP = 0,
+    MOCK_SHTC3_IDLE,
+    MOCK_SHTC3_CONVERTING,
+} mock_shtc3_state_t;
+
+typedef struct {
+    // Sensor
+    bool present;
+    uint16_t id_word;
+    uint16_t temperature_raw;
+    uint16_t humidity_raw;
+    uint32_t normal_us;             // Conversion times, typical
+    uint32_t low_power_us;
+
+    // Faults
+    int nack_ops;                   // NACK this many operations, then recover
+    int corrupt_index;              // Sample byte to flip in the next read, -1 for none
+    uint32_t stretch_us;            // Clock stretching on every read
+
+    // State
+    mock_shtc3_state_t state;
+    uint64_t now_us;
+    uint64_t awake_at_us;
+    uint64_t ready_at_us;
+
+    // What the bus saw
+    uint16_t cmds[MOCK_SHTC3_LOG_MAX];  // Accepted commands, in order
+    int cmd_count;
+    uint32_t batches;
+    uint32_t nacks;
+} mock_shtc3_t;
+
+/** An SHTC3 asleep at 25.00 C / 50.00 %RH, no faults. */
+void mock_shtc3_init(mock_shtc3_t *m);
+
+/** shtc3_i2c_run_t: `ctx` is the mock_shtc3_t. NACKs return ESP_FAIL. */
+esp_err_t mock_shtc3_run(void *ctx, const i2c_bus_op_t *ops, size_t count, uint32_t timeout_ms);
+
+/** Let virtual time pass without bus traffic. */
+void mock_shtc3_advance(mock_shtc3_t *m, uint32_t us);
@@ -0,0 +1,96 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+#include <string.h>
+
+#include "ram_flash.h"
+
+#define RAM_FLASH_ERR   1
+
+void ram_flash_init(ram_flash_t *f, uint32_t sectors)
+{
+    memset(f, 0, sizeof(*f));
+    memset(f->mem, 0xFF, sizeof(f->mem));
+    f->sector_count = sectors > RAM_FLASH_MAX_SECTORS ? RAM_FLASH_MAX_SECTORS : sectors;
+    f->cut_after = -1;
+}
+
+static bool in_range(const ram_flash_t *f, uint32_t offset, size_t len)
+{
+    return offset + len <= f->sector_count * APP_HISTORY_LOG_SECTOR_SIZE;
+}
+
+static int flash_read(void *ctx, uint32_t offset, void *dst, size_t len)
+{
+    ram_flash_t *f = (ram_flash_t *)ctx;
+    if (f->dead || !in_range(f, offset, len)) {
+        return RAM_FLASH_ERR;
+    }
+    memcpy(dst, &f->mem[offset], len);
+    f->bytes_read += len;
+    return 0;
+}
+
+static int flash_write(void *ctx, uint32_t offset, const void *src, size_t len)
+{
+    ram_flash_t *f = (ram_flash_t *)ctx;
+    if (f->dead || !in_range(f, offset, len)) {
+        return RAM_FLASH_ERR;
+    }
+    const uint8_t *bytes = (const uint8_t *)src;
+    for (size_t i = 0; i < len; i++) {
+        if ((f->mem[offset + i] & bytes[i]) != bytes[i]) {
+            f->violations++;
+            return RAM_FLASH_ERR;
+        }
+    }
+    size_t n = len;
+    if (f->cut_after >= 0 && (size_t)f->cut_after < len) {
+        n = (size_t)f->cut_after;
+        f->dead = true;
+    }
+    if (f->cut_after >= 0) {
+        f->cut_after -= (int32_t)n;
+    }
+    for (size_t i = 0; i < n; i++) {
+        f->mem[offset + i] &= bytes[i];
+    }
+    f->bytes_programmed += n;
+    return f->dead ? RAM_FLASH_ERR : 0;
+}
+
+static int flash_erase(void *ctx, uint32_t offset, size_t len)
+{
+    ram_flash_t *f = (ram_flash_t *)ctx;
+    if (f->dead || !in_range(f, offset, len) || offset % APP_HISTORY_LOG_SECTOR_SIZE ||
+        len % APP_HISTORY_LOG_SECTOR_SIZE) {
+        return RAM_FLASH_ERR;
+    }
+    memset(&f->mem[offset], 0xFF, len);
+    for (uint32_t s = offset / APP_HISTORY_LOG_SECTOR_SIZE; s < (offset + len) / APP_HISTORY_LOG_SECTOR_SIZE; s++) {
+        f->erases[s]++;
+    }
+    return 0;
+}
+
+app_history_flash_t ram_flash_bind(ram_flash_t *f)
+{
+    app_history_flash_t flash = { flash_read, flash_write, flash_erase, f, f->sector_count };
+    return flash;
+}
+
+void ram_flash_cut_after(ram_flash_t *f, int32_t bytes)
+{
+    f->cut_after = bytes;
+}
+
+void ram_flash_restore(ram_flash_t *f)
+{
+    f->dead = false;
+    f->cut_after = -1;
+}
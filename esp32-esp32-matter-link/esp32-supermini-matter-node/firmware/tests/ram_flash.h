@@ -0,0 +1,45 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// NOR flash in RAM for the history log tests: erase sets a sector to 0xFF,
+// a write may only clear bits (programming a 0 back to 1 is counted as a
+// violation and fails), and every read, write and erase is counted. A power
+// cut can be injected: the write in progress programs only its first bytes
+// and fails, and the flash refuses everything after it until restored.
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "app_history_log.h"
+
+#define RAM_FLASH_MAX_SECTORS   16
+
+typedef struct {
+    uint8_t mem[RAM_FLASH_MAX_SECTORS * APP_HISTORY_LOG_SECTOR_SIZE];
+    uint32_t sector_count;
+    uint32_t erases[RAM_FLASH_MAX_SECTORS];
+    uint64_t bytes_read;
+    uint64_t bytes_programmed;
+    uint32_t violations;        // Writes that needed a 0 -> 1 transition
+    int32_t cut_after;          // Bytes the next writes may still program, -1 = no cut pending
+    bool dead;                  // Power is off
+} ram_flash_t;
+
+/** A factory-fresh (erased) flash of `sectors` sectors. */
+void ram_flash_init(ram_flash_t *f, uint32_t sectors);
+
+/** Callbacks bound to `f`, for app_history_log_open(). */
+app_history_flash_t ram_flash_bind(ram_flash_t *f);
+
+/** Cut the power after `bytes` more programmed bytes. */
+void ram_flash_cut_after(ram_flash_t *f, int32_t bytes);
+
+/** Power back on; the contents are kept. */
+void ram_flash_restore(ram_flash_t *f);
@@ -0,0 +1,264 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Host stand-in for the S3 on the link, over a TCP socket (QEMU's UART0).
+//
+//   s3_link_driver [--host ADDR] [--port N] [--count N] [--boot-timeout S] [--csv FILE]
+//
+// Retries HELLO until the image answers, then times N PING -> ACK round trips
+// and N TRIGGER -> ACK -> DONE skits, one at a time, and prints p50/p90/p99/max
+// for each. --csv writes every sample (kind,index,us) for later comparison.
+// Frames are built and parsed with app_link_proto, the codec the firmware uses.
+// Exits non-zero if any exchange times out or is answered with ERR/BUSY.
+// tools/qemu_link_run.sh builds the image, boots it and runs this.
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "app_link_proto.h"
+
+#define ACK_TIMEOUT_MS      1000
+#define DONE_TIMEOUT_MS     3000    // 500 ms pulse plus the dispatcher
+#define HELLO_RETRY_MS      500
+
+typedef struct {
+    int fd;
+    link_parser_t parser;
+    uint32_t ignored;           // Frames that were not the awaited reply (status, C3 TRIGGER)
+    uint32_t crc_errors;
+} link_t;
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static int connect_retry(const char *host, int port, int timeout_s)
+{
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+        fprintf(stderr, "bad address %s\n", host);
+        return -1;
+    }
+    uint64_t deadline = now_us() + (uint64_t)timeout_s * 1000000;
+    while (now_us() < deadline) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        if (connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            return fd;
+        }
+        close(fd);
+        usleep(200 * 1000);     // QEMU still starting
+    }
+    fprintf(stderr, "no connection to %s:%d after %d s\n", host, port, timeout_s);
+    return -1;
+}
+
+static bool send_frame(link_t *link, uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    uint8_t out[LINK_MAX_FRAME];
+    size_t size = link_encode(cmd, payload, len, out, sizeof(out));
+    return size > 0 && write(link->fd, out, size) == (ssize_t)size;
+}
+
+// Wait for a frame with `cmd`, or any response (0x80 and up) if `cmd` is 0.
+// Others are counted and skipped. Returns false on timeout or a closed socket.
+static bool wait_frame(link_t *link, uint8_t cmd, int timeout_ms, uint8_t *got_cmd)
+{
+    uint64_t deadline = now_us() + (uint64_t)timeout_ms * 1000;
+    for (;;) {
+        uint64_t now = now_us();
+        if (now >= deadline) {
+            return false;
+        }
+        pollfd pfd = { link->fd, POLLIN, 0 };
+        int ready = poll(&pfd, 1, (int)((deadline - now + 999) / 1000));
+        if (ready < 0 && errno != EINTR) {
+            return false;
+        }
+        if (ready <= 0) {
+            continue;
+        }
+        // One byte at a time: never consume bytes past the awaited frame
+        uint8_t byte;
+        if (read(link->fd, &byte, 1) != 1) {
+            return false;
+        }
+        link_frame_t frame;
+        switch (link_parser_feed(&link->parser, byte, &frame)) {
+        case LINK_PARSE_FRAME:
+            if (cmd ? frame.cmd == cmd : frame.cmd >= RSP_ACK) {
+                *got_cmd = frame.cmd;
+                return true;
+            }
+            link->ignored++;
+            break;
+        case LINK_PARSE_CRC_ERROR:
+            link->crc_errors++;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// Send `cmd` and wait for its response; `rtt_us` is send -> last byte of the reply
+static bool exchange(link_t *link, uint8_t cmd, const uint8_t *payload, uint8_t len, uint64_t *rtt_us)
+{
+    uint64_t start = now_us();
+    uint8_t rsp;
+    if (!send_frame(link, cmd, payload, len) || !wait_frame(link, 0, ACK_TIMEOUT_MS, &rsp)) {
+        fprintf(stderr, "cmd 0x%02X: no response\n", cmd);
+        return false;
+    }
+    *rtt_us = now_us() - start;
+    if (rsp != RSP_ACK) {
+        fprintf(stderr, "cmd 0x%02X: response 0x%02X\n", cmd, rsp);
+        return false;
+    }
+    return true;
+}
+
+static void summary(const char *name, std::vector<uint64_t> v)
+{
+    if (v.empty()) {
+        printf("%-16s no samples\n", name);
+        return;
+    }
+    std::sort(v.begin(), v.end());
+    auto pct = [&](size_t p) { return v[std::min(v.size() - 1, (v.size() * p + 99) / 100 - 1)]; };
+    printf("%-16s n=%-4zu p50=%-8llu p90=%-8llu p99=%-8llu max=%llu us\n", name, v.size(),
+           (unsigned long long)pct(50), (unsigned long long)pct(90), (unsigned long long)pct(99),
+           (unsigned long long)v.back());
+}
+
+static void csv_write(FILE *csv, const char *kind, const std::vector<uint64_t> &v)
+{
+    for (size_t i = 0; i < v.size(); i++) {
+        fprintf(csv, "%s,%zu,%llu\n", kind, i, (unsigned long long)v[i]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *host = "127.0.0.1";
+    int port = 5555;
+    int count = 50;
+    int boot_timeout_s = 60;
+    const char *csv_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--host") && i + 1 < argc) {
+            host = argv[++i];
+        } else if (!strcmp(argv[i], "--port") && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--count") && i + 1 < argc) {
+            count = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--boot-timeout") && i + 1 < argc) {
+            boot_timeout_s = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--csv") && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--host ADDR] [--port N] [--count N] [--boot-timeout S] [--csv FILE]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    link_t link = {};
+    link_parser_init(&link.parser);
+    uint64_t connect_us = now_us();
+    link.fd = connect_retry(host, port, boot_timeout_s);
+    if (link.fd < 0) {
+        return 1;
+    }
+
+    // The image may still be booting: HELLO until it answers
+    uint64_t deadline = connect_us + (uint64_t)boot_timeout_s * 1000000;
+    uint8_t rsp = 0;
+    bool hello = false;
+    while (!hello && now_us() < deadline) {
+        hello = send_frame(&link, CMD_HELLO, NULL, 0) && wait_frame(&link, 0, HELLO_RETRY_MS, &rsp) &&
+                rsp == RSP_ACK;
+    }
+    if (!hello) {
+        fprintf(stderr, "no HELLO ACK within %d s\n", boot_timeout_s);
+        return 1;
+    }
+    printf("HELLO acknowledged %llu ms after connect\n", (unsigned long long)((now_us() - connect_us) / 1000));
+    // ACKs of HELLOs sent while the UART FIFO held them still trickle in
+    while (wait_frame(&link, 0, HELLO_RETRY_MS, &rsp)) {
+    }
+
+    int failures = 0;
+    std::vector<uint64_t> ping;
+    std::vector<uint64_t> trigger_ack;
+    std::vector<uint64_t> trigger_done;
+    for (int i = 0; i < count; i++) {
+        uint64_t rtt;
+        if (exchange(&link, CMD_PING, NULL, 0, &rtt)) {
+            ping.push_back(rtt);
+        } else {
+            failures++;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        uint64_t start = now_us();
+        uint64_t rtt;
+        if (!exchange(&link, CMD_TRIGGER, NULL, 0, &rtt)) {
+            failures++;
+            continue;
+        }
+        trigger_ack.push_back(rtt);
+        if (!wait_frame(&link, RSP_DONE, DONE_TIMEOUT_MS, &rsp)) {
+            fprintf(stderr, "trigger %d: no DONE\n", i);
+            failures++;
+            continue;
+        }
+        trigger_done.push_back(now_us() - start);
+    }
+
+    summary("ping -> ack", ping);
+    summary("trigger -> ack", trigger_ack);
+    summary("trigger -> done", trigger_done);
+    printf("ignored frames %u, CRC errors %u, failures %d\n", link.ignored, link.crc_errors, failures);
+
+    if (csv_path) {
+        FILE *csv = fopen(csv_path, "w");
+        if (!csv) {
+            fprintf(stderr, "cannot write %s\n", csv_path);
+            return 1;
+        }
+        fprintf(csv, "kind,index,us\n");
+        csv_write(csv, "ping_ack", ping);
+        csv_write(csv, "trigger_ack", trigger_ack);
+        csv_write(csv, "trigger_done", trigger_done);
+        fclose(csv);
+    }
+    close(link.fd);
+    return failures || link.crc_errors ? 1 : 0;
+}
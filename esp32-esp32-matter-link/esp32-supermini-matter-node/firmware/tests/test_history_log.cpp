@@ -0,0 +1,236 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Sensor history log on a RAM NOR flash (ram_flash): append and query, reopen
+// after a reboot, the ring wrapping over every sector, and a power cut at
+// every byte of an append and of a sector change. Flash rules are enforced:
+// no byte is ever programmed without an erase in between.
+
+#include "test_util.h"
+#include "ram_flash.h"
+#include "app_history_log.h"
+
+#define SECTORS     4
+#define PERIOD_S    60
+#define MAX_SEEN    16384
+
+typedef struct {
+    uint32_t count;
+    app_history_sample_t samples[MAX_SEEN];
+} seen_t;
+
+static ram_flash_t g_flash;
+static seen_t g_seen;
+
+// Slowly drifting readings with an occupied hour now and then
+static app_history_sample_t make_sample(uint32_t i)
+{
+    app_history_sample_t s;
+    s.ts = 1700000000 + i * PERIOD_S;
+    s.temperature = (int16_t)(2100 + (int32_t)(i % 97) - 48);
+    s.humidity = (uint16_t)(4500 + (i * 7) % 200);
+    s.occupied = (i / 60) % 5 == 0;
+    return s;
+}
+
+static bool same(const app_history_sample_t *a, const app_history_sample_t *b)
+{
+    return a->ts == b->ts && a->temperature == b->temperature && a->humidity == b->humidity &&
+           a->occupied == b->occupied;
+}
+
+static bool collect(const app_history_sample_t *sample, void *ctx)
+{
+    seen_t *seen = (seen_t *)ctx;
+    if (seen->count < MAX_SEEN) {
+        seen->samples[seen->count] = *sample;
+    }
+    seen->count++;
+    return true;
+}
+
+static void query(app_history_log_t *log, uint32_t from, uint32_t to)
+{
+    g_seen.count = 0;
+    CHECK_EQ(app_history_log_query(log, from, to, collect, &g_seen), 0);
+}
+
+// The query returned exactly samples first..last, in order
+static bool seen_run(uint32_t first, uint32_t last)
+{
+    if (g_seen.count != last - first + 1) {
+        return false;
+    }
+    for (uint32_t i = 0; i < g_seen.count; i++) {
+        app_history_sample_t want = make_sample(first + i);
+        if (!same(&g_seen.samples[i], &want)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_append_query(void)
+{
+    ram_flash_init(&g_flash, SECTORS);
+    app_history_flash_t flash = ram_flash_bind(&g_flash);
+    app_history_log_t log;
+    CHECK_EQ(app_history_log_open(&log, &flash, PERIOD_S), 0);
+    CHECK_EQ(log.sector, 0);
+    CHECK_EQ(log.seq, 1);
+    CHECK_EQ(g_flash.erases[0], 1);
+
+    const uint32_t n = 2000;                    // Spans a few sectors
+    for (uint32_t i = 0; i < n; i++) {
+        app_history_sample_t s = make_sample(i);
+        CHECK_EQ(app_history_log_append(&log, &s), 0);
+    }
+    CHECK(log.seq > 1);
+    CHECK_EQ(log.stats.appends, n);
+
+    query(&log, 0, UINT32_MAX);
+    CHECK(seen_run(0, n - 1));
+    query(&log, make_sample(500).ts, make_sample(1499).ts);
+    CHECK(seen_run(500, 1499));
+    query(&log, make_sample(n - 60).ts, UINT32_MAX);
+    CHECK(seen_run(n - 60, n - 1));
+    CHECK_EQ(log.stats.last_query_sectors, 1);  // The older sectors are skipped unread
+    query(&log, make_sample(n).ts, UINT32_MAX);
+    CHECK_EQ(g_seen.count, 0);
+    CHECK_EQ(g_flash.violations, 0);
+}
+
+static void test_reopen(void)
+{
+    ram_flash_init(&g_flash, SECTORS);
+    app_history_flash_t flash = ram_flash_bind(&g_flash);
+    app_history_log_t log;
+    CHECK_EQ(app_history_log_open(&log, &flash, PERIOD_S), 0);
+    for (uint32_t i = 0; i < 700; i++) {
+        app_history_sample_t s = make_sample(i);
+        app_history_log_append(&log, &s);
+    }
+    uint32_t sector = log.sector;
+    uint32_t seq = log.seq;
+    uint32_t offset = log.offset;
+
+    CHECK_EQ(app_history_log_open(&log, &flash, PERIOD_S), 0);
+    CHECK_EQ(log.sector, sector);
+    CHECK_EQ(log.seq, seq);
+    CHECK_EQ(log.offset, offset);
+    CHECK(!log.torn);
+    CHECK(log.enc.has_last);
+    app_history_sample_t last = make_sample(699);
+    CHECK(same(&log.enc.last, &last));
+
+    for (uint32_t i = 700; i < 1400; i++) {
+        app_history_sample_t s = make_sample(i);
+        CHECK_EQ(app_history_log_append(&log, &s), 0);
+    }
+    CHECK(log.stats.keyframes >= 1);            // Appending resumes with a keyframe
+    query(&log, 0, UINT32_MAX);
+    CHECK(seen_run(0, 1399));
+    CHECK_EQ(g_flash.violations, 0);
+}
+
+// Many times round the ring: the newest sectors stay readable, the wear is even
+static void test_wrap(void)
+{
+    ram_flash_init(&g_flash, SECTORS);
+    app_history_flash_t flash = ram_flash_bind(&g_flash);
+    app_history_log_t log;
+    CHECK_EQ(app_history_log_open(&log, &flash, PERIOD_S), 0);
+    const uint32_t n = 40000;
+    for (uint32_t i = 0; i < n; i++) {
+        app_history_sample_t s = make_sample(i);
+        CHECK_EQ(app_history_log_append(&log, &s), 0);
+    }
+    query(&log, 0, UINT32_MAX);
+    CHECK(g_seen.count > 0 && g_seen.count < MAX_SEEN);
+    CHECK(seen_run(n - g_seen.count, n - 1));
+    CHECK_EQ(log.stats.last_query_sectors, SECTORS);
+
+    uint32_t lo = UINT32_MAX;
+    uint32_t hi = 0;
+    for (uint32_t i = 0; i < SECTORS; i++) {
+        lo = g_flash.erases[i] < lo ? g_flash.erases[i] : lo;
+        hi = g_flash.erases[i] > hi ? g_flash.erases[i] : hi;
+    }
+    CHECK(hi - lo <= 1);
+    CHECK(lo > 1);
+
+    // And it still reopens where it left off
+    uint32_t sector = log.sector;
+    CHECK_EQ(app_history_log_open(&log, &flash, PERIOD_S), 0);
+    CHECK_EQ(log.sector, sector);
+    CHECK_EQ(g_flash.violations, 0);
+}
+
+// Cut the power at every byte of the appends around `start` samples, reboot,
+// and check that the log holds a gapless prefix and keeps appending cleanly
+static void check_power_cuts(uint32_t start, uint32_t span_bytes)
+{
+    for (int32_t cut = 0; cut <= (int32_t)span_bytes; cut++) {
+        ram_flash_init(&g_flash, SECTORS);
+        app_history_flash_t flash = ram_flash_bind(&g_flash);
+        app_history_log_t log;
+        CHECK_EQ(app_history_log_open(&log, &flash, PERIOD_S), 0);
+        uint32_t i = 0;
+        for (; i < start; i++) {
+            app_history_sample_t s = make_sample(i);
+            app_history_log_append(&log, &s);
+        }
+        ram_flash_cut_after(&g_flash, cut);
+        for (; i < start + 64; i++) {
+            app_history_sample_t s = make_sample(i);
+            if (app_history_log_append(&log, &s) != 0) {
+                break;
+            }
+        }
+        ram_flash_restore(&g_flash);
+
+        CHECK_EQ(app_history_log_open(&log, &flash, PERIOD_S), 0);
+        query(&log, 0, UINT32_MAX);
+        uint32_t kept = g_seen.count;
+        CHECK(kept >= start && kept <= i);
+        CHECK(seen_run(0, kept - 1));
+
+        for (uint32_t j = kept; j < kept + 20; j++) {
+            app_history_sample_t s = make_sample(j);
+            CHECK_EQ(app_history_log_append(&log, &s), 0);
+        }
+        query(&log, 0, UINT32_MAX);
+        CHECK(seen_run(0, kept + 19));
+        CHECK_EQ(g_flash.violations, 0);
+    }
+}
+
+static void test_power_cut(void)
+{
+    check_power_cuts(300, 64);                  // Mid-sector appends
+    // Find how many samples fill the first sector, then cut across the change
+    ram_flash_init(&g_flash, SECTORS);
+    app_history_flash_t flash = ram_flash_bind(&g_flash);
+    app_history_log_t log;
+    app_history_log_open(&log, &flash, PERIOD_S);
+    uint32_t fill = 0;
+    while (log.sector == 0) {
+        app_history_sample_t s = make_sample(fill++);
+        app_history_log_append(&log, &s);
+    }
+    check_power_cuts(fill - 4, 64);
+}
+
+int main(void)
+{
+    test_append_query();
+    test_reopen();
+    test_wrap();
+    test_power_cut();
+    TEST_EXIT();
+}
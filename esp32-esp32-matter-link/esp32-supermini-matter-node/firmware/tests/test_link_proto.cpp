@@ -0,0 +1,105 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// S3 link codec: round trips, resynchronisation and the error results.
+
+#include <string.h>
+
+#include "test_util.h"
+#include "app_link_proto.h"
+
+static link_parse_result_t feed_all(link_parser_t *p, const uint8_t *data, size_t len, link_frame_t *frame)
+{
+    link_parse_result_t last = LINK_PARSE_NONE;
+    for (size_t i = 0; i < len; i++) {
+        link_parse_result_t r = link_parser_feed(p, data[i], frame);
+        if (r != LINK_PARSE_NONE) {
+            last = r;
+        }
+    }
+    return last;
+}
+
+static void test_round_trip(void)
+{
+    uint8_t payload[LINK_MAX_LEN - 1];
+    for (size_t i = 0; i < sizeof(payload); i++) {
+        payload[i] = (uint8_t)(i * 7 + 1);
+    }
+    for (uint8_t len = 0; len <= sizeof(payload); len++) {
+        uint8_t buf[LINK_MAX_FRAME];
+        size_t size = link_encode(CMD_TRIGGER, payload, len, buf, sizeof(buf));
+        CHECK_EQ(size, LINK_FRAME_OVERHEAD + 1 + len);
+
+        link_parser_t p;
+        link_frame_t frame = {};
+        link_parser_init(&p);
+        CHECK_EQ(feed_all(&p, buf, size, &frame), LINK_PARSE_FRAME);
+        CHECK_EQ(frame.cmd, CMD_TRIGGER);
+        CHECK_EQ(frame.len, len);
+        CHECK(memcmp(frame.payload, payload, len) == 0);
+    }
+}
+
+static void test_encode_limits(void)
+{
+    uint8_t payload[LINK_MAX_LEN] = {};
+    uint8_t buf[LINK_MAX_FRAME + 8];
+    CHECK_EQ(link_encode(CMD_PING, payload, LINK_MAX_LEN, buf, sizeof(buf)), 0);    // LEN would be 61
+    CHECK_EQ(link_encode(CMD_PING, payload, 4, buf, 7), 0);                         // Needs 8 bytes
+    CHECK_EQ(link_encode(CMD_PING, NULL, 0, buf, 4), 4);
+}
+
+static void test_errors_and_resync(void)
+{
+    uint8_t buf[LINK_MAX_FRAME];
+    const uint8_t payload[] = { 1, 2, 3 };
+    size_t size = link_encode(CMD_SET_MODE, payload, sizeof(payload), buf, sizeof(buf));
+
+    link_parser_t p;
+    link_frame_t frame = {};
+    link_parser_init(&p);
+
+    // Line noise before the start byte is skipped
+    const uint8_t noise[] = { 0x00, 0xFF, 0x13 };
+    CHECK_EQ(feed_all(&p, noise, sizeof(noise), &frame), LINK_PARSE_NONE);
+    CHECK_EQ(feed_all(&p, buf, size, &frame), LINK_PARSE_FRAME);
+
+    // A corrupted payload byte is reported with both CRCs
+    buf[4] ^= 0x40;
+    CHECK_EQ(feed_all(&p, buf, size, &frame), LINK_PARSE_CRC_ERROR);
+    CHECK(frame.crc_expected != frame.crc_received);
+    buf[4] ^= 0x40;
+
+    // LEN 0 and LEN > LINK_MAX_LEN are rejected on the spot
+    CHECK_EQ(link_parser_feed(&p, LINK_FRAME_START, &frame), LINK_PARSE_NONE);
+    CHECK_EQ(link_parser_feed(&p, 0, &frame), LINK_PARSE_LENGTH_ERROR);
+    CHECK_EQ(link_parser_feed(&p, LINK_FRAME_START, &frame), LINK_PARSE_NONE);
+    CHECK_EQ(link_parser_feed(&p, LINK_MAX_LEN + 1, &frame), LINK_PARSE_LENGTH_ERROR);
+
+    // and the next good frame still parses
+    CHECK_EQ(feed_all(&p, buf, size, &frame), LINK_PARSE_FRAME);
+    CHECK_EQ(frame.cmd, CMD_SET_MODE);
+}
+
+static void test_crc_known_value(void)
+{
+    // CRC-8 poly 0x31 init 0 over "123456789" (as the S3 sketch computes it)
+    const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    CHECK_EQ(link_crc8(check, sizeof(check)), 0xA2);
+    CHECK_EQ(link_crc8(NULL, 0), 0);
+}
+
+int main(void)
+{
+    test_round_trip();
+    test_encode_limits();
+    test_errors_and_resync();
+    test_crc_known_value();
+    TEST_EXIT();
+}
@@ -0,0 +1,279 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Endpoint model against a fake platform: OnOff writes on the trigger and mode
+// plugs, the exclusive mode report step by step, restarts with steps of the
+// old sequence still queued, and a long run of random taps and restarts after
+// which every plug must show exactly the current mode.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "test_util.h"
+#include "app_node_model.h"
+
+#define TRIGGER_EP  1
+#define MODE_EP0    2       // Mode plugs are endpoints 2-5, as on the node
+#define MAX_QUEUED  64
+#define MAX_REPORTS 4096
+
+typedef struct {
+    int32_t seq;
+    uint32_t delay_ms;
+} step_t;
+
+// Stands in for app_matter_report() and the esp_timer one-shot + event queue
+typedef struct {
+    step_t queue[MAX_QUEUED];       // Steps posted to the dispatcher, oldest first
+    int queued;
+    bool timer_armed;
+    step_t timer;
+    uint16_t report_ep[MAX_REPORTS];
+    bool report_on[MAX_REPORTS];
+    int reports;
+    bool last_on[MODE_EP0 + APP_NODE_MODE_COUNT];
+    bool seen[MODE_EP0 + APP_NODE_MODE_COUNT];
+} fake_t;
+
+static int fake_report(void *ctx, uint16_t endpoint_id, bool on)
+{
+    fake_t *f = (fake_t *)ctx;
+    if (f->reports < MAX_REPORTS) {
+        f->report_ep[f->reports] = endpoint_id;
+        f->report_on[f->reports] = on;
+    }
+    f->reports++;
+    f->last_on[endpoint_id] = on;
+    f->seen[endpoint_id] = true;
+    return 0;
+}
+
+static void post(fake_t *f, step_t step)
+{
+    if (f->queued < MAX_QUEUED) {
+        f->queue[f->queued++] = step;
+    }
+}
+
+static void fake_schedule(void *ctx, uint32_t delay_ms, int32_t seq)
+{
+    fake_t *f = (fake_t *)ctx;
+    f->timer_armed = false;     // esp_timer_stop()
+    step_t step = { seq, delay_ms };
+    if (delay_ms == 0) {
+        post(f, step);
+    } else {
+        f->timer_armed = true;
+        f->timer = step;
+    }
+}
+
+static void setup(app_node_model_t *m, fake_t *f)
+{
+    memset(f, 0, sizeof(*f));
+    app_node_platform_t platform = { fake_report, fake_schedule, f };
+    app_node_model_init(m, &platform);
+    m->trigger_endpoint_id = TRIGGER_EP;
+    for (int i = 0; i < APP_NODE_MODE_COUNT; i++) {
+        m->mode_endpoint_ids[i] = (uint16_t)(MODE_EP0 + i);
+    }
+}
+
+// Handle the oldest queued step; if none, fire the timer. False if idle.
+static bool dispatch_one(app_node_model_t *m, fake_t *f, bool *done)
+{
+    step_t step;
+    if (f->queued > 0) {
+        step = f->queue[0];
+        memmove(&f->queue[0], &f->queue[1], (size_t)(f->queued - 1) * sizeof(step_t));
+        f->queued--;
+    } else if (f->timer_armed) {
+        f->timer_armed = false;
+        post(f, f->timer);
+        return true;
+    } else {
+        return false;
+    }
+    bool complete = app_node_model_report_step(m, step.seq);
+    if (done) {
+        *done = *done || complete;
+    }
+    return true;
+}
+
+static void drain(app_node_model_t *m, fake_t *f)
+{
+    while (dispatch_one(m, f, NULL)) {
+    }
+}
+
+static void check_exclusive(const app_node_model_t *m, const fake_t *f)
+{
+    for (int i = 0; i < APP_NODE_MODE_COUNT; i++) {
+        CHECK(f->seen[MODE_EP0 + i]);
+        CHECK_EQ(f->last_on[MODE_EP0 + i], i == m->current_mode);
+    }
+}
+
+static void test_writes(void)
+{
+    app_node_model_t m;
+    fake_t f;
+    setup(&m, &f);
+    int mode = -1;
+
+    CHECK_EQ(app_node_model_on_onoff_write(&m, TRIGGER_EP, true, &mode), APP_NODE_WRITE_TRIGGER_ON);
+    CHECK_EQ(app_node_model_on_onoff_write(&m, TRIGGER_EP, false, &mode), APP_NODE_WRITE_TRIGGER_OFF);
+    m.trigger_writeback = true;
+    CHECK_EQ(app_node_model_on_onoff_write(&m, TRIGGER_EP, false, &mode), APP_NODE_WRITE_NONE);
+    CHECK_EQ(app_node_model_on_onoff_write(&m, TRIGGER_EP, true, &mode), APP_NODE_WRITE_TRIGGER_ON);
+    m.trigger_writeback = false;
+
+    CHECK_EQ(app_node_model_on_onoff_write(&m, MODE_EP0 + 2, true, &mode), APP_NODE_WRITE_MODE_TAP);
+    CHECK_EQ(mode, 2);
+    CHECK_EQ(app_node_model_on_onoff_write(&m, MODE_EP0 + 3, false, &mode), APP_NODE_WRITE_NONE);
+    CHECK_EQ(app_node_model_on_onoff_write(&m, MODE_EP0 + APP_NODE_MODE_COUNT, true, &mode), APP_NODE_WRITE_NONE);
+    CHECK_EQ(app_node_model_on_onoff_write(&m, 0, true, NULL), APP_NODE_WRITE_NONE);
+
+    // While our own report runs, mode plug writes are its echoes
+    app_node_model_report_start(&m, 1, "test");
+    CHECK_EQ(app_node_model_on_onoff_write(&m, MODE_EP0 + 1, true, &mode), APP_NODE_WRITE_NONE);
+    CHECK_EQ(app_node_model_on_onoff_write(&m, TRIGGER_EP, true, &mode), APP_NODE_WRITE_TRIGGER_ON);
+    drain(&m, &f);
+    CHECK_EQ(app_node_model_on_onoff_write(&m, MODE_EP0 + 1, true, &mode), APP_NODE_WRITE_MODE_TAP);
+
+    CHECK_EQ(m.stats.writes, 9);
+    CHECK_EQ(m.stats.echoes, 2);
+}
+
+static void test_report_sequence(void)
+{
+    app_node_model_t m;
+    fake_t f;
+    setup(&m, &f);
+
+    app_node_model_report_start(&m, 2, "test");
+    CHECK(m.syncing);
+    CHECK(app_node_model_reporting(&m));
+    CHECK_EQ(f.reports, 0);     // Only scheduled
+    CHECK_EQ(f.queued, 1);
+    CHECK_EQ(f.queue[0].delay_ms, 0);
+
+    // OFF 0, OFF 1, OFF 3 (2 skipped), then ON 2 after the settle time
+    const uint32_t delays[] = { APP_NODE_REPORT_GAP_MS, APP_NODE_REPORT_GAP_MS,
+                                APP_NODE_REPORT_GAP_MS + APP_NODE_REPORT_SETTLE_MS };
+    const uint16_t eps[] = { MODE_EP0 + 0, MODE_EP0 + 1, MODE_EP0 + 3, MODE_EP0 + 2 };
+    for (int i = 0; i < 4; i++) {
+        bool done = false;
+        CHECK(dispatch_one(&m, &f, &done));
+        CHECK_EQ(f.reports, i + 1);
+        CHECK_EQ(f.report_ep[i], eps[i]);
+        CHECK_EQ(f.report_on[i], i == 3);
+        CHECK_EQ(done, i == 3);
+        if (i < 3) {
+            CHECK(f.timer_armed);
+            CHECK_EQ(f.timer.delay_ms, delays[i]);
+            CHECK(dispatch_one(&m, &f, NULL));  // Timer fires, step queued
+        }
+    }
+    CHECK(!f.timer_armed);
+    CHECK_EQ(f.queued, 0);
+    CHECK(!m.syncing);
+    CHECK(!app_node_model_reporting(&m));
+    check_exclusive(&m, &f);
+
+    // Mode 0 skips its own step at the start
+    app_node_model_report_start(&m, 0, "test");
+    f.reports = 0;
+    drain(&m, &f);
+    CHECK_EQ(f.reports, 4);
+    CHECK_EQ(f.report_ep[0], MODE_EP0 + 1);
+    CHECK_EQ(f.report_ep[3], MODE_EP0 + 0);
+    CHECK(f.report_on[3]);
+    CHECK_EQ(m.stats.sequences, 2);
+    CHECK_EQ(m.stats.reports, 8);
+    CHECK_EQ(m.stats.stale_steps, 0);
+}
+
+static void test_restart(void)
+{
+    app_node_model_t m;
+    fake_t f;
+    setup(&m, &f);
+
+    // One OFF out, the next step is waiting on the timer
+    app_node_model_report_start(&m, 1, "Mode");
+    CHECK(dispatch_one(&m, &f, NULL));
+    CHECK_EQ(f.reports, 1);
+    CHECK(f.timer_armed);
+
+    // Timer fires and its step sits in the queue when the sequence restarts
+    CHECK(dispatch_one(&m, &f, NULL));
+    CHECK_EQ(f.queued, 1);
+    app_node_model_report_start(&m, 3, "Cleanup");
+    CHECK_EQ(f.queued, 2);
+    CHECK_EQ(m.stats.restarts, 1);
+
+    // The stale step must not advance the new sequence
+    CHECK(dispatch_one(&m, &f, NULL));
+    CHECK_EQ(m.stats.stale_steps, 1);
+    CHECK_EQ(f.reports, 1);
+
+    drain(&m, &f);
+    CHECK_EQ(f.reports, 5);     // 1 from the first sequence, 4 from the second
+    for (int i = 1; i < f.reports; i++) {
+        CHECK(f.report_ep[i] != MODE_EP0 + 1 || !f.report_on[i]);  // Mode 1 never turned ON
+    }
+    CHECK_EQ(m.current_mode, 3);
+    check_exclusive(&m, &f);
+
+    // A step after completion is stale too
+    CHECK(!app_node_model_report_step(&m, m.seq));
+    CHECK_EQ(m.stats.stale_steps, 2);
+}
+
+// Random taps, restarts and steps, like a controller hammering the mode plugs
+static void test_hammer(void)
+{
+    app_node_model_t m;
+    fake_t f;
+    setup(&m, &f);
+    srand(57);
+
+    int completed = 0;
+    for (int i = 0; i < 20000; i++) {
+        int r = rand() % 10;
+        if (r < 2) {
+            int mode = -1;
+            uint16_t ep = (uint16_t)(MODE_EP0 + rand() % APP_NODE_MODE_COUNT);
+            if (app_node_model_on_onoff_write(&m, ep, true, &mode) == APP_NODE_WRITE_MODE_TAP) {
+                app_node_model_report_start(&m, (uint8_t)mode, "Mode");
+            }
+        } else if (r == 2) {
+            app_node_model_report_start(&m, m.current_mode, "Cleanup");
+        } else {
+            bool done = false;
+            dispatch_one(&m, &f, &done);
+            completed += done ? 1 : 0;
+        }
+    }
+    drain(&m, &f);
+    CHECK(completed > 0);
+    CHECK(!app_node_model_reporting(&m));
+    CHECK_EQ(m.stats.report_errors, 0);
+    check_exclusive(&m, &f);
+}
+
+int main(void)
+{
+    test_writes();
+    test_report_sequence();
+    test_restart();
+    test_hammer();
+    TEST_EXIT();
+}
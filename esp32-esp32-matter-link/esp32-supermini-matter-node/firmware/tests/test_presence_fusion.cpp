@@ -0,0 +1,208 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Presence fusion replayed over recorded-style input traces: PIR edges as
+// the PIR task reports them and S3 touch changes, with the 100 ms update
+// timer app_presence runs while the engine is not settled. Checks the
+// decisions and their times, the latency stats, that flicker never toggles
+// the state, and that a replay is deterministic. Uses the configuration
+// app_presence gives the engine.
+
+#include "test_util.h"
+#include "app_presence_fusion.h"
+
+#define UPDATE_MS       100         // APP_PRESENCE_UPDATE_MS
+#define MAX_CHANGES     32
+
+static const app_presence_config_t k_config = {
+    .pir_weight = 60,
+    .touch_weight = 100,
+    .pir_hold_ms = 20000,
+    .touch_hold_ms = 5000,
+    .enter_threshold = 50,
+    .exit_threshold = 30,
+    .engaged_hold_ms = 3000,
+    .leave_ms = 10000,
+};
+
+typedef struct {
+    int64_t at_ms;
+    app_presence_input_t input;
+} trace_event_t;
+
+typedef struct {
+    int count;
+    app_presence_state_t state[MAX_CHANGES];
+    int64_t at_ms[MAX_CHANGES];
+} changes_t;
+
+static void record(const app_presence_fusion_t *f, int64_t at_us, changes_t *out)
+{
+    if (out->count < MAX_CHANGES) {
+        out->state[out->count] = f->state;
+        out->at_ms[out->count] = at_us / 1000;
+    }
+    out->count++;
+}
+
+// Inputs at their own times, timer ticks on the 100 ms grid while unsettled
+static void replay(app_presence_fusion_t *f, const trace_event_t *trace, int n, int64_t end_ms, changes_t *out)
+{
+    app_presence_fusion_init(f, &k_config);
+    int next = 0;
+    for (int64_t tick = 0; tick <= end_ms; tick += UPDATE_MS) {
+        while (next < n && trace[next].at_ms <= tick) {
+            int64_t at_us = trace[next].at_ms * 1000;
+            if (app_presence_fusion_feed(f, trace[next].input, at_us)) {
+                record(f, at_us, out);
+            }
+            next++;
+        }
+        if (!app_presence_fusion_settled(f, tick * 1000) && app_presence_fusion_update(f, tick * 1000)) {
+            record(f, tick * 1000, out);
+        }
+    }
+}
+
+// Walks up, touches the prop for a second, lingers, walks away
+static const trace_event_t k_visit[] = {
+    { 1000, APP_PRESENCE_IN_PIR_ON },
+    { 3000, APP_PRESENCE_IN_TOUCH_ON },
+    { 4000, APP_PRESENCE_IN_TOUCH_OFF },
+    { 8000, APP_PRESENCE_IN_PIR_OFF },      // The driver's unoccupied delay ran out
+};
+
+static void test_visit(void)
+{
+    app_presence_fusion_t f;
+    changes_t c = {};
+    replay(&f, k_visit, 4, 40000, &c);
+
+    static const struct {
+        app_presence_state_t state;
+        int64_t at_ms;
+    } want[] = {
+        { APP_PRESENCE_PRESENT, 1000 },     // PIR alone: 60 >= 50
+        { APP_PRESENCE_ENGAGED, 3000 },
+        { APP_PRESENCE_PRESENT, 7000 },     // engaged_hold_ms after the release
+        { APP_PRESENCE_LEAVING, 18100 },    // PIR fade 60 -> 29 ten seconds into 20
+        { APP_PRESENCE_ABSENT, 28100 },     // leave_ms later
+    };
+    CHECK_EQ(c.count, 5);
+    for (int i = 0; i < 5 && i < c.count; i++) {
+        CHECK_EQ(c.state[i], want[i].state);
+        CHECK_EQ(c.at_ms[i], want[i].at_ms);
+    }
+    CHECK(app_presence_fusion_settled(&f, 40000 * 1000LL));
+
+    const app_presence_stats_t *st = &f.stats;
+    CHECK_EQ(st->inputs, 4);
+    CHECK_EQ(st->arrive.count, 1);
+    CHECK_EQ(st->arrive.last_us, 0);
+    CHECK_EQ(st->engage.count, 1);
+    CHECK_EQ(st->engage.last_us, 0);
+    CHECK_EQ(st->depart.count, 1);
+    CHECK_EQ(st->depart.last_us, 20100000);     // PIR_OFF -> ABSENT
+}
+
+// The same trace gives the same decisions every time
+static void test_deterministic(void)
+{
+    app_presence_fusion_t a;
+    app_presence_fusion_t b;
+    changes_t ca = {};
+    changes_t cb = {};
+    replay(&a, k_visit, 4, 40000, &ca);
+    replay(&b, k_visit, 4, 40000, &cb);
+    CHECK_EQ(ca.count, cb.count);
+    for (int i = 0; i < ca.count && i < MAX_CHANGES; i++) {
+        CHECK_EQ(ca.state[i], cb.state[i]);
+        CHECK_EQ(ca.at_ms[i], cb.at_ms[i]);
+    }
+}
+
+// A PIR that drops out for a second every few seconds, and a touch sensor
+// that chatters: one arrival, one engagement per touch burst, no LEAVING
+static void test_flicker(void)
+{
+    trace_event_t trace[64];
+    int n = 0;
+    for (int i = 0; i < 10; i++) {
+        trace[n++] = { 1000 + i * 3000LL, APP_PRESENCE_IN_PIR_ON };
+        trace[n++] = { 3000 + i * 3000LL, APP_PRESENCE_IN_PIR_OFF };
+    }
+    for (int i = 0; i < 6; i++) {           // 200 ms chatter around 10 s
+        trace[n++] = { 10000 + i * 200LL, (i & 1) ? APP_PRESENCE_IN_TOUCH_OFF : APP_PRESENCE_IN_TOUCH_ON };
+    }
+    // Keep the trace in time order
+    for (int i = 1; i < n; i++) {
+        for (int j = i; j > 0 && trace[j].at_ms < trace[j - 1].at_ms; j--) {
+            trace_event_t t = trace[j];
+            trace[j] = trace[j - 1];
+            trace[j - 1] = t;
+        }
+    }
+
+    app_presence_fusion_t f;
+    changes_t c = {};
+    replay(&f, trace, n, 32000, &c);
+    CHECK_EQ(f.stats.entered[APP_PRESENCE_PRESENT], 2);     // Arrival, and after the touch burst
+    CHECK_EQ(f.stats.entered[APP_PRESENCE_ENGAGED], 1);
+    CHECK_EQ(f.stats.entered[APP_PRESENCE_LEAVING], 0);
+    CHECK_EQ(f.stats.entered[APP_PRESENCE_ABSENT], 0);
+    CHECK_EQ(f.state, APP_PRESENCE_PRESENT);
+}
+
+// A touch report from the S3 carries its age, so it can be older than the
+// last PIR edge: it is clamped to the latest time and counted
+static void test_late_input(void)
+{
+    app_presence_fusion_t f;
+    app_presence_fusion_init(&f, &k_config);
+    CHECK(app_presence_fusion_feed(&f, APP_PRESENCE_IN_PIR_ON, 5000000));
+    CHECK(app_presence_fusion_feed(&f, APP_PRESENCE_IN_TOUCH_ON, 4900000));
+    CHECK_EQ(f.stats.late, 1);
+    CHECK_EQ(f.state, APP_PRESENCE_ENGAGED);
+    CHECK_EQ(f.state_since_us, 5000000);
+    CHECK(!app_presence_fusion_feed(&f, APP_PRESENCE_IN_TOUCH_ON, 5100000));
+    CHECK_EQ(f.stats.duplicates, 1);
+}
+
+// A single touch, no PIR: engaged at once, then out via LEAVING
+static void test_touch_only(void)
+{
+    static const trace_event_t trace[] = {
+        { 2000, APP_PRESENCE_IN_TOUCH_ON },
+        { 2500, APP_PRESENCE_IN_TOUCH_OFF },
+    };
+    app_presence_fusion_t f;
+    changes_t c = {};
+    replay(&f, trace, 2, 30000, &c);
+    CHECK_EQ(c.count, 4);
+    CHECK_EQ(c.state[0], APP_PRESENCE_ENGAGED);
+    CHECK_EQ(c.at_ms[0], 2000);
+    // Touch fades from 100 over 5 s: 40 at the 3 s hold, still above exit
+    CHECK_EQ(c.state[1], APP_PRESENCE_PRESENT);
+    CHECK_EQ(c.at_ms[1], 5500);
+    // Below 30 once 3.5 s are gone; absent leave_ms later
+    CHECK_EQ(c.state[2], APP_PRESENCE_LEAVING);
+    CHECK_EQ(c.at_ms[2], 6100);
+    CHECK_EQ(c.state[3], APP_PRESENCE_ABSENT);
+    CHECK_EQ(c.at_ms[3], 16100);
+    CHECK_EQ(f.stats.depart.last_us, 13600000);     // TOUCH_OFF -> ABSENT
+}
+
+int main(void)
+{
+    test_visit();
+    test_deterministic();
+    test_flicker();
+    test_late_input();
+    test_touch_only();
+    TEST_EXIT();
+}
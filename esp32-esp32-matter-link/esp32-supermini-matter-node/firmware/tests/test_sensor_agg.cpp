@@ -0,0 +1,237 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Sensor aggregation replayed over SHTC3-style sample streams (centi values,
+// 5 s period) with the faults the driver produces: a bus glitch read as an
+// out-of-range value, failed reads, bursts of them and a sensor that stops
+// answering. Uses the channel configuration app_main gives the SHTC3.
+
+#include <stdlib.h>
+
+#include "test_util.h"
+#include "app_sensor_agg.h"
+
+#define PERIOD_MS   5000
+#define MAX_REPORTS 64
+#define BAD         INT32_MIN       // A failed read in a stream; APP_SENSOR_AGG_LOST in reports_t
+
+typedef struct {
+    int count;
+    int32_t value[MAX_REPORTS];
+    uint32_t at_ms[MAX_REPORTS];
+} reports_t;
+
+static const app_sensor_agg_config_t k_temperature = {
+    .window = 4, .median = 3, .min_interval_ms = 0, .max_interval_ms = 60000, .report_delta = 5,
+    .lost_after = 6,
+};
+static const app_sensor_agg_config_t k_humidity = {
+    .window = 4, .median = 3, .min_interval_ms = 0, .max_interval_ms = 60000, .report_delta = 25,
+    .lost_after = 6,
+};
+
+// Feeds the stream one sample per period, starting at start_ms
+static void replay(app_sensor_agg_t *agg, const int32_t *stream, int n, uint32_t start_ms, uint32_t period_ms,
+                   reports_t *out)
+{
+    for (int i = 0; i < n; i++) {
+        uint32_t now = start_ms + (uint32_t)i * period_ms;
+        int32_t value = BAD;
+        if (app_sensor_agg_push(agg, stream[i], stream[i] != BAD, now, &value) != APP_SENSOR_AGG_HOLD &&
+            out->count < MAX_REPORTS) {
+            out->value[out->count] = value;
+            out->at_ms[out->count] = now;
+            out->count++;
+        }
+    }
+}
+
+// Room temperature with one 0xFFFF read (130 C) and one failed read
+static void test_temperature_glitch(void)
+{
+    static const int32_t stream[] = {
+        2231, 2233, 2230, 2232, 13000, 2234, BAD, 2233,
+        2235, 2241, 2248, 2255, 2261, 2266, 2270, 2271,
+    };
+    const int n = sizeof(stream) / sizeof(stream[0]);
+    app_sensor_agg_t agg;
+    app_sensor_agg_init(&agg, &k_temperature);
+    reports_t r = {};
+    replay(&agg, stream, n, 0, PERIOD_MS, &r);
+
+    CHECK(r.count > 0);
+    CHECK_EQ(r.at_ms[0], 0);                // The first sample is reported at once
+    CHECK_EQ(r.value[0], 2231);
+    for (int i = 0; i < r.count; i++) {
+        CHECK(r.value[i] > 2200 && r.value[i] < 2300);      // The glitch never reaches the output
+    }
+    for (int i = 1; i < r.count; i++) {
+        CHECK(abs(r.value[i] - r.value[i - 1]) >= k_temperature.report_delta);
+    }
+    // The rise at the end is followed
+    CHECK(r.value[r.count - 1] > 2255);
+
+    const app_sensor_agg_stats_t *st = app_sensor_agg_stats(&agg);
+    CHECK_EQ(st->invalid, 1);
+    CHECK_EQ(st->samples, n - 1);
+    CHECK_EQ(st->reported, r.count);
+    CHECK_EQ(st->reported + st->suppressed, st->samples);
+    CHECK(st->replaced >= 1);
+
+    app_sensor_agg_summary_t sum;
+    app_sensor_agg_summary(&agg, &sum);
+    CHECK_EQ(sum.count, 4);
+    // The window holds the median-of-3 of the last four samples
+    CHECK_EQ(sum.min, 2255);
+    CHECK_EQ(sum.max, 2270);
+    CHECK_EQ(sum.mean, 2263);               // 2263.0 exactly
+}
+
+// Bus down for three samples: nothing is reported, the last report stands,
+// and reporting resumes with the next good read
+static void test_humidity_outage(void)
+{
+    static const int32_t stream[] = {
+        4510, 4520, 4515, BAD, BAD, BAD, 4790, 4800, 4810, 4805,
+    };
+    const int n = sizeof(stream) / sizeof(stream[0]);
+    app_sensor_agg_t agg;
+    app_sensor_agg_init(&agg, &k_humidity);
+    reports_t r = {};
+    replay(&agg, stream, n, 0, PERIOD_MS, &r);
+
+    for (int i = 0; i < r.count; i++) {
+        CHECK(r.at_ms[i] < 3 * PERIOD_MS || r.at_ms[i] >= 6 * PERIOD_MS);
+    }
+    CHECK(r.count >= 2);
+    CHECK(r.value[r.count - 1] > 4600);     // Caught up with the new level
+    CHECK_EQ(app_sensor_agg_stats(&agg)->invalid, 3);
+}
+
+// Sensor unplugged: after lost_after failed reads the value is reported lost
+// once, and the first read after it comes back is reported at once, without
+// the readings from before the outage
+static void test_dead_sensor(void)
+{
+    int32_t stream[30];
+    for (int i = 0; i < 30; i++) {
+        stream[i] = i < 4 ? 2200 : (i < 24 ? BAD : 2500);
+    }
+    app_sensor_agg_t agg;
+    app_sensor_agg_init(&agg, &k_temperature);
+    reports_t r = {};
+    replay(&agg, stream, 30, 0, PERIOD_MS, &r);
+
+    CHECK_EQ(r.count, 3);
+    CHECK_EQ(r.value[0], 2200);
+    CHECK_EQ(r.value[1], BAD);
+    CHECK_EQ(r.at_ms[1], (4 + 6 - 1) * PERIOD_MS);      // The 6th failed read
+    CHECK_EQ(r.value[2], 2500);
+    CHECK_EQ(r.at_ms[2], 24 * PERIOD_MS);
+
+    const app_sensor_agg_stats_t *st = app_sensor_agg_stats(&agg);
+    CHECK_EQ(st->invalid, 20);
+    CHECK_EQ(st->lost, 1);
+
+    app_sensor_agg_summary_t sum;
+    app_sensor_agg_summary(&agg, &sum);
+    CHECK_EQ(sum.count, 4);
+    CHECK_EQ(sum.min, 2500);
+
+    // A shorter burst is only dropped
+    int32_t out;
+    for (uint32_t i = 30; i < 35; i++) {
+        CHECK_EQ(app_sensor_agg_push(&agg, 0, false, i * PERIOD_MS, &out), APP_SENSOR_AGG_HOLD);
+    }
+    CHECK_EQ(app_sensor_agg_push(&agg, 2500, true, 35 * PERIOD_MS, &out), APP_SENSOR_AGG_HOLD);
+    CHECK_EQ(app_sensor_agg_push(&agg, 0, false, 36 * PERIOD_MS, &out), APP_SENSOR_AGG_HOLD);
+    CHECK_EQ(st->lost, 1);
+}
+
+// Days of samples swinging between far-apart values must not move the mean
+// of a window that ends up holding one steady value, and a mean between two
+// units rounds half away from zero, below zero too
+static void test_mean(void)
+{
+    app_sensor_agg_config_t cfg = k_temperature;
+    cfg.median = 1;
+    app_sensor_agg_t agg;
+    app_sensor_agg_init(&agg, &cfg);
+    srand(65);
+    int32_t out;
+    uint32_t now = 0;
+    for (int i = 0; i < 200000; i++, now += PERIOD_MS) {
+        app_sensor_agg_push(&agg, rand() % 16000 - 4000, true, now, &out);
+    }
+    app_sensor_agg_summary_t sum;
+    static const int32_t tail[][4] = {
+        { 4567, 4567, 4567, 4567 },     // 4567
+        { 2230, 2231, 2231, 2231 },     // 2230.75 -> 2231
+        { 2230, 2230, 2231, 2231 },     // 2230.5 -> 2231
+        { -230, -230, -231, -231 },     // -230.5 -> -231
+        { -230, -230, -230, -231 },     // -230.25 -> -230
+    };
+    static const int32_t expect[] = { 4567, 2231, 2231, -231, -230 };
+    for (int t = 0; t < 5; t++) {
+        for (int i = 0; i < 4; i++, now += PERIOD_MS) {
+            app_sensor_agg_push(&agg, tail[t][i], true, now, &out);
+        }
+        app_sensor_agg_summary(&agg, &sum);
+        CHECK_EQ(sum.mean, expect[t]);
+    }
+}
+
+// A steady reading is still reported every max_interval_ms
+static void test_heartbeat(void)
+{
+    int32_t stream[40];
+    for (int i = 0; i < 40; i++) {
+        stream[i] = (i & 1) ? 2100 : 2101;      // Sensor noise below the delta
+    }
+    app_sensor_agg_t agg;
+    app_sensor_agg_init(&agg, &k_temperature);
+    reports_t r = {};
+    replay(&agg, stream, 40, 0, PERIOD_MS, &r);
+
+    CHECK_EQ(r.count, 4);                   // 0, 60, 120 and 180 s
+    for (int i = 0; i < r.count; i++) {
+        CHECK_EQ(r.at_ms[i], (uint32_t)i * 60000);
+    }
+}
+
+// min_interval_ms holds back a fast-changing stream, across the uint32 ms wrap
+static void test_rate_limit_wrap(void)
+{
+    int32_t stream[30];
+    for (int i = 0; i < 30; i++) {
+        stream[i] = 2000 + i * 100;         // Every sample is a large change
+    }
+    app_sensor_agg_config_t cfg = k_temperature;
+    cfg.min_interval_ms = 10000;
+    app_sensor_agg_t agg;
+    app_sensor_agg_init(&agg, &cfg);
+    reports_t r = {};
+    replay(&agg, stream, 30, UINT32_MAX - 20000, 1000, &r);
+
+    CHECK_EQ(r.count, 3);                   // Samples 0, 10 and 20
+    for (int i = 1; i < r.count; i++) {
+        CHECK_EQ(r.at_ms[i] - r.at_ms[i - 1], 10000);
+    }
+    CHECK_EQ(app_sensor_agg_stats(&agg)->suppressed, 27);
+}
+
+int main(void)
+{
+    test_temperature_glitch();
+    test_humidity_outage();
+    test_dead_sensor();
+    test_mean();
+    test_heartbeat();
+    test_rate_limit_wrap();
+    TEST_EXIT();
+}
@@ -0,0 +1,212 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// SHTC3 bus sequences and decoding against the scripted sensor in
+// mock_shtc3: command order, wake-up timing, product-code check, conversion
+// polling, CRC validation, and every error path the driver handles.
+
+#include "test_util.h"
+#include "mock_shtc3.h"
+#include "shtc3_proto.h"
+
+#define TIMEOUT_MS  20
+
+static shtc3_bus_t make_bus(mock_shtc3_t *m)
+{
+    shtc3_bus_t bus = { mock_shtc3_run, m, TIMEOUT_MS };
+    return bus;
+}
+
+static void test_probe(void)
+{
+    mock_shtc3_t m;
+    mock_shtc3_init(&m);
+    shtc3_bus_t bus = make_bus(&m);
+    uint16_t code = 0;
+    CHECK_EQ(shtc3_probe(&bus, &code), ESP_OK);
+    CHECK_EQ(code, 0x0887);
+    CHECK_EQ(m.cmd_count, 2);
+    CHECK_EQ(m.cmds[0], SHTC3_CMD_WAKE_UP);
+    CHECK_EQ(m.cmds[1], SHTC3_CMD_READ_ID);
+    CHECK_EQ(m.nacks, 0);                       // The wake-up wait was long enough
+    CHECK_EQ(m.batches, 1);
+
+    // Don't-care bits of the ID word are ignored
+    mock_shtc3_init(&m);
+    m.id_word = 0xFFC7;
+    CHECK_EQ(shtc3_probe(&bus, &code), ESP_OK);
+
+    // Another Sensirion part answers, but is not an SHTC3
+    mock_shtc3_init(&m);
+    m.id_word = 0x0001;
+    code = 0;
+    CHECK_EQ(shtc3_probe(&bus, &code), ESP_ERR_INVALID_RESPONSE);
+    CHECK_EQ(code, 0x0001);
+
+    // Nothing on the bus
+    mock_shtc3_init(&m);
+    m.present = false;
+    CHECK_EQ(shtc3_probe(&bus, &code), ESP_FAIL);
+    CHECK_EQ(m.cmd_count, 0);
+
+    // One NACK fails the probe; the next one succeeds
+    mock_shtc3_init(&m);
+    m.nack_ops = 1;
+    CHECK_EQ(shtc3_probe(&bus, &code), ESP_FAIL);
+    CHECK_EQ(shtc3_probe(&bus, &code), ESP_OK);
+}
+
+static void check_cycle(uint16_t measure_cmd, uint32_t conversion_us)
+{
+    mock_shtc3_t m;
+    mock_shtc3_init(&m);
+    shtc3_bus_t bus = make_bus(&m);
+    uint8_t data[SHTC3_SAMPLE_SIZE];
+
+    CHECK_EQ(shtc3_start(&bus, measure_cmd), ESP_OK);
+    CHECK_EQ(shtc3_collect(&bus, 0, data), ESP_FAIL);      // Still converting
+    CHECK_EQ(shtc3_sleep(&bus), ESP_FAIL);                  // No commands while converting
+    mock_shtc3_advance(&m, conversion_us);
+    CHECK_EQ(shtc3_collect(&bus, 0, data), ESP_OK);
+    CHECK_EQ(shtc3_sleep(&bus), ESP_OK);
+    CHECK_EQ(m.state, MOCK_SHTC3_ASLEEP);
+
+    shtc3_raw_sample_t raw;
+    CHECK_EQ(shtc3_decode(data, &raw), SHTC3_DECODE_T_OK | SHTC3_DECODE_RH_OK);
+    CHECK_EQ(raw.temperature_raw, 0x6666);
+    CHECK_EQ(raw.humidity_raw, 0x8000);
+    CHECK_EQ(shtc3_temperature_centi(raw.temperature_raw), 2500);
+    CHECK_EQ(shtc3_humidity_centi(raw.humidity_raw), 5000);
+
+    CHECK_EQ(m.cmd_count, 3);
+    CHECK_EQ(m.cmds[0], SHTC3_CMD_WAKE_UP);
+    CHECK_EQ(m.cmds[1], measure_cmd);
+    CHECK_EQ(m.cmds[2], SHTC3_CMD_SLEEP);
+
+    // The next sample wakes the sensor again first
+    CHECK_EQ(shtc3_start(&bus, measure_cmd), ESP_OK);
+    CHECK_EQ(m.cmds[3], SHTC3_CMD_WAKE_UP);
+}
+
+static void test_measure_cycle(void)
+{
+    check_cycle(SHTC3_CMD_MEASURE_NORMAL, 10800);
+    check_cycle(SHTC3_CMD_MEASURE_LOW_POWER, 700);
+}
+
+// The init-time conversion measurement: poll with a delay until the read ACKs
+static void test_poll_conversion(void)
+{
+    mock_shtc3_t m;
+    mock_shtc3_init(&m);
+    shtc3_bus_t bus = make_bus(&m);
+    uint8_t data[SHTC3_SAMPLE_SIZE];
+
+    CHECK_EQ(shtc3_start(&bus, SHTC3_CMD_MEASURE_NORMAL), ESP_OK);
+    uint64_t start = m.now_us;
+    int polls = 0;
+    while (shtc3_collect(&bus, 100, data) != ESP_OK && polls < 1000) {
+        polls++;
+    }
+    uint64_t elapsed = m.now_us - start;
+    CHECK(elapsed >= m.normal_us);
+    // Within one poll period plus the 6-byte read of the true time
+    CHECK(elapsed <= m.normal_us + 100 + 7 * MOCK_SHTC3_BYTE_US + MOCK_SHTC3_BYTE_US);
+    CHECK(polls > 50 && polls < 120);
+}
+
+static void test_crc_corruption(void)
+{
+    static const struct {
+        int index;
+        unsigned ok;
+    } cases[] = {
+        { 0, SHTC3_DECODE_RH_OK },
+        { 1, SHTC3_DECODE_RH_OK },
+        { 2, SHTC3_DECODE_RH_OK },
+        { 3, SHTC3_DECODE_T_OK },
+        { 4, SHTC3_DECODE_T_OK },
+        { 5, SHTC3_DECODE_T_OK },
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        mock_shtc3_t m;
+        mock_shtc3_init(&m);
+        m.corrupt_index = cases[i].index;
+        shtc3_bus_t bus = make_bus(&m);
+        uint8_t data[SHTC3_SAMPLE_SIZE];
+        CHECK_EQ(shtc3_start(&bus, SHTC3_CMD_MEASURE_LOW_POWER), ESP_OK);
+        mock_shtc3_advance(&m, m.low_power_us);
+        CHECK_EQ(shtc3_collect(&bus, 0, data), ESP_OK);
+        shtc3_raw_sample_t raw;
+        CHECK_EQ(shtc3_decode(data, &raw), cases[i].ok);
+    }
+}
+
+static void test_clock_stretch(void)
+{
+    mock_shtc3_t m;
+    mock_shtc3_init(&m);
+    shtc3_bus_t bus = make_bus(&m);
+    uint8_t data[SHTC3_SAMPLE_SIZE];
+
+    m.stretch_us = 5000;                // Held low, but inside the 20 ms timeout
+    CHECK_EQ(shtc3_start(&bus, SHTC3_CMD_MEASURE_LOW_POWER), ESP_OK);
+    mock_shtc3_advance(&m, m.low_power_us);
+    uint64_t before = m.now_us;
+    CHECK_EQ(shtc3_collect(&bus, 0, data), ESP_OK);
+    CHECK(m.now_us - before >= 5000);
+
+    m.stretch_us = (TIMEOUT_MS + 10) * 1000;
+    uint16_t code;
+    CHECK_EQ(shtc3_probe(&bus, &code), ESP_ERR_TIMEOUT);
+    CHECK_EQ(shtc3_start(&bus, SHTC3_CMD_MEASURE_LOW_POWER), ESP_OK);    // Writes are not stretched
+    mock_shtc3_advance(&m, m.low_power_us);
+    CHECK_EQ(shtc3_collect(&bus, 0, data), ESP_ERR_TIMEOUT);
+}
+
+static void test_error_paths(void)
+{
+    mock_shtc3_t m;
+    shtc3_bus_t bus = make_bus(&m);
+    uint8_t data[SHTC3_SAMPLE_SIZE];
+
+    // Start: NACK on the wake-up byte, on the measure command, absent sensor
+    for (int nacks = 1; nacks <= 2; nacks++) {
+        mock_shtc3_init(&m);
+        m.nack_ops = nacks;
+        CHECK_EQ(shtc3_start(&bus, SHTC3_CMD_MEASURE_NORMAL), ESP_FAIL);
+    }
+    mock_shtc3_init(&m);
+    m.present = false;
+    CHECK_EQ(shtc3_start(&bus, SHTC3_CMD_MEASURE_NORMAL), ESP_FAIL);
+    CHECK_EQ(shtc3_sleep(&bus), ESP_FAIL);
+
+    // Collect without a measurement, and after the sensor went away
+    mock_shtc3_init(&m);
+    CHECK_EQ(shtc3_collect(&bus, 0, data), ESP_FAIL);
+    CHECK_EQ(shtc3_start(&bus, SHTC3_CMD_MEASURE_NORMAL), ESP_OK);
+    mock_shtc3_advance(&m, m.normal_us);
+    m.present = false;
+    CHECK_EQ(shtc3_collect(&bus, 0, data), ESP_FAIL);
+
+    // A command the sensor does not know
+    mock_shtc3_init(&m);
+    CHECK_EQ(shtc3_start(&bus, 0x1234), ESP_FAIL);
+    CHECK_EQ(m.cmd_count, 1);           // Only the wake-up was accepted
+}
+
+int main(void)
+{
+    test_probe();
+    test_measure_cycle();
+    test_poll_conversion();
+    test_crc_corruption();
+    test_clock_stretch();
+    test_error_paths();
+    TEST_EXIT();
+}
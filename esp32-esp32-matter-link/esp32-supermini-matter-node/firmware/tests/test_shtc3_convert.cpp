@@ -0,0 +1,63 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Every one of the 65536 raw words through the integer SHTC3 conversions,
+// against round-to-nearest of the exact datasheet formulas in long double
+// (the nearest .5 is 1/131070 away, far above its precision). Also counts
+// the words the float reference misrounds, as stated in shtc3_proto.cpp.
+
+#include <math.h>
+
+#include "test_util.h"
+#include "shtc3_proto.h"
+
+int main(void)
+{
+    uint32_t t_wrong = 0;
+    uint32_t rh_wrong = 0;
+    uint32_t t_float_wrong = 0;
+    uint32_t rh_float_wrong = 0;
+    int32_t t_prev = INT32_MIN;
+    int32_t rh_prev = INT32_MIN;
+
+    for (uint32_t raw = 0; raw <= UINT16_MAX; raw++) {
+        long long t_exact = llroundl(-4500.0L + 17500.0L * raw / 65535.0L);
+        long long rh_exact = llroundl(10000.0L * raw / 65535.0L);
+        int32_t t = shtc3_temperature_centi((uint16_t)raw);
+        int32_t rh = shtc3_humidity_centi((uint16_t)raw);
+
+        if (t != t_exact) {
+            if (t_wrong++ < 5) {
+                printf("T raw 0x%04x: %d, exact %lld\n", (unsigned)raw, (int)t, t_exact);
+            }
+        }
+        if (rh != rh_exact) {
+            if (rh_wrong++ < 5) {
+                printf("RH raw 0x%04x: %d, exact %lld\n", (unsigned)raw, (int)rh, rh_exact);
+            }
+        }
+        // Monotonic, and no step larger than one count
+        CHECK(t >= t_prev && rh >= rh_prev);
+        CHECK(t_prev == INT32_MIN || t - t_prev <= 1);
+        CHECK(rh_prev == INT32_MIN || rh - rh_prev <= 1);
+        t_prev = t;
+        rh_prev = rh;
+
+        t_float_wrong += lroundf(shtc3_temperature_c((uint16_t)raw) * 100.0f) != t_exact;
+        rh_float_wrong += lroundf(shtc3_humidity_pct((uint16_t)raw) * 100.0f) != rh_exact;
+    }
+
+    CHECK_EQ(t_wrong, 0);
+    CHECK_EQ(rh_wrong, 0);
+    CHECK_EQ(shtc3_temperature_centi(0), -4500);
+    CHECK_EQ(shtc3_temperature_centi(UINT16_MAX), 13000);
+    CHECK_EQ(shtc3_humidity_centi(0), 0);
+    CHECK_EQ(shtc3_humidity_centi(UINT16_MAX), 10000);
+    printf("float reference misrounds: T %u, RH %u of 65536\n", (unsigned)t_float_wrong, (unsigned)rh_float_wrong);
+    TEST_EXIT();
+}
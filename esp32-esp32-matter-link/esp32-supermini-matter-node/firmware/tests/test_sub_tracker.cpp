@@ -0,0 +1,91 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Subscription tracker over the ReadHandler callback sequences a reboot
+// produces: persisted subscriptions resumed by the node, a controller that
+// subscribes again on top of a resumed one, and a boot with nothing to resume.
+// Checks the first-subscription timer and the active count.
+
+#include "test_util.h"
+#include "app_sub_tracker.h"
+
+#define MS(x)   ((int64_t)(x) * 1000)
+
+static void test_no_subscription(void)
+{
+    app_sub_tracker_t t;
+    app_sub_tracker_start(&t, MS(3200));
+    CHECK_EQ(t.first_us, 0);
+    CHECK_EQ(app_sub_tracker_first_after_start_us(&t), -1);
+    CHECK_EQ(t.active, 0);
+}
+
+// Two persisted subscriptions come back once CASE to each controller is up
+static void test_resume(void)
+{
+    app_sub_tracker_t t;
+    app_sub_tracker_start(&t, MS(3200));
+    CHECK(app_sub_tracker_established(&t, MS(3900)));
+    CHECK(!app_sub_tracker_established(&t, MS(4150)));
+    CHECK_EQ(t.first_us, MS(3900));
+    CHECK_EQ(app_sub_tracker_first_after_start_us(&t), MS(700));
+    CHECK_EQ(t.active, 2);
+    CHECK_EQ(t.established, 2);
+
+    // One controller also noticed the reboot and subscribed again: the stack
+    // establishes the new one and drops the resumed one
+    CHECK(!app_sub_tracker_established(&t, MS(30000)));
+    app_sub_tracker_terminated(&t);
+    CHECK_EQ(t.active, 2);
+    CHECK_EQ(t.established, 3);
+    CHECK_EQ(t.terminated, 1);
+    CHECK_EQ(t.first_us, MS(3900));     // The timer only runs once per boot
+
+    // Everything ends, then a controller subscribes again
+    app_sub_tracker_terminated(&t);
+    app_sub_tracker_terminated(&t);
+    CHECK_EQ(t.active, 0);
+    CHECK(!app_sub_tracker_established(&t, MS(60000)));
+    CHECK_EQ(t.active, 1);
+    CHECK_EQ(t.first_us, MS(3900));
+}
+
+// A resumed handler that ends before one was counted must not wrap the count
+static void test_terminated_first(void)
+{
+    app_sub_tracker_t t;
+    app_sub_tracker_start(&t, MS(3200));
+    app_sub_tracker_terminated(&t);
+    CHECK_EQ(t.active, 0);
+    CHECK_EQ(t.terminated, 1);
+    CHECK_EQ(app_sub_tracker_first_after_start_us(&t), -1);
+}
+
+// Without persistence the first subscription is the controller's retry
+static void test_resubscribe_only(void)
+{
+    app_sub_tracker_t t;
+    app_sub_tracker_start(&t, MS(3200));
+    CHECK(app_sub_tracker_established(&t, MS(95000)));
+    CHECK_EQ(app_sub_tracker_first_after_start_us(&t), MS(91800));
+
+    // A new boot starts the timer again
+    app_sub_tracker_start(&t, MS(3100));
+    CHECK_EQ(t.established, 0);
+    CHECK(app_sub_tracker_established(&t, MS(3600)));
+    CHECK_EQ(app_sub_tracker_first_after_start_us(&t), MS(500));
+}
+
+int main(void)
+{
+    test_no_subscription();
+    test_resume();
+    test_terminated_first();
+    test_resubscribe_only();
+    TEST_EXIT();
+}
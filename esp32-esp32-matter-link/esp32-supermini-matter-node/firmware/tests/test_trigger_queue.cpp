@@ -0,0 +1,151 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Trigger queue under bursts: a skit starts, then more triggers arrive before
+// it ends. Checks the result of each trigger, the order and source of the
+// runs that follow, and the statistics, for every policy.
+
+#include "test_util.h"
+#include "app_trigger_queue.h"
+
+#define BURST   12
+
+static app_trigger_t make_trigger(uint16_t i)
+{
+    app_trigger_t t = { (i & 1) ? APP_TRIGGER_SRC_LINK : APP_TRIGGER_SRC_HOMEKIT, (uint16_t)(100 + i) };
+    return t;
+}
+
+// Submits BURST triggers back to back, then drains; returns the number of runs
+static int burst_and_drain(app_trigger_queue_t *q, app_trigger_result_t *results, app_trigger_t *runs)
+{
+    for (uint16_t i = 0; i < BURST; i++) {
+        app_trigger_t t = make_trigger(i);
+        results[i] = app_trigger_queue_submit(q, &t);
+    }
+    int n = 0;
+    runs[n++] = q->current;
+    app_trigger_t finished;
+    app_trigger_t next;
+    while (app_trigger_queue_complete(q, &finished, &next)) {
+        CHECK_EQ(finished.trace_id, runs[n - 1].trace_id);
+        runs[n++] = next;
+    }
+    CHECK(!q->active);
+    CHECK_EQ(app_trigger_queue_pending(q), 0);
+    CHECK(!app_trigger_queue_complete(q, NULL, NULL));  // Idle: nothing to complete
+    return n;
+}
+
+static void test_drop(void)
+{
+    app_trigger_queue_t q;
+    app_trigger_result_t results[BURST];
+    app_trigger_t runs[BURST + 1];
+    app_trigger_queue_init(&q, APP_TRIGGER_POLICY_DROP, 5);   // Depth ignored
+
+    int n = burst_and_drain(&q, results, runs);
+    CHECK_EQ(n, 1);
+    CHECK_EQ(results[0], APP_TRIGGER_STARTED);
+    for (int i = 1; i < BURST; i++) {
+        CHECK_EQ(results[i], APP_TRIGGER_DROPPED);
+    }
+    CHECK_EQ(q.stats.started, 1);
+    CHECK_EQ(q.stats.dropped, BURST - 1);
+    CHECK_EQ(q.stats.completed, 1);
+    CHECK_EQ(q.stats.max_pending, 0);
+}
+
+static void test_coalesce(void)
+{
+    app_trigger_queue_t q;
+    app_trigger_result_t results[BURST];
+    app_trigger_t runs[BURST + 1];
+    app_trigger_queue_init(&q, APP_TRIGGER_POLICY_COALESCE, 5);
+
+    int n = burst_and_drain(&q, results, runs);
+    CHECK_EQ(n, 2);
+    CHECK_EQ(results[0], APP_TRIGGER_STARTED);
+    CHECK_EQ(results[1], APP_TRIGGER_QUEUED);
+    for (int i = 2; i < BURST; i++) {
+        CHECK_EQ(results[i], APP_TRIGGER_COALESCED);
+    }
+    // The pending run keeps the first merged trigger's source and trace
+    CHECK_EQ(runs[1].trace_id, make_trigger(1).trace_id);
+    CHECK_EQ(runs[1].source, make_trigger(1).source);
+    CHECK_EQ(q.stats.started, 2);
+    CHECK_EQ(q.stats.coalesced, BURST - 2);
+    CHECK_EQ(q.stats.completed, 2);
+    CHECK_EQ(q.stats.max_pending, 1);
+}
+
+static void test_queue(uint8_t depth)
+{
+    app_trigger_queue_t q;
+    app_trigger_result_t results[BURST];
+    app_trigger_t runs[BURST + 1];
+    app_trigger_queue_init(&q, APP_TRIGGER_POLICY_QUEUE, depth);
+    uint8_t effective = depth < 1 ? 1 : (depth > APP_TRIGGER_QUEUE_MAX ? APP_TRIGGER_QUEUE_MAX : depth);
+    CHECK_EQ(q.depth, effective);
+
+    int n = burst_and_drain(&q, results, runs);
+    CHECK_EQ(n, 1 + effective);
+    for (int i = 0; i < BURST; i++) {
+        app_trigger_result_t expected = i == 0 ? APP_TRIGGER_STARTED :
+                                        i <= effective ? APP_TRIGGER_QUEUED : APP_TRIGGER_DROPPED;
+        CHECK_EQ(results[i], expected);
+    }
+    // Runs in arrival order, sources preserved
+    for (int i = 0; i < n; i++) {
+        CHECK_EQ(runs[i].trace_id, make_trigger((uint16_t)i).trace_id);
+        CHECK_EQ(runs[i].source, make_trigger((uint16_t)i).source);
+    }
+    CHECK_EQ(q.stats.queued, effective);
+    CHECK_EQ(q.stats.dropped, BURST - 1 - effective);
+    CHECK_EQ(q.stats.max_pending, effective);
+}
+
+// Bursts interleaved with completions wrap the ring several times
+static void test_queue_wraps(void)
+{
+    app_trigger_queue_t q;
+    app_trigger_queue_init(&q, APP_TRIGGER_POLICY_QUEUE, APP_TRIGGER_QUEUE_MAX);
+    uint16_t submitted = 0;
+    uint16_t expected_next = 0;
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < 3; i++) {
+            app_trigger_t t = make_trigger(submitted++);
+            app_trigger_result_t r = app_trigger_queue_submit(&q, &t);
+            CHECK(r == APP_TRIGGER_STARTED || r == APP_TRIGGER_QUEUED);
+            if (r == APP_TRIGGER_STARTED) {
+                CHECK_EQ(q.current.trace_id, make_trigger(expected_next++).trace_id);
+            }
+        }
+        for (int i = 0; i < 3; i++) {
+            app_trigger_t next;
+            if (app_trigger_queue_complete(&q, NULL, &next)) {
+                CHECK_EQ(next.trace_id, make_trigger(expected_next++).trace_id);
+            }
+        }
+    }
+    CHECK(!q.active);
+    CHECK_EQ(expected_next, submitted);
+    CHECK_EQ(q.stats.dropped, 0);
+}
+
+int main(void)
+{
+    test_drop();
+    test_coalesce();
+    test_queue(0);
+    test_queue(3);
+    test_queue(APP_TRIGGER_QUEUE_MAX);
+    test_queue(200);
+    test_queue_wraps();
+    TEST_EXIT();
+}
@@ -0,0 +1,50 @@
+/*
+   This example code is in the Public Domain (or CC0 licensed, at your option.)
+
+   Unless required by applicable law or agreed to in writing, this
+   software is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR
+   CONDITIONS OF ANY KIND, either express or implied.
+*/
+
+// Minimal checks for the host tests: CHECK() records a failure and carries
+// on, TEST_EXIT() turns the count into the process exit status for ctest.
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+static int g_test_failures = 0;
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond);     \
+            g_test_failures++;                                                  \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                          \
+    do {                                                                        \
+        long long _a = (long long)(a);                                          \
+        long long _b = (long long)(b);                                          \
+        if (_a != _b) {                                                         \
+            printf("%s:%d: CHECK_EQ failed: %s == %s (%lld != %lld)\n",         \
+                   __FILE__, __LINE__, #a, #b, _a, _b);                         \
+            g_test_failures++;                                                  \
+        }                                                                       \
+    } while (0)
+
+#define TEST_EXIT()                                                             \
+    do {                                                                        \
+        printf("%s: %d failure(s)\n", __FILE__, g_test_failures);               \
+        return g_test_failures ? 1 : 0;                                         \
+    } while (0)
+
+/** Monotonic host time in nanoseconds, for the benchmarks. */
+static inline uint64_t test_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
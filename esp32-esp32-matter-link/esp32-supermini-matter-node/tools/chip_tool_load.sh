@@ -0,0 +1,102 @@
+#!/usr/bin/env bash
+# chip_tool_load.sh  —  Drive the skull node with chip-tool over IP and time it
+# Usage:
+#   tools/chip_tool_load.sh [--pair PASSCODE] [--node ID] [--count N] [--gap SEC]
+# - Talks to a node already on Wi-Fi (no BLE, no phone, no HomeKit needed)
+# - --pair commissions it first over DNS-SD (commissioning window must be open)
+# - Fires N trigger writes and N mode writes, each timed end to end
+# - Keeps a subscription on all mode plugs open meanwhile and counts its reports
+# Node-side numbers come from the C3 console: `latency`, `matter`, `events`, `heap`.
+# example: tools/chip_tool_load.sh --pair 20202021 --count 50
+
+set -euo pipefail
+
+NODE_ID=0x5EED
+COUNT=20
+GAP=1.0
+PASSCODE=""
+CHIP_TOOL=${CHIP_TOOL:-chip-tool}
+
+# Endpoint layout created by app_main.cpp (0 = root node)
+TRIGGER_EP=1
+MODE_EPS=(2 3 4 5)
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --pair)  PASSCODE="$2"; shift 2 ;;
+        --node)  NODE_ID="$2"; shift 2 ;;
+        --count) COUNT="$2"; shift 2 ;;
+        --gap)   GAP="$2"; shift 2 ;;
+        *) echo "Usage: $0 [--pair PASSCODE] [--node ID] [--count N] [--gap SEC]"; exit 1 ;;
+    esac
+done
+
+command -v "$CHIP_TOOL" >/dev/null || { echo "chip-tool not found (set CHIP_TOOL=...)"; exit 1; }
+
+now_ms() { date +%s%3N; }
+
+# Run one chip-tool command, append its wall time (ms) to file $1
+timed() {
+    local out=$1; shift
+    local t0 t1
+    t0=$(now_ms)
+    if "$CHIP_TOOL" "$@" >/dev/null 2>&1; then
+        t1=$(now_ms)
+        echo $((t1 - t0)) >> "$out"
+    else
+        echo "FAIL: $*" >&2
+        echo fail >> "$out"
+    fi
+}
+
+summary() {
+    local name=$1 file=$2
+    local fails
+    fails=$(grep -c fail "$file" || true)
+    grep -v fail "$file" | sort -n | awk -v name="$name" -v fails="$fails" '
+        { v[NR] = $1; sum += $1 }
+        END {
+            if (NR == 0) { printf "%-10s no successful writes (%d failed)\n", name, fails; exit }
+            p50 = v[int((NR * 50 + 99) / 100)]; p90 = v[int((NR * 90 + 99) / 100)]
+            printf "%-10s n=%-4d fail=%-3d avg=%-6d p50=%-6d p90=%-6d max=%d ms\n",
+                   name, NR, fails, sum / NR, p50, p90, v[NR]
+        }'
+}
+
+WORK=$(mktemp -d)
+trap 'kill $(jobs -p) 2>/dev/null || true; rm -rf "$WORK"' EXIT
+
+if [ -n "$PASSCODE" ]; then
+    echo "Commissioning node $NODE_ID over DNS-SD..."
+    "$CHIP_TOOL" pairing onnetwork "$NODE_ID" "$PASSCODE"
+fi
+
+# Subscription on every mode plug, counting report fan-out while we write
+SUB_SECONDS=$(awk -v n="$COUNT" -v g="$GAP" 'BEGIN { printf "%d", n * 2 * (g + 1) + 10 }')
+MODE_LIST=$(IFS=,; echo "${MODE_EPS[*]}")
+timeout "$SUB_SECONDS" "$CHIP_TOOL" onoff subscribe on-off 0 5 "$NODE_ID" "$MODE_LIST" \
+    > "$WORK/sub.log" 2>&1 &
+sleep 3
+
+echo "Triggers: $COUNT x onoff on (endpoint $TRIGGER_EP), ${GAP}s apart"
+for _ in $(seq "$COUNT"); do
+    timed "$WORK/trigger" onoff on "$NODE_ID" "$TRIGGER_EP"
+    sleep "$GAP"
+done
+
+echo "Modes: $COUNT x onoff on, cycling endpoints ${MODE_EPS[*]}, ${GAP}s apart"
+for i in $(seq 0 $((COUNT - 1))); do
+    timed "$WORK/mode" onoff on "$NODE_ID" "${MODE_EPS[$((i % ${#MODE_EPS[@]}))]}"
+    sleep "$GAP"
+done
+
+sleep 6   # Let the 5 s mode cleanup re-assert and report
+kill %1 2>/dev/null || true
+wait 2>/dev/null || true
+
+echo
+echo "chip-tool wall time per write (includes chip-tool start-up and CASE):"
+summary trigger "$WORK/trigger"
+summary mode "$WORK/mode"
+REPORTS=$(grep -c "OnOff: " "$WORK/sub.log" || true)
+echo "Subscription reports on mode plugs: $REPORTS (for $COUNT mode writes)"
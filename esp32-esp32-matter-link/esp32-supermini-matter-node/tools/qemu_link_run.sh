@@ -0,0 +1,50 @@
+#!/usr/bin/env bash
+# qemu_link_run.sh  —  Boot the node image in QEMU and play the S3 against it
+# Usage:
+#   tools/qemu_link_run.sh [--count N] [--port P] [--csv FILE] [--no-build]
+# - Builds the image with sdkconfig.qemu (link on UART0) in firmware/build-qemu
+# - Builds the host S3 stand-in (firmware/tests, target s3_link_driver)
+# - Boots `idf.py qemu` with UART0 on localhost:P and runs HELLO, N PINGs and
+#   N TRIGGER -> ACK -> DONE skits, printing p50/p90/p99/max per exchange
+# - --csv keeps every latency sample; the QEMU output goes to build-qemu/qemu.log
+# Needs an ESP-IDF shell (idf.py on PATH) with qemu-riscv32 installed.
+# example: tools/qemu_link_run.sh --count 100 --csv qemu-latency.csv
+
+set -euo pipefail
+
+COUNT=50
+PORT=5555
+CSV=""
+BUILD=1
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --count)    COUNT="$2"; shift 2 ;;
+        --port)     PORT="$2"; shift 2 ;;
+        --csv)      CSV="$2"; shift 2 ;;
+        --no-build) BUILD=0; shift ;;
+        *) echo "Usage: $0 [--count N] [--port P] [--csv FILE] [--no-build]"; exit 1 ;;
+    esac
+done
+
+command -v idf.py >/dev/null || { echo "idf.py not found (source ESP-IDF's export.sh)"; exit 1; }
+
+FW=$(cd "$(dirname "$0")/../firmware" && pwd)
+IMAGE_BUILD=$FW/build-qemu
+HOST_BUILD=$FW/build-host
+
+if [ "$BUILD" -eq 1 ]; then
+    idf.py -C "$FW" -B "$IMAGE_BUILD" -D SDKCONFIG="$IMAGE_BUILD/sdkconfig" -D IDF_TARGET=esp32c3 \
+        -D SDKCONFIG_DEFAULTS="sdkconfig.defaults;sdkconfig.qemu" build
+    cmake -S "$FW/tests" -B "$HOST_BUILD"
+    cmake --build "$HOST_BUILD" --target s3_link_driver
+fi
+
+# An explicit -serial replaces QEMU's stdio console, so it is UART0
+idf.py -C "$FW" -B "$IMAGE_BUILD" qemu --qemu-extra-args="-serial tcp::$PORT,server,nowait" \
+    > "$IMAGE_BUILD/qemu.log" 2>&1 &
+QEMU_PID=$!
+trap 'kill "$QEMU_PID" 2>/dev/null || true; pkill -f "tcp::$PORT,server" 2>/dev/null || true' EXIT
+
+echo "QEMU booting (log: $IMAGE_BUILD/qemu.log), S3 stand-in on localhost:$PORT..."
+"$HOST_BUILD/s3_link_driver" --port "$PORT" --count "$COUNT" ${CSV:+--csv "$CSV"}
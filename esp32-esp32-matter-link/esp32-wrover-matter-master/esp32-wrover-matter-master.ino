@@ -50,6 +50,9 @@ HardwareSerial UartNode(1);  // Use Serial1
 #define CMD_SET_MODE 0x02
 #define CMD_TRIGGER  0x03
 #define CMD_PING     0x04
+#define CMD_WD_STATS 0x05  // Payload: first path u8. C3 replies ACK with watchdog stats and gap histograms
+#define CMD_HISTORY  0x06  // Payload: minutes u16; C3 replies ACK with a sensor history summary
+#define CMD_TOUCH    0x07  // Payload: touched u8, age_ms u16; C3 replies ACK with presence state, confidence
 
 // Status notifications (C3 → S3)
 #define CMD_STATUS_PAIRED    0x10
@@ -61,6 +64,11 @@ HardwareSerial UartNode(1);  // Use Serial1
 #define RSP_BUSY     0x82
 #define RSP_DONE     0x83
 
+// Latency tracing: a TRIGGER from the C3 may carry a trace ID (u16, little-endian).
+// We echo it in the ACK with our parse->handler and parse->ACK offsets in microseconds.
+#define TRIGGER_TRACE_PAYLOAD_LEN  2
+#define ACK_TRACE_PAYLOAD_LEN      10
+
 // ===== Statistics =====
 struct {
   uint32_t frames_sent;
@@ -297,12 +305,114 @@ void cmdSetMode(uint8_t mode) {
   }
 }
 
+// Path order is the C3's registration order in app_wd_start()
+const char *WD_PATH_NAMES[] = { "dispatcher", "uart_rx", "matter" };
+
+// Reply layout (app_wd_encode): count u8, first u8, n u8, then per path
+// stalls u16, max_ms u16 and WD_BUCKETS gap buckets u16, little-endian
+#define WD_HEADER     3
+#define WD_BUCKETS    7
+#define WD_PATH_SIZE  (4 + 2 * WD_BUCKETS)
+const char *WD_BUCKET_LABELS[WD_BUCKETS] = { "<1", "<10", "<50", "<100", "<250", "<1000", ">=1000" };
+
+void cmdWatchdog() {
+  Serial.println("\n>>> Sending WD_STATS");
+  uint8_t first = 0;
+  uint8_t count = 1;
+  bool header_printed = false;
+  while (first < count) {
+    if (!sendFrame(CMD_WD_STATS, &first, 1)) {
+      return;
+    }
+    uint8_t rsp_cmd, rsp_payload[64], rsp_len;
+    if (!receiveFrame(rsp_cmd, rsp_payload, rsp_len)) {
+      return;
+    }
+    uint8_t n = rsp_len >= WD_HEADER ? rsp_payload[2] : 0;
+    if (rsp_cmd != RSP_ACK || rsp_len < WD_HEADER || rsp_payload[1] != first ||
+        n == 0 || rsp_len < WD_HEADER + WD_PATH_SIZE * n) {
+      handleResponse(rsp_cmd, rsp_payload, rsp_len);
+      return;
+    }
+    stats.ack_count++;
+    count = rsp_payload[0];
+    if (!header_printed) {
+      header_printed = true;
+      Serial.printf("C3 latency watchdog (gap buckets in ms):\n  %-10s %6s %6s", "path", "stalls", "max");
+      for (uint8_t b = 0; b < WD_BUCKETS; b++) {
+        Serial.printf(" %6s", WD_BUCKET_LABELS[b]);
+      }
+      Serial.println();
+    }
+    for (uint8_t i = 0; i < n; i++) {
+      uint8_t path = first + i;
+      const uint8_t *p = &rsp_payload[WD_HEADER + WD_PATH_SIZE * i];
+      Serial.printf("  %-10s %6u %4ums",
+                    path < sizeof(WD_PATH_NAMES) / sizeof(WD_PATH_NAMES[0]) ? WD_PATH_NAMES[path] : "?",
+                    p[0] | (p[1] << 8), p[2] | (p[3] << 8));
+      for (uint8_t b = 0; b < WD_BUCKETS; b++) {
+        Serial.printf(" %6u", p[4 + 2 * b] | (p[5 + 2 * b] << 8));
+      }
+      Serial.println();
+    }
+    first += n;
+  }
+}
+
+// Prints a 0.01-unit value, or "--" for the C3's invalid marker
+void printCenti(const char *label, int32_t centi, bool valid) {
+  if (!valid) {
+    Serial.printf(" %s=--", label);
+    return;
+  }
+  int32_t magnitude = centi < 0 ? -centi : centi;
+  Serial.printf(" %s=%s%ld.%02ld", label, centi < 0 ? "-" : "", (long)(magnitude / 100), (long)(magnitude % 100));
+}
+
+void cmdHistory(uint16_t minutes) {
+  Serial.printf("\n>>> Sending HISTORY (%u min)\n", minutes);
+  uint8_t payload[2] = { (uint8_t)(minutes & 0xFF), (uint8_t)(minutes >> 8) };
+  if (sendFrame(CMD_HISTORY, payload, sizeof(payload))) {
+    uint8_t rsp_cmd, rsp_payload[32], rsp_len;
+    if (receiveFrame(rsp_cmd, rsp_payload, rsp_len)) {
+      if (rsp_cmd == RSP_ACK && rsp_len >= 16) {
+        stats.ack_count++;
+        const uint8_t *p = rsp_payload;
+        uint16_t count = p[0] | (p[1] << 8);
+        int16_t t_min = (int16_t)(p[2] | (p[3] << 8));
+        int16_t t_max = (int16_t)(p[4] | (p[5] << 8));
+        int16_t t_mean = (int16_t)(p[6] | (p[7] << 8));
+        uint16_t h_min = p[8] | (p[9] << 8);
+        uint16_t h_max = p[10] | (p[11] << 8);
+        uint16_t h_mean = p[12] | (p[13] << 8);
+        uint16_t occupied = p[14] | (p[15] << 8);
+        Serial.printf("C3 history: %u samples, occupied %u min\n", count, occupied);
+        Serial.print("  temperature C:");
+        printCenti("min", t_min, t_min != INT16_MIN);
+        printCenti("max", t_max, t_max != INT16_MIN);
+        printCenti("mean", t_mean, t_mean != INT16_MIN);
+        Serial.print("\n  humidity %RH: ");
+        printCenti("min", h_min, h_min != 0xFFFF);
+        printCenti("max", h_max, h_max != 0xFFFF);
+        printCenti("mean", h_mean, h_mean != 0xFFFF);
+        Serial.println();
+      } else {
+        handleResponse(rsp_cmd, rsp_payload, rsp_len);
+      }
+    }
+  }
+}
+
 // ===== Response Handler =====
 void handleResponse(uint8_t cmd, const uint8_t *payload, uint8_t payload_len) {
   switch (cmd) {
     case RSP_ACK:
       stats.ack_count++;
-      Serial.println("✓ ACK received");
+      Serial.print("✓ ACK received");
+      if (payload_len > 0) {
+        Serial.printf(" (%u pending, DONE will follow)", payload[0]);
+      }
+      Serial.println();
       break;
       
     case RSP_ERR:
@@ -344,6 +454,28 @@ void showStats() {
   Serial.println("=======================\n");
 }
 
+// Order matches app_presence_state_t on the C3
+const char *PRESENCE_NAMES[] = { "absent", "present", "engaged", "leaving" };
+
+// Reports a touch sensor change that happened age_ms ago
+void cmdTouch(bool touched, uint16_t age_ms) {
+  Serial.printf("\n>>> Sending TOUCH %s\n", touched ? "on" : "off");
+  uint8_t payload[3] = { (uint8_t)touched, (uint8_t)(age_ms & 0xFF), (uint8_t)(age_ms >> 8) };
+  if (sendFrame(CMD_TOUCH, payload, sizeof(payload))) {
+    uint8_t rsp_cmd, rsp_payload[8], rsp_len;
+    if (receiveFrame(rsp_cmd, rsp_payload, rsp_len)) {
+      if (rsp_cmd == RSP_ACK && rsp_len >= 2) {
+        stats.ack_count++;
+        Serial.printf("C3 presence: %s, confidence %u\n",
+                      rsp_payload[0] < sizeof(PRESENCE_NAMES) / sizeof(PRESENCE_NAMES[0]) ? PRESENCE_NAMES[rsp_payload[0]] : "?",
+                      rsp_payload[1]);
+      } else {
+        handleResponse(rsp_cmd, rsp_payload, rsp_len);
+      }
+    }
+  }
+}
+
 // ===== CLI Parser =====
 void processCLI(String cmd) {
   cmd.trim();
@@ -362,6 +494,15 @@ void processCLI(String cmd) {
     int mode = cmd.substring(5).toInt();
     cmdSetMode((uint8_t)mode);
   }
+  else if (cmd == "wd") {
+    cmdWatchdog();
+  }
+  else if (cmd == "history" || cmd.startsWith("history ")) {
+    cmdHistory(cmd.length() > 8 ? (uint16_t)cmd.substring(8).toInt() : 0);
+  }
+  else if (cmd == "touch on" || cmd == "touch off") {
+    cmdTouch(cmd == "touch on", 0);
+  }
   else if (cmd == "status" || cmd == "stats") {
     showStats();
   }
@@ -379,6 +520,9 @@ void printHelp() {
   Serial.println("ping        - Send PING health check");
   Serial.println("trigger     - Send TRIGGER to start skit");
   Serial.println("mode <0-3>  - Send SET_MODE command");
+  Serial.println("wd          - Show C3 latency watchdog stalls and gap histograms");
+  Serial.println("history [m] - Show C3 sensor history summary (last m minutes, default all)");
+  Serial.println("touch <on|off> - Report a touch change to the C3 presence fusion");
   Serial.println("status      - Show UART statistics");
   Serial.println("help        - Show this help");
   Serial.println("====================\n");
@@ -468,12 +612,15 @@ void checkIncomingCommands() {
         
         if (calc_crc == received_crc) {
           // Valid frame - display it
+          uint32_t t_parsed = micros();
+          uint32_t t_handler = 0;
           uint8_t payload_len = frame_len - 1;
           
           Serial.print("\n🔔 INCOMING from C3: ");
           
           // Display based on command type
           if (cmd == CMD_TRIGGER) {
+            t_handler = micros();
             Serial.println("TRIGGER (HomeKit activated!)");
             ledBlink(1, 500);  // Visual confirmation
           }
@@ -507,12 +654,33 @@ void checkIncomingCommands() {
           else if (cmd == CMD_PING) {
             Serial.println("PING");
           }
+          else if (cmd == RSP_DONE) {
+            // Unsolicited: the C3 finished a skit; payload = skits still to run
+            stats.done_count++;
+            Serial.printf("DONE (skit complete, %u pending)\n", payload_len > 0 ? payload[0] : 0);
+          }
           else {
             Serial.printf("Unknown CMD 0x%02X\n", cmd);
           }
           
-          // Send ACK back
-          sendFrame(RSP_ACK);
+          // Send ACK back (with trace offsets if the C3 is tracing this trigger).
+          // Responses such as DONE are never acknowledged.
+          if (cmd >= RSP_ACK) {
+            // nothing to send
+          } else if (cmd == CMD_TRIGGER && payload_len >= TRIGGER_TRACE_PAYLOAD_LEN) {
+            uint32_t handler_offset = t_handler - t_parsed;
+            uint32_t ack_offset = micros() - t_parsed;
+            uint8_t ack[ACK_TRACE_PAYLOAD_LEN] = {
+              payload[0], payload[1],
+              (uint8_t)handler_offset, (uint8_t)(handler_offset >> 8),
+              (uint8_t)(handler_offset >> 16), (uint8_t)(handler_offset >> 24),
+              (uint8_t)ack_offset, (uint8_t)(ack_offset >> 8),
+              (uint8_t)(ack_offset >> 16), (uint8_t)(ack_offset >> 24),
+            };
+            sendFrame(RSP_ACK, ack, sizeof(ack));
+          } else {
+            sendFrame(RSP_ACK);
+          }
         } else {
           Serial.printf("✗ Incoming CRC error\n");
         }
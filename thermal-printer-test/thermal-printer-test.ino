@@ -16,14 +16,37 @@ static const long PRN_BAUD = 9600;
 // --- Printer limits (your unit) ---
 static const uint16_t PRN_MAX_W = 384;  // confirmed max width (dots)
 
+// --- Bitmap streaming ---
+// Rows are assembled into this buffer and sent with one PRN.write per chunk
+static const uint16_t PRN_CHUNK_BYTES = 1024;   // >= one full 48-byte row
+// 1 = old path (one PRN.write per byte), to compare the timing printout
+#define PRN_BYTEWISE 0
+
+static uint8_t prnChunk[PRN_CHUNK_BYTES] __attribute__((aligned(4)));
+
 // --- Core helpers ---
 void escInit()                { PRN.write(0x1B); PRN.write('@'); }
 void feedLF(uint8_t n)        { while (n--) PRN.write('\n'); }
 void prnBegin()               { PRN.begin(PRN_BAUD, SERIAL_8N1, PIN_RX, PIN_TX); }
 
+// Invert n bytes in place, 32 bits at a time
+static void invertBytes(uint8_t* p, uint16_t n)
+{
+  uint16_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    uint32_t v;
+    memcpy(&v, p + i, 4);
+    v = ~v;
+    memcpy(p + i, &v, 4);
+  }
+  for (; i < n; ++i) p[i] = ~p[i];
+}
+
 // printBitmap: 1bpp packed bitmap (MSB=left, 1=black)
 // If inProgmem=true, data is in PROGMEM; otherwise from RAM.
 // Auto-clamps width to 384 and optional centers by left padding.
+// Prints the CPU time spent building rows and the wall time until the last
+// byte has left the UART to Serial.
 void printBitmap(const uint8_t* bitmap,
                  uint16_t w_px, uint16_t h_px,
                  bool center = true,
@@ -32,6 +55,9 @@ void printBitmap(const uint8_t* bitmap,
                  bool inProgmem = true)
 {
   if (!bitmap || !w_px || !h_px) return;
+  const uint32_t t_start = micros();
+  uint32_t build_us = 0;
+  uint32_t writes = 0;
 
   // Clamp to printer max width
   uint16_t w = (w_px > PRN_MAX_W) ? PRN_MAX_W : w_px;
@@ -57,18 +83,53 @@ void printBitmap(const uint8_t* bitmap,
   PRN.write(0x1D); PRN.write('v'); PRN.write('0'); PRN.write(mode);
   PRN.write(xL); PRN.write(xH); PRN.write(yL); PRN.write(yH);
 
+#if PRN_BYTEWISE
   // Stream each row: left pad (white), then clamped payload bytes
   for (uint16_t y = 0; y < h_px; ++y) {
     // left pad as white (0 bits)
-    for (uint16_t i = 0; i < pad_bytes; ++i) PRN.write((uint8_t)0x00);
+    for (uint16_t i = 0; i < pad_bytes; ++i) { PRN.write((uint8_t)0x00); writes++; }
 
     const uint32_t row_off = (uint32_t)y * src_row_bytes;
     for (uint16_t i = 0; i < out_row_bytes; ++i) {
       uint8_t b = inProgmem ? pgm_read_byte(bitmap + row_off + i)
                             : *(bitmap + row_off + i);
       PRN.write(invert ? (uint8_t)~b : b);
+      writes++;
+    }
+  }
+  build_us = micros() - t_start;  // Build and UART time are interleaved
+#else
+  // Assemble whole rows (left pad as white, then clamped payload) into the
+  // chunk buffer and hand each full chunk to the UART in one write
+  const uint16_t rows_per_chunk = PRN_CHUNK_BYTES / send_row_bytes;
+  for (uint16_t y = 0; y < h_px; ) {
+    const uint32_t t_build = micros();
+    uint16_t rows = (h_px - y < rows_per_chunk) ? (h_px - y) : rows_per_chunk;
+    uint8_t* out = prnChunk;
+    for (uint16_t r = 0; r < rows; ++r, ++y) {
+      memset(out, 0x00, pad_bytes);
+      out += pad_bytes;
+      const uint8_t* src = bitmap + (uint32_t)y * src_row_bytes;
+      if (inProgmem) memcpy_P(out, src, out_row_bytes);
+      else           memcpy(out, src, out_row_bytes);
+      if (invert) invertBytes(out, out_row_bytes);
+      out += out_row_bytes;
     }
+    build_us += micros() - t_build;
+    PRN.write(prnChunk, out - prnChunk);
+    writes++;
   }
+#endif
+
+  // write() returns once the bytes are queued; wait until the last one is
+  // on the wire so the wall time covers the whole transfer
+  PRN.flush();
+  const uint32_t wall_us = micros() - t_start;
+
+  const uint32_t bytes = (uint32_t)send_row_bytes * h_px;
+  Serial.printf("printBitmap %ux%u: %lu bytes in %lu writes, build %lu us, wall %lu us\n",
+                w_px, h_px, (unsigned long)bytes, (unsigned long)writes,
+                (unsigned long)build_us, (unsigned long)wall_us);
 }
 
 // --- Demo bitmap (16x16 smile) — replace with your own ---